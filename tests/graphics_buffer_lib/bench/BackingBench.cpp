@@ -0,0 +1,210 @@
+/**
+ * @file BackingBench.cpp
+ * @brief TLB and memcpy cost of the BackingFlags options
+ * 
+ * Allocates 4K RGBA_8888 and 8K RAW16 buffers from GrallocAllocator with
+ * each combination of HUGE_PAGES and GUARD_PAGES, then times, per
+ * backing:
+ * - first touch: writing every page of a fresh buffer (page faults)
+ * - memcpy: copying one buffer into another of the same backing
+ * - page walk: dependent loads, one per 4KB page in random order, so
+ *   nearly every load needs a new TLB entry; huge pages cover 512 of
+ *   them with one entry
+ * The huge column is the part of the mapping the kernel actually backs
+ * with PMD pages (from /proc/self/smaps); 0 means the system fell back
+ * to small pages. Times are the median of five runs.
+ * 
+ * Build from tests/graphics_buffer_lib, against the full library:
+ * @code
+ * g++ -std=c++17 -O2 -Iinclude -Isrc bench/BackingBench.cpp src/[A-Z]*.cpp \
+ *     -luring -lpthread -o backing_bench
+ * @endcode
+ */
+
+#include "GrallocAllocator.h"
+#include "GraphicBuffer.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace android::graphics;
+
+namespace {
+
+constexpr int kRuns = 5;
+constexpr size_t kPageSize = 4096;
+constexpr size_t kWalkLoads = 1u << 20;
+
+struct Shape {
+    const char* name;
+    uint32_t width;
+    uint32_t height;
+    PixelFormat format;
+};
+
+const Shape kShapes[] = {
+    {"4K RGBA_8888", 3840, 2160, PixelFormat::RGBA_8888},
+    {"8K RAW16", 7680, 4320, PixelFormat::RAW16},
+};
+
+struct Backing {
+    const char* name;
+    BackingFlags flags;
+};
+
+const Backing kBackings[] = {
+    {"default", BackingFlags::NONE},
+    {"huge", BackingFlags::HUGE_PAGES},
+    {"guard", BackingFlags::GUARD_PAGES},
+    {"huge+guard", BackingFlags::HUGE_PAGES | BackingFlags::GUARD_PAGES},
+};
+
+/**
+ * A locked buffer from the allocator
+ */
+struct Mapped {
+    std::unique_ptr<GraphicBuffer> buffer;
+    MappedRegion region;
+    
+    ~Mapped() {
+        if (buffer && region.isLocked()) {
+            buffer->unlock();
+        }
+    }
+    
+    uint8_t* data() const { return static_cast<uint8_t*>(region.data); }
+};
+
+bool allocateMapped(GrallocAllocator& allocator, const Shape& shape, BackingFlags flags,
+                    Mapped& out) {
+    BufferDescriptor desc;
+    desc.width = shape.width;
+    desc.height = shape.height;
+    desc.format = shape.format;
+    desc.usage = BufferUsage::CPU_READ_OFTEN | BufferUsage::CPU_WRITE_OFTEN;
+    desc.backing = flags;
+    if (allocator.allocate(desc, out.buffer) != AllocationStatus::SUCCESS || !out.buffer) {
+        return false;
+    }
+    return out.buffer->lockForWrite(out.region) && out.region.data && out.region.size > 0;
+}
+
+template <typename Fn>
+double medianMs(Fn&& fn) {
+    std::vector<double> times;
+    for (int run = 0; run < kRuns; ++run) {
+        auto start = std::chrono::steady_clock::now();
+        fn(run);
+        std::chrono::duration<double, std::milli> elapsed =
+            std::chrono::steady_clock::now() - start;
+        times.push_back(elapsed.count());
+    }
+    std::sort(times.begin(), times.end());
+    return times[kRuns / 2];
+}
+
+// KB of the mapping holding data that smaps reports as PMD-mapped
+size_t hugeKb(const void* data) {
+    uintptr_t address = reinterpret_cast<uintptr_t>(data);
+    std::ifstream smaps("/proc/self/smaps");
+    std::string line;
+    bool inside = false;
+    size_t kb = 0;
+    while (std::getline(smaps, line)) {
+        unsigned long start = 0;
+        unsigned long end = 0;
+        if (std::sscanf(line.c_str(), "%lx-%lx ", &start, &end) == 2 && line.find(':') > 8) {
+            inside = address >= start && address < end;
+            continue;
+        }
+        if (!inside) {
+            continue;
+        }
+        const char* fields[] = {"AnonHugePages:", "ShmemPmdMapped:", "FilePmdMapped:"};
+        for (const char* field : fields) {
+            if (line.compare(0, std::strlen(field), field) == 0) {
+                kb += std::strtoul(line.c_str() + std::strlen(field), nullptr, 10);
+            }
+        }
+    }
+    return kb;
+}
+
+// Link one slot per page into a random cycle; returns ns per load
+double pageWalkNs(uint8_t* data, size_t size) {
+    size_t pages = size / kPageSize;
+    std::vector<size_t> order(pages);
+    for (size_t i = 0; i < pages; ++i) {
+        order[i] = i;
+    }
+    std::shuffle(order.begin(), order.end(), std::mt19937(42));
+    for (size_t i = 0; i < pages; ++i) {
+        uint8_t* slot = data + order[i] * kPageSize;
+        uint8_t* next = data + order[(i + 1) % pages] * kPageSize;
+        std::memcpy(slot, &next, sizeof(next));
+    }
+    
+    uint8_t* cursor = data + order[0] * kPageSize;
+    double ms = medianMs([&cursor](int) {
+        for (size_t i = 0; i < kWalkLoads; ++i) {
+            std::memcpy(&cursor, cursor, sizeof(cursor));
+        }
+    });
+    // Keep the chain live
+    volatile uint8_t sink = *cursor;
+    (void)sink;
+    return ms * 1e6 / kWalkLoads;
+}
+
+} // anonymous namespace
+
+int main() {
+    GrallocAllocator allocator;
+    BackingFlags supported = allocator.getSupportedBackingFlags();
+    
+    for (const Shape& shape : kShapes) {
+        std::printf("\n%s (%ux%u)\n%-12s %10s %12s %12s %12s\n", shape.name,
+                    shape.width, shape.height, "backing", "huge (KB)",
+                    "touch (ms)", "memcpy GB/s", "walk (ns)");
+        for (const Backing& backing : kBackings) {
+            std::printf("%-12s", backing.name);
+            if ((backing.flags & supported) != backing.flags) {
+                std::printf(" %10s\n", "unsupported");
+                continue;
+            }
+            
+            // A fresh buffer per run, since only the first write faults
+            std::vector<Mapped> fresh(kRuns);
+            for (Mapped& mapped : fresh) {
+                if (!allocateMapped(allocator, shape, backing.flags, mapped)) {
+                    std::printf(" %10s\n", "failed");
+                    return 1;
+                }
+            }
+            double touchMs = medianMs([&fresh](int run) {
+                uint8_t* data = fresh[run].data();
+                for (size_t offset = 0; offset < fresh[run].region.size; offset += kPageSize) {
+                    data[offset] = 1;
+                }
+            });
+            
+            Mapped& src = fresh[0];
+            Mapped& dst = fresh[1];
+            size_t size = std::min(src.region.size, dst.region.size);
+            std::memset(src.data(), 0x5a, size);
+            double copyMs = medianMs([&](int) {
+                std::memcpy(dst.data(), src.data(), size);
+            });
+            
+            std::printf(" %10zu %12.2f %12.2f %12.1f\n", hugeKb(src.data()), touchMs,
+                        size / (copyMs * 1e6), pageWalkNs(dst.data(), size));
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,174 @@
+/**
+ * @file ResizeBench.cpp
+ * @brief BufferMapper::resize() cost across resolutions and thread counts
+ * 
+ * The first tables time thumbnail-style downscales from 720p, 1080p and
+ * 4K for RGBA_8888 and NV21 at each SIMD level on the shared pool. The
+ * last one runs the largest cases on pools of 1 to 8 workers (the
+ * calling thread helps too) at the best SIMD level. Times are the median
+ * of five runs, in ms per frame.
+ * 
+ * Build from tests/graphics_buffer_lib:
+ * @code
+ * g++ -std=c++17 -O2 -Iinclude -Isrc bench/ResizeBench.cpp \
+ *     src/FormatConverter*.cpp src/BufferMapper*.cpp src/ResizeKernelsX86.cpp \
+ *     src/ValidateKernelsX86.cpp src/RawPacking*.cpp src/CpuFeatures.cpp \
+ *     src/GraphicBuffer.cpp src/BufferPool.cpp src/Fence*.cpp \
+ *     src/WorkStealingPool.cpp -lpthread -o resize_bench
+ * @endcode
+ */
+
+#include "BufferMapper.h"
+#include "CpuFeatures.h"
+#include "WorkStealingPool.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <thread>
+#include <vector>
+
+using namespace android::graphics;
+
+namespace {
+
+constexpr int kRuns = 5;
+constexpr int kFramesPerRun = 20;
+
+struct ResizeCase {
+    const char* name;
+    uint32_t srcWidth;
+    uint32_t srcHeight;
+    uint32_t dstWidth;
+    uint32_t dstHeight;
+    ResizeFilter filter;
+};
+
+const ResizeCase kCases[] = {
+    {"720p->360p box (2x)", 1280, 720, 640, 360, ResizeFilter::BOX},
+    {"720p->320x180 bilinear", 1280, 720, 320, 180, ResizeFilter::BILINEAR},
+    {"1080p->270p box (4x)", 1920, 1080, 480, 270, ResizeFilter::BOX},
+    {"1080p->320x180 box", 1920, 1080, 320, 180, ResizeFilter::BOX},
+    {"1080p->320x180 bilinear", 1920, 1080, 320, 180, ResizeFilter::BILINEAR},
+    {"4K->540p box (4x)", 3840, 2160, 960, 540, ResizeFilter::BOX},
+    {"4K->640x360 bilinear", 3840, 2160, 640, 360, ResizeFilter::BILINEAR},
+};
+
+const SimdLevel kLevels[] = {SimdLevel::SCALAR, SimdLevel::SSE4_1, SimdLevel::AVX2};
+const uint32_t kWorkerCounts[] = {1, 2, 4, 8};
+
+struct Images {
+    BufferDescriptor srcDesc;
+    BufferDescriptor dstDesc;
+    std::vector<uint8_t> src;
+    std::vector<uint8_t> dst;
+};
+
+BufferDescriptor imageDescriptor(PixelFormat format, uint32_t width, uint32_t height) {
+    BufferDescriptor desc;
+    desc.width = width;
+    desc.height = height;
+    desc.stride = width;
+    desc.format = format;
+    desc.usage = BufferUsage::CPU_READ_OFTEN | BufferUsage::CPU_WRITE_OFTEN;
+    return desc;
+}
+
+Images makeImages(PixelFormat format, const ResizeCase& resizeCase) {
+    Images images;
+    images.srcDesc = imageDescriptor(format, resizeCase.srcWidth, resizeCase.srcHeight);
+    images.dstDesc = imageDescriptor(format, resizeCase.dstWidth, resizeCase.dstHeight);
+    images.src.resize(images.srcDesc.calculateSize());
+    images.dst.resize(images.dstDesc.calculateSize());
+    for (size_t i = 0; i < images.src.size(); ++i) {
+        images.src[i] = static_cast<uint8_t>(i * 13 + (i >> 9));
+    }
+    return images;
+}
+
+// Median ms per frame, or a negative value if a resize failed
+double measure(Images& images, ResizeFilter filter, WorkStealingPool* pool) {
+    std::vector<double> times;
+    for (int run = 0; run < kRuns; ++run) {
+        auto start = std::chrono::steady_clock::now();
+        for (int frame = 0; frame < kFramesPerRun; ++frame) {
+            if (!BufferMapper::resize(images.src.data(), images.srcDesc,
+                                      images.dst.data(), images.dstDesc, filter, pool)) {
+                return -1.0;
+            }
+        }
+        std::chrono::duration<double, std::milli> elapsed =
+            std::chrono::steady_clock::now() - start;
+        times.push_back(elapsed.count() / kFramesPerRun);
+    }
+    std::sort(times.begin(), times.end());
+    return times[kRuns / 2];
+}
+
+void printTime(double ms) {
+    if (ms < 0) {
+        std::printf(" %9s", "failed");
+    } else {
+        std::printf(" %9.3f", ms);
+    }
+}
+
+const char* formatName(PixelFormat format) {
+    return format == PixelFormat::NV21 ? "NV21" : "RGBA_8888";
+}
+
+} // anonymous namespace
+
+int main() {
+    const PixelFormat formats[] = {PixelFormat::RGBA_8888, PixelFormat::NV21};
+    
+    std::printf("%u hardware threads, shared pool has %u workers\n",
+                std::thread::hardware_concurrency(),
+                WorkStealingPool::getShared().getThreadCount());
+    
+    for (PixelFormat format : formats) {
+        std::printf("\n%s, ms per frame\n%-26s %9s %9s %9s\n",
+                    formatName(format), "case", "scalar", "sse4.1", "avx2");
+        for (const ResizeCase& resizeCase : kCases) {
+            Images images = makeImages(format, resizeCase);
+            std::printf("%-26s", resizeCase.name);
+            for (SimdLevel level : kLevels) {
+                CpuFeatures::setMaxSimdLevel(level);
+                if (CpuFeatures::getSimdLevel() != level) {
+                    std::printf(" %9s", "n/a");
+                    continue;
+                }
+                printTime(measure(images, resizeCase.filter, nullptr));
+            }
+            std::printf("\n");
+        }
+    }
+    
+    // Thread scaling at the best level the CPU has
+    CpuFeatures::setMaxSimdLevel(SimdLevel::AVX2);
+    std::vector<std::unique_ptr<WorkStealingPool>> pools;
+    for (uint32_t workers : kWorkerCounts) {
+        pools.push_back(std::make_unique<WorkStealingPool>(workers));
+    }
+    
+    std::printf("\nThread scaling (%s), ms per frame\n%-36s",
+                CpuFeatures::toString(CpuFeatures::getSimdLevel()), "case");
+    for (uint32_t workers : kWorkerCounts) {
+        std::printf(" %6u+1", workers);
+    }
+    std::printf("\n");
+    for (PixelFormat format : formats) {
+        for (const ResizeCase& resizeCase : kCases) {
+            if (resizeCase.srcWidth < 1920) {
+                continue;
+            }
+            Images images = makeImages(format, resizeCase);
+            std::printf("%-10s %-25s", formatName(format), resizeCase.name);
+            for (auto& pool : pools) {
+                printTime(measure(images, resizeCase.filter, pool.get()));
+            }
+            std::printf("\n");
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,97 @@
+/**
+ * @file WaitMultipleBench.cpp
+ * @brief FenceManager::waitMultiple() cost against a per-fence poll loop
+ * 
+ * For 1 to 64 fences, times one zero-timeout check of the whole set:
+ * - any: waitMultiple(waitAll = false) with only the last fence
+ *   signaled, the worst case for a scan in order
+ * - all: waitMultiple(waitAll = true) with every fence signaled
+ * - loop: Fence::wait(0) on each fence in turn, one poll() apiece, which
+ *   is how waitAll used to wait before it shared one ppoll()
+ * Times are the median of five runs, in us per check.
+ * 
+ * Build from tests/graphics_buffer_lib:
+ * @code
+ * g++ -std=c++17 -O2 -Iinclude -Isrc bench/WaitMultipleBench.cpp \
+ *     src/FormatConverter*.cpp src/BufferMapper*.cpp src/ResizeKernelsX86.cpp \
+ *     src/ValidateKernelsX86.cpp src/RawPacking*.cpp src/CpuFeatures.cpp \
+ *     src/GraphicBuffer.cpp src/BufferPool.cpp src/Fence*.cpp \
+ *     src/WorkStealingPool.cpp -lpthread -o wait_multiple_bench
+ * @endcode
+ */
+
+#include "FenceManager.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <vector>
+
+using namespace android::graphics;
+
+namespace {
+
+constexpr int kRuns = 5;
+constexpr int kChecksPerRun = 5000;
+constexpr size_t kMaxFences = 64;
+
+template <typename Fn>
+double medianUs(Fn&& fn) {
+    std::vector<double> times;
+    for (int run = 0; run < kRuns; ++run) {
+        auto start = std::chrono::steady_clock::now();
+        for (int check = 0; check < kChecksPerRun; ++check) {
+            fn();
+        }
+        std::chrono::duration<double, std::micro> elapsed =
+            std::chrono::steady_clock::now() - start;
+        times.push_back(elapsed.count() / kChecksPerRun);
+    }
+    std::sort(times.begin(), times.end());
+    return times[kRuns / 2];
+}
+
+std::vector<Fence*> pointers(std::vector<Fence>& fences, size_t count) {
+    std::vector<Fence*> result;
+    for (size_t i = 0; i < count; ++i) {
+        result.push_back(&fences[i]);
+    }
+    return result;
+}
+
+} // anonymous namespace
+
+int main() {
+    FenceManager manager;
+    
+    std::vector<Fence> signaled;
+    std::vector<Fence> pending;
+    for (size_t i = 0; i < kMaxFences; ++i) {
+        signaled.push_back(manager.createFence("layer"));
+        manager.signalFence(signaled.back());
+        pending.push_back(manager.createFence("pending"));
+    }
+    
+    std::printf("%6s %10s %10s %10s\n", "fences", "any (us)", "all (us)", "loop (us)");
+    for (size_t count = 1; count <= kMaxFences; count *= 2) {
+        std::vector<Fence*> all = pointers(signaled, count);
+        std::vector<Fence*> any = pointers(pending, count - 1);
+        any.push_back(&signaled[count - 1]);
+        
+        int bad = 0;
+        double anyUs = medianUs([&] {
+            bad += manager.waitMultiple(any, false, 0) != int(count - 1);
+        });
+        double allUs = medianUs([&] {
+            bad += manager.waitMultiple(all, true, 0) < 0;
+        });
+        double loopUs = medianUs([&] {
+            for (Fence* fence : all) {
+                bad += !fence->wait(0);
+            }
+        });
+        
+        std::printf("%6zu %10.2f %10.2f %10.2f%s\n", count, anyUs, allUs, loopUs,
+                    bad ? "  (unexpected results)" : "");
+    }
+    return 0;
+}
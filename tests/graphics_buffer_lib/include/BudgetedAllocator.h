@@ -0,0 +1,193 @@
+/**
+ * @file BudgetedAllocator.h
+ * @brief Memory-budget enforcing allocator decorator
+ * 
+ * Wraps any IBufferAllocator and enforces a global byte budget across
+ * every pool that allocates through it, shrinking pools under pressure
+ * instead of letting multi-stream load run the process out of memory.
+ */
+
+#pragma once
+
+#include "IBufferAllocator.h"
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <vector>
+#include <unordered_map>
+
+namespace android {
+namespace graphics {
+
+/**
+ * @brief Configuration for the memory budget
+ */
+struct MemoryBudgetConfig {
+    size_t budgetBytes = 256 * 1024 * 1024;  ///< Max bytes in live buffers
+    uint32_t deferTimeoutMs = 0;             ///< Sync wait for frees (0 = reject)
+    size_t maxDeferredRequests = 16;         ///< Async requests parked over budget
+};
+
+/**
+ * @brief Budget usage statistics
+ */
+struct MemoryBudgetStatistics {
+    size_t budgetBytes = 0;
+    size_t usedBytes = 0;          ///< Live buffers plus in-flight reservations
+    size_t cachedBytes = 0;        ///< Held in the wrapped allocator's caches
+    size_t peakUsedBytes = 0;      ///< Peak of used plus cached
+    size_t deferredRequests = 0;
+    uint64_t rejectedCount = 0;
+    uint64_t deferredCount = 0;
+    uint64_t pressureEvents = 0;
+    size_t reclaimedBytes = 0;
+};
+
+/**
+ * @brief IBufferAllocator decorator that enforces a memory budget
+ * 
+ * Features:
+ * - Tracks bytes of every live buffer across all pools, as actually
+ *   reserved by the wrapped allocator (page and huge-page rounding)
+ * - Counts the wrapped allocator's warm caches against the budget
+ * - Owns the wrapped allocator's buffers (setBufferOwner()), so their
+ *   frees are accounted without touching GraphicBuffer internals
+ * - On pressure: releases allocator caches, then trims free buffers from
+ *   registered pools one at a time until the request fits
+ * - Synchronous requests over budget wait up to deferTimeoutMs, then fail
+ *   with ERROR_NO_MEMORY
+ * - Async requests over budget are parked and submitted as memory frees;
+ *   ones larger than the whole budget fail at once with ERROR_NO_MEMORY
+ * 
+ * Usage:
+ * @code
+ * auto inner = AllocatorFactory::createDefault();
+ * MemoryBudgetConfig budget;
+ * budget.budgetBytes = 128 * 1024 * 1024;
+ * auto allocator = std::make_shared<BudgetedAllocator>(std::move(inner), budget);
+ * 
+ * // Pools register themselves and are shrunk when the budget is tight
+ * BufferPool preview(allocator, previewDesc);
+ * BufferPool video(allocator, videoDesc);
+ * @endcode
+ * 
+ * Thread Safety:
+ * - All public methods are thread-safe
+ * - Pools are shrunk without holding the budget lock
+ */
+class BudgetedAllocator : public IBufferAllocator {
+public:
+    /**
+     * @brief Wrap an allocator with a memory budget
+     * @param inner Allocator that performs the actual allocations
+     * @param config Budget configuration
+     */
+    BudgetedAllocator(
+        std::shared_ptr<IBufferAllocator> inner,
+        const MemoryBudgetConfig& config = MemoryBudgetConfig()
+    );
+    
+    ~BudgetedAllocator() override;
+    
+    // IBufferAllocator implementation
+    AllocationStatus allocate(
+        const BufferDescriptor& descriptor,
+        std::unique_ptr<GraphicBuffer>& outBuffer
+    ) override;
+    
+    AllocationStatus allocateBatch(
+        const BufferDescriptor& descriptor,
+        uint32_t count,
+        std::vector<std::unique_ptr<GraphicBuffer>>& outBuffers
+    ) override;
+    
+    void allocateAsync(
+        const BufferDescriptor& descriptor,
+        AllocationCallback callback
+    ) override;
+    
+    void free(GraphicBuffer* buffer) override;
+    
+    AllocationStatus importBuffer(
+        const NativeHandle& handle,
+        const BufferDescriptor& descriptor,
+        std::unique_ptr<GraphicBuffer>& outBuffer
+    ) override;
+    
+    BufferUsage getSupportedUsage() const override;
+    
+    bool isFormatSupported(
+        PixelFormat format,
+        BufferUsage usage
+    ) const override;
+    
+    BackingFlags getSupportedBackingFlags() const override;
+    
+    bool lockHandle(
+        const NativeHandle& handle,
+        BufferUsage usage,
+        void** outData
+    ) override;
+    
+    bool unlockHandle(const NativeHandle& handle) override;
+    
+    void registerPool(BufferPool* pool) override;
+    void unregisterPool(BufferPool* pool) override;
+    size_t releaseCachedMemory() override;
+    
+    const char* getName() const override { return "BudgetedAllocator"; }
+    
+    /**
+     * @brief Change the budget at runtime
+     * 
+     * Lowering the budget below current usage triggers pool shrinking.
+     */
+    void setBudget(size_t budgetBytes);
+    
+    /**
+     * @brief Get budget usage statistics
+     */
+    MemoryBudgetStatistics getStatistics() const;
+    
+    /**
+     * @brief Dump budget state for debugging
+     */
+    std::string dumpState() const;
+
+private:
+    struct DeferredRequest {
+        BufferDescriptor descriptor;
+        size_t size = 0;
+        AllocationCallback callback;
+    };
+    
+    std::shared_ptr<IBufferAllocator> inner_;
+    MemoryBudgetConfig config_;
+    
+    // Budget accounting
+    size_t usedBytes_ = 0;       // Live buffers plus in-flight reservations (excl. caches)
+    std::unordered_map<uint64_t, size_t> charges_;
+    std::deque<DeferredRequest> deferred_;
+    size_t asyncInFlight_ = 0;
+    MemoryBudgetStatistics stats_;
+    mutable std::mutex budgetMutex_;
+    std::condition_variable bytesFreed_;
+    
+    // Pools that may be shrunk under pressure
+    std::vector<BufferPool*> pools_;
+    std::mutex poolsMutex_;
+    
+    size_t estimateSize(const BufferDescriptor& descriptor) const;
+    size_t getFootprintLocked() const;
+    bool tryReserve(size_t size);
+    bool hasRoom(size_t size) const;
+    void unreserve(size_t size);
+    void charge(const GraphicBuffer& buffer, size_t reserved);
+    void relievePressure(size_t neededBytes);
+    void submitDeferred();
+    void submitAsync(DeferredRequest&& request);
+};
+
+} // namespace graphics
+} // namespace android
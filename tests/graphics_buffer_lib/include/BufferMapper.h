@@ -9,12 +9,17 @@
 
 #include "BufferTypes.h"
 #include "GraphicBuffer.h"
+#include "ImageView.h"
 #include <memory>
 #include <functional>
 
 namespace android {
 namespace graphics {
 
+// Forward declarations
+class WorkStealingPool;
+class BufferPool;
+
 /**
  * @brief RAII lock guard for buffer CPU access
  * 
@@ -29,6 +34,9 @@ namespace graphics {
  *     }
  * } // Automatically unlocked here
  * @endcode
+ * 
+ * getImageView() describes the same mapping with its plane geometry,
+ * so frames can be walked in place without recomputing offsets.
  */
 class BufferLockGuard {
 public:
@@ -91,6 +99,18 @@ public:
      */
     size_t getSize() const { return region_.size; }
     
+    /**
+     * @brief Get a view of every plane of the locked pixels
+     * 
+     * For a region lock the view covers the locked rectangle (chroma
+     * planes included); RAW10/RAW12 regions must start on a packed
+     * pixel group.
+     * 
+     * @return Empty view if not locked or the layout is unknown
+     */
+    ImageView getImageView();
+    ConstImageView getImageView() const;
+    
     /**
      * @brief Manually unlock before destruction
      */
@@ -99,7 +119,82 @@ public:
 private:
     GraphicBuffer* buffer_;
     MappedRegion region_;
+    Rect rect_;          // Locked rectangle (empty for a full lock)
     bool locked_;
+    
+    ImageView makeImageView() const;
+};
+
+/**
+ * @brief One tile handed to a processBufferTiled() callback
+ * 
+ * Coordinates are in pixels of the first plane (luma for YUV). For YUV
+ * formats y and height are even, so the tile owns chroma rows y / 2 up
+ * to (y + height) / 2; use base with getPlaneLayouts() to reach them.
+ */
+struct BufferTile {
+    uint8_t* data = nullptr;     ///< First pixel of the tile in plane 0
+    uint8_t* base = nullptr;     ///< Start of the mapping
+    size_t rowStride = 0;        ///< Bytes between rows of plane 0
+    uint32_t x = 0;
+    uint32_t y = 0;
+    uint32_t width = 0;
+    uint32_t height = 0;
+    uint32_t index = 0;          ///< Tile number in row-major order
+};
+
+/**
+ * @brief Tiling options for processBufferTiled()
+ */
+struct TileConfig {
+    uint32_t tileWidth = 0;                  ///< Pixels (0 = full-width row bands)
+    uint32_t tileHeight = 0;                 ///< Rows (0 = sized by targetTileBytes)
+    size_t targetTileBytes = 256 * 1024;     ///< Per-tile working set (L2 share)
+    WorkStealingPool* pool = nullptr;        ///< Pool to run on (nullptr = shared)
+};
+
+/**
+ * @brief 8-bit RGBA color used by the fill and pattern helpers
+ */
+struct Color {
+    uint8_t r = 0;
+    uint8_t g = 0;
+    uint8_t b = 0;
+    uint8_t a = 0xFF;
+};
+
+/**
+ * @brief Test patterns generated by fillPattern()
+ */
+enum class TestPattern {
+    COLOR_BARS,     ///< Eight 75% vertical bars (white to black)
+    GRADIENT,       ///< Horizontal gray ramp, black to white
+    CHECKERBOARD    ///< 32x32 black and white squares
+};
+
+/**
+ * @brief Sampling filter used by BufferMapper::resize()
+ */
+enum class ResizeFilter {
+    BOX,            ///< Area average (best for thumbnails)
+    BILINEAR        ///< Two-tap interpolation, pixel-center aligned
+};
+
+/**
+ * @brief Result of BufferMapper::diff()
+ * 
+ * Samples are bytes for 8-bit formats and pixels for RAW10/12/16.
+ */
+struct BufferDiff {
+    uint64_t samples = 0;        ///< Samples compared
+    uint64_t sad = 0;            ///< Sum of absolute differences
+    uint64_t sse = 0;            ///< Sum of squared differences
+    uint32_t maxDiff = 0;        ///< Largest absolute sample difference
+    uint32_t peak = 0;           ///< Largest sample value of the format
+    double mse = 0.0;            ///< sse / samples
+    double psnr = 0.0;           ///< dB (infinity when identical)
+    
+    bool isIdentical() const { return sad == 0; }
 };
 
 /**
@@ -143,6 +238,50 @@ public:
      */
     static bool fillBuffer(GraphicBuffer* buffer, uint8_t value);
     
+    /**
+     * @brief Fill every pixel with a color
+     * 
+     * The color is encoded for the buffer format: RGB layouts store it
+     * directly, YUV formats use BT.601 limited range, and RAW formats
+     * store its luminance scaled to the sample depth. Only visible
+     * pixels are written; stride padding is left untouched.
+     * 
+     * @param buffer Buffer to fill
+     * @param color Fill color
+     * @return True on success (false for BLOB and opaque formats)
+     */
+    static bool fillColor(GraphicBuffer* buffer, const Color& color);
+    
+    /**
+     * @brief Fill a YUV buffer with per-plane constants
+     * @param buffer NV21, NV12 or YV12 buffer
+     * @param y Luma value
+     * @param cb Blue-difference chroma value
+     * @param cr Red-difference chroma value
+     * @return True on success
+     */
+    static bool fillYuv(GraphicBuffer* buffer, uint8_t y, uint8_t cb, uint8_t cr);
+    
+    /**
+     * @brief Fill a RAW buffer with one sample value
+     * @param buffer RAW10, RAW12 or RAW16 buffer
+     * @param sample Sample value, clamped to the format's bit depth
+     * @return True on success
+     */
+    static bool fillRaw(GraphicBuffer* buffer, uint16_t sample);
+    
+    /**
+     * @brief Fill a buffer with a test pattern
+     * 
+     * Patterns are deterministic, so they double as benchmark inputs
+     * and as golden images for conversion checks.
+     * 
+     * @param buffer Buffer to fill
+     * @param pattern Pattern to draw
+     * @return True on success
+     */
+    static bool fillPattern(GraphicBuffer* buffer, TestPattern pattern);
+    
     /**
      * @brief Process buffer data with a callback
      * 
@@ -157,6 +296,280 @@ public:
         std::function<void(void* data, size_t size)> processor
     );
     
+    /**
+     * @brief Process buffer data in parallel tiles
+     * 
+     * Splits plane 0 into row bands (or tiles when tileWidth is set) and
+     * runs the processor for each on a work-stealing pool. Tile widths
+     * are rounded to whole cache lines so adjacent tiles never share one,
+     * and bands default to targetTileBytes so each stays cache resident.
+     * 
+     * @code
+     * BufferMapper::processBufferTiled(frame, [](const BufferTile& tile) {
+     *     for (uint32_t row = 0; row < tile.height; ++row) {
+     *         uint8_t* pixels = tile.data + row * tile.rowStride;
+     *         // Process tile.width pixels...
+     *     }
+     * });
+     * @endcode
+     * 
+     * @param buffer Buffer to process (locked read-write for the call)
+     * @param processor Callback, invoked concurrently for disjoint tiles
+     * @param config Tiling options
+     * @return True if every tile was processed
+     */
+    static bool processBufferTiled(
+        GraphicBuffer* buffer,
+        std::function<void(const BufferTile& tile)> processor,
+        const TileConfig& config = TileConfig()
+    );
+    
+    /**
+     * @brief Copy a rectangle out of a buffer
+     * 
+     * Only the pixels inside rect are read; stride padding is skipped.
+     * For YUV formats every plane is copied, rect must start on even
+     * coordinates, and dest is laid out like a buffer of rect's size
+     * with the given stride (see getPlaneLayouts). That stride must be
+     * even, so an odd-width rect needs an explicit destStride.
+     * 
+     * @param buffer Source buffer
+     * @param rect Region to copy
+     * @param dest Destination memory
+     * @param destStride Destination row stride in pixels (0 = rect.width)
+     * @return True on success
+     */
+    static bool copyRect(
+        GraphicBuffer* buffer,
+        const Rect& rect,
+        void* dest,
+        uint32_t destStride = 0
+    );
+    
+    /**
+     * @brief Copy CPU memory into a rectangle of a buffer
+     * @param src Source memory, laid out as described for copyRect()
+     * @param srcStride Source row stride in pixels (0 = rect.width)
+     * @param buffer Destination buffer
+     * @param rect Region to write
+     * @return True on success
+     */
+    static bool copyRect(
+        const void* src,
+        uint32_t srcStride,
+        GraphicBuffer* buffer,
+        const Rect& rect
+    );
+    
+    /**
+     * @brief Copy a rectangle between two buffers of the same format
+     * 
+     * @code
+     * // Crop the centre of a preview frame into a thumbnail buffer
+     * Rect crop{160, 120, 320, 240};
+     * BufferMapper::blit(preview, crop, thumbnail, 0, 0);
+     * @endcode
+     * 
+     * @param src Source buffer
+     * @param srcRect Region of src to copy
+     * @param dst Destination buffer (must differ from src)
+     * @param dstX Destination column
+     * @param dstY Destination row
+     * @return True on success
+     */
+    static bool blit(
+        GraphicBuffer* src,
+        const Rect& srcRect,
+        GraphicBuffer* dst,
+        uint32_t dstX,
+        uint32_t dstY
+    );
+    
+    /**
+     * @brief Copy a rectangle between already-mapped images
+     * 
+     * Both images must share a format and the regions must not overlap.
+     * Packed RAW10/RAW12 are rejected since pixels are not byte aligned,
+     * and YUV images with an odd stride since their chroma rows overlap.
+     * 
+     * @param src Start of the source image
+     * @param srcDesc Source geometry (stride must be resolved)
+     * @param srcRect Region of the source to copy
+     * @param dst Start of the destination image
+     * @param dstDesc Destination geometry (stride must be resolved)
+     * @param dstX Destination column
+     * @param dstY Destination row
+     * @return True on success
+     */
+    static bool blit(
+        const void* src,
+        const BufferDescriptor& srcDesc,
+        const Rect& srcRect,
+        void* dst,
+        const BufferDescriptor& dstDesc,
+        uint32_t dstX,
+        uint32_t dstY
+    );
+    
+    /**
+     * @brief Scale a buffer into another buffer of the same format
+     * 
+     * Supports RGBA_8888, RGBX_8888, BGRA_8888 and YUV 4:2:0 (NV21, NV12,
+     * YV12); chroma planes are scaled on their own. Exact 2x and 4x
+     * downscales take dedicated SIMD paths; other ratios run the general
+     * box or bilinear filter. Output row bands are spread over the shared
+     * WorkStealingPool.
+     * 
+     * @param src Source buffer
+     * @param dst Destination buffer (any size, same format as src)
+     * @param filter Sampling filter
+     * @return True on success
+     */
+    static bool resize(
+        GraphicBuffer* src,
+        GraphicBuffer* dst,
+        ResizeFilter filter = ResizeFilter::BOX
+    );
+    
+    /**
+     * @brief Scale between already-mapped images
+     * @param src Start of the source image
+     * @param srcDesc Source geometry (stride must be resolved)
+     * @param dst Start of the destination image
+     * @param dstDesc Destination geometry (stride must be resolved)
+     * @param filter Sampling filter
+     * @param pool Pool to run on (nullptr = shared)
+     * @return True on success
+     */
+    static bool resize(
+        const void* src,
+        const BufferDescriptor& srcDesc,
+        void* dst,
+        const BufferDescriptor& dstDesc,
+        ResizeFilter filter = ResizeFilter::BOX,
+        WorkStealingPool* pool = nullptr
+    );
+    
+    /**
+     * @brief Scale a buffer into a buffer acquired from a pool
+     * 
+     * Typical use is a preview thumbnail pool. The pool's descriptor sets
+     * the output size and must share the source format.
+     * 
+     * @code
+     * BufferPool thumbnails(allocator, thumbDesc);
+     * GraphicBuffer* thumb = BufferMapper::resizeInto(frame, thumbnails);
+     * if (thumb) {
+     *     // Use thumbnail...
+     *     thumbnails.releaseBuffer(thumb);
+     * }
+     * @endcode
+     * 
+     * @param src Source buffer
+     * @param pool Pool providing the destination buffer
+     * @param filter Sampling filter
+     * @return Acquired buffer holding the result, or nullptr (nothing is
+     *         held on failure)
+     */
+    static GraphicBuffer* resizeInto(
+        GraphicBuffer* src,
+        BufferPool& pool,
+        ResizeFilter filter = ResizeFilter::BOX
+    );
+    
+    /**
+     * @brief Compute a CRC32C over the visible pixels of a buffer
+     * 
+     * Row padding is skipped and planes are hashed in memory order, so
+     * a buffer without padding hashes like crc32c() over its mapping.
+     * Uses the SSE4.2 crc32 instruction when available.
+     * 
+     * @param buffer Buffer to hash
+     * @param[out] outCrc Checksum on success
+     * @return True on success
+     */
+    static bool checksum(GraphicBuffer* buffer, uint32_t& outCrc);
+    
+    /**
+     * @brief Compute a CRC32C over an already-mapped image
+     * @param data Start of the image
+     * @param descriptor Image geometry (stride must be resolved)
+     * @param[out] outCrc Checksum on success
+     * @return True on success
+     */
+    static bool checksum(
+        const void* data,
+        const BufferDescriptor& descriptor,
+        uint32_t& outCrc
+    );
+    
+    /**
+     * @brief CRC32C (Castagnoli) of a byte range
+     * @param data Bytes to hash
+     * @param size Number of bytes
+     * @param crc Result of a previous call to continue from (0 to start)
+     * @return Updated checksum
+     */
+    static uint32_t crc32c(const void* data, size_t size, uint32_t crc = 0);
+    
+    /**
+     * @brief Compare the visible pixels of two buffers
+     * 
+     * Both buffers must share format and dimensions; strides may differ.
+     * RAW10/RAW12 are compared as unpacked samples. RGB_565 is rejected
+     * since its bytes are not samples.
+     * 
+     * @param a First buffer
+     * @param b Second buffer
+     * @param[out] outDiff Difference statistics on success
+     * @return True on success
+     */
+    static bool diff(GraphicBuffer* a, GraphicBuffer* b, BufferDiff& outDiff);
+    
+    /**
+     * @brief Compare two already-mapped images
+     * @param a Start of the first image
+     * @param aDesc First image geometry (stride must be resolved)
+     * @param b Start of the second image
+     * @param bDesc Second image geometry (stride must be resolved)
+     * @param[out] outDiff Difference statistics on success
+     * @return True on success
+     */
+    static bool diff(
+        const void* a,
+        const BufferDescriptor& aDesc,
+        const void* b,
+        const BufferDescriptor& bDesc,
+        BufferDiff& outDiff
+    );
+    
+    /**
+     * @brief Copy rows between strided images
+     * 
+     * Large copies use non-temporal stores so the destination does not
+     * evict the working set from the cache.
+     * 
+     * @param src First source row
+     * @param srcStride Bytes between source rows
+     * @param dst First destination row
+     * @param dstStride Bytes between destination rows
+     * @param rowBytes Bytes to copy per row
+     * @param rows Number of rows
+     */
+    static void copyRows(
+        const void* src,
+        size_t srcStride,
+        void* dst,
+        size_t dstStride,
+        size_t rowBytes,
+        uint32_t rows
+    );
+    
+    static constexpr uint32_t kCacheLineSize = 64;
+    
+    /// Copies at least this large bypass the cache
+    static constexpr size_t kNonTemporalThreshold = 256 * 1024;
+    
     /**
      * @brief Calculate row stride for a format
      * @param format Pixel format
@@ -165,11 +578,71 @@ public:
      */
     static uint32_t calculateStride(PixelFormat format, uint32_t width);
     
+    /**
+     * @brief Calculate an aligned row stride for a format
+     * @param format Pixel format
+     * @param width Image width in pixels
+     * @param alignment Row alignment in bytes (0 or 1 = unaligned)
+     * @return Stride in pixels whose byte size is a multiple of alignment,
+     *         rounded to the format's FormatInfo::strideAlignment
+     */
+    static uint32_t calculateAlignedStride(
+        PixelFormat format,
+        uint32_t width,
+        uint32_t alignment
+    );
+    
     /**
      * @brief Get bytes per pixel for a format
+     * 
+     * RAW10/RAW12 report their unpacked 16-bit sample size; use
+     * getRowBytes() for the size of packed rows.
      */
     static uint32_t getBytesPerPixel(PixelFormat format);
     
+    /**
+     * @brief Get the bytes occupied by a run of pixels in plane 0
+     * 
+     * Exact for bit-packed formats: RAW10 stores 4 pixels in 5 bytes and
+     * RAW12 stores 2 pixels in 3 bytes, rounded up to whole groups.
+     * 
+     * @param format Pixel format
+     * @param width Pixels in the run
+     * @return Bytes for the run
+     */
+    static size_t getRowBytes(PixelFormat format, uint32_t width);
+    
+    static constexpr uint32_t kMaxPlanes = 3;
+    
+    /**
+     * @brief Describe where each plane of a buffer lives
+     * @param descriptor Buffer geometry (stride must be resolved)
+     * @param[out] outPlanes Array of at least kMaxPlanes entries
+     * @return Number of planes written (0 for unknown layouts)
+     */
+    static uint32_t getPlaneLayouts(
+        const BufferDescriptor& descriptor,
+        PlaneLayout* outPlanes
+    );
+    
+    /**
+     * @brief View a mapping of a buffer through its plane layouts
+     * @param data Start of the mapping
+     * @param descriptor Buffer geometry (stride must be resolved)
+     * @return Empty view if data is null or the layout is unknown
+     */
+    static ImageView getImageView(void* data, const BufferDescriptor& descriptor);
+    static ConstImageView getImageView(const void* data, const BufferDescriptor& descriptor);
+    
+    /**
+     * @brief Convert between pixel formats using the fastest kernel
+     * @param src Source buffer
+     * @param dst Destination buffer with the same dimensions
+     * @return True on success
+     * @see FormatConverter for the supported format pairs
+     */
+    static bool convertBuffer(GraphicBuffer* src, GraphicBuffer* dst);
+    
     /**
      * @brief Check if format is YUV-based
      */
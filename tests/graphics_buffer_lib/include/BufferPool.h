@@ -112,6 +112,10 @@ public:
     
     /**
      * @brief Pre-allocate additional buffers
+     * 
+     * Buffers the allocator could not provide are counted in
+     * PoolStatistics::failedAllocations along with the failure status.
+     * 
      * @param count Number of buffers to add
      * @return Number successfully allocated
      */
@@ -131,6 +135,14 @@ public:
      */
     bool flush(uint32_t timeoutMs = 5000);
     
+    /**
+     * @brief Allow or stop waiting in acquireBuffer() and flush()
+     * 
+     * While disabled they return at once instead of waiting, and threads
+     * already waiting are woken.
+     */
+    void setBlockingEnabled(bool enabled);
+    
     /**
      * @brief Get current pool statistics
      */
@@ -167,6 +179,9 @@ private:
     std::vector<BufferPoolListener*> listeners_;
     PoolStatistics stats_;
     
+    uint32_t pendingGrowth_ = 0;  // Buffers being allocated outside the lock
+    bool blockingEnabled_ = true;
+    
     void notifyBufferAcquired(GraphicBuffer* buffer);
     void notifyBufferReleased(GraphicBuffer* buffer);
     void notifyPoolGrew(uint32_t newTotal);
@@ -0,0 +1,144 @@
+/**
+ * @file BufferReserve.h
+ * @brief Warm reserve of native handles keyed by descriptor history
+ * 
+ * Camera stream reconfiguration tends to cycle through a small set of
+ * buffer shapes (preview, video, still). The reserve remembers recently
+ * allocated shapes and retains freed handles for them, so the next pool
+ * created for a known shape skips the cold HAL allocation.
+ */
+
+#pragma once
+
+#include "BufferTypes.h"
+#include <list>
+#include <vector>
+#include <mutex>
+
+namespace android {
+namespace graphics {
+
+/**
+ * @brief Limits for the warm buffer reserve
+ */
+struct BufferReserveConfig {
+    uint32_t maxShapes = 4;                  ///< Descriptors tracked in history
+    uint32_t maxBuffersPerShape = 8;         ///< Handles retained per descriptor
+    size_t maxBytes = 96 * 1024 * 1024;      ///< Total bytes held in reserve
+};
+
+/**
+ * @brief Reserve statistics for monitoring
+ */
+struct BufferReserveStatistics {
+    size_t trackedShapes = 0;
+    size_t reservedBuffers = 0;
+    size_t reservedBytes = 0;
+    uint64_t hits = 0;        ///< Allocations served from the reserve
+    uint64_t misses = 0;      ///< Allocations that went to the HAL
+    uint64_t retained = 0;    ///< Frees kept in the reserve
+    uint64_t evicted = 0;     ///< Handles released due to limits
+};
+
+/**
+ * @brief Descriptor-history predictor with a warm handle reserve
+ * 
+ * Features:
+ * - MRU history of recently allocated descriptors
+ * - Freed handles for tracked descriptors are retained, not released
+ * - Byte and per-shape limits bound the memory held in reserve
+ * - Shapes that fall out of history give their handles back
+ * 
+ * Thread Safety:
+ * - All public methods are thread-safe
+ * 
+ * The reserve never releases handles itself; any handle it gives up is
+ * returned to the caller, which owns the platform free.
+ * 
+ * @see GrallocAllocator for allocator integration
+ */
+class BufferReserve {
+public:
+    /**
+     * @brief Create a reserve with the given limits
+     */
+    explicit BufferReserve(const BufferReserveConfig& config = BufferReserveConfig());
+    
+    ~BufferReserve();
+    
+    // Non-copyable
+    BufferReserve(const BufferReserve&) = delete;
+    BufferReserve& operator=(const BufferReserve&) = delete;
+    
+    /**
+     * @brief Record that a descriptor was allocated
+     * @param descriptor Allocated buffer shape
+     * @param[out] outEvicted Handles released by shapes falling out of history
+     * @param bufferSize Bytes each handle of this shape holds (0 = descriptor size)
+     */
+    void recordAllocation(
+        const BufferDescriptor& descriptor,
+        std::vector<NativeHandle>& outEvicted,
+        size_t bufferSize = 0
+    );
+    
+    /**
+     * @brief Take a warm handle for a descriptor
+     * @param descriptor Required buffer shape
+     * @param[out] outHandle Reserved handle on success
+     * @return True if the reserve had a matching handle
+     */
+    bool take(const BufferDescriptor& descriptor, NativeHandle& outHandle);
+    
+    /**
+     * @brief Offer a freed handle to the reserve
+     * @param descriptor Shape of the freed buffer
+     * @param handle Handle being freed
+     * @return True if retained (caller must not release it)
+     */
+    bool offer(const BufferDescriptor& descriptor, const NativeHandle& handle);
+    
+    /**
+     * @brief Check whether a descriptor is in the recent history
+     */
+    bool isTracked(const BufferDescriptor& descriptor) const;
+    
+    /**
+     * @brief Get tracked descriptors, most recently used first
+     */
+    std::vector<BufferDescriptor> getPredictedShapes() const;
+    
+    /**
+     * @brief Drop every reserved handle (history is kept)
+     * @param[out] outReleased Handles the caller must release
+     * @return Bytes the dropped handles held
+     */
+    size_t trim(std::vector<NativeHandle>& outReleased);
+    
+    /**
+     * @brief Get reserve statistics
+     */
+    BufferReserveStatistics getStatistics() const;
+
+private:
+    struct Shape {
+        BufferDescriptor descriptor;
+        size_t bufferSize = 0;
+        std::vector<NativeHandle> handles;
+    };
+    
+    BufferReserveConfig config_;
+    
+    // MRU history (front = most recent)
+    std::list<Shape> shapes_;
+    size_t reservedBytes_ = 0;
+    
+    mutable std::mutex mutex_;
+    BufferReserveStatistics stats_;
+    
+    std::list<Shape>::iterator findShape(const BufferDescriptor& descriptor);
+    std::list<Shape>::const_iterator findShape(const BufferDescriptor& descriptor) const;
+};
+
+} // namespace graphics
+} // namespace android
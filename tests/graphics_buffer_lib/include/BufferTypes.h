@@ -66,6 +66,23 @@ inline BufferUsage operator&(BufferUsage a, BufferUsage b) {
     return static_cast<BufferUsage>(static_cast<uint64_t>(a) & static_cast<uint64_t>(b));
 }
 
+/**
+ * @brief Backing memory options (can be combined with bitwise OR)
+ */
+enum class BackingFlags : uint32_t {
+    NONE = 0,
+    HUGE_PAGES = 1u << 0,       ///< Back with 2MB pages where available
+    GUARD_PAGES = 1u << 1       ///< Surround the mapping with PROT_NONE pages
+};
+
+inline BackingFlags operator|(BackingFlags a, BackingFlags b) {
+    return static_cast<BackingFlags>(static_cast<uint32_t>(a) | static_cast<uint32_t>(b));
+}
+
+inline BackingFlags operator&(BackingFlags a, BackingFlags b) {
+    return static_cast<BackingFlags>(static_cast<uint32_t>(a) & static_cast<uint32_t>(b));
+}
+
 /**
  * @brief Buffer allocation status codes
  */
@@ -76,7 +93,9 @@ enum class AllocationStatus {
     ERROR_UNSUPPORTED_FORMAT,
     ERROR_GRALLOC_FAILURE,
     ERROR_DEVICE_LOST,
-    ERROR_PERMISSION_DENIED
+    ERROR_PERMISSION_DENIED,
+    ERROR_QUEUE_FULL,           // Async request rejected, queue at capacity
+    ERROR_CANCELLED             // Async request cancelled before it ran
 };
 
 /**
@@ -89,10 +108,15 @@ struct BufferDescriptor {
     PixelFormat format = PixelFormat::UNKNOWN;
     BufferUsage usage = BufferUsage::NONE;
     uint32_t layerCount = 1;
+    uint32_t rowAlignment = 0;                   ///< Row alignment in bytes (0 = none)
+    BackingFlags backing = BackingFlags::NONE;   ///< Backing memory options
     
     size_t calculateSize() const;
     bool isValid() const;
     std::string toString() const;
+    
+    bool operator==(const BufferDescriptor& other) const;
+    bool operator!=(const BufferDescriptor& other) const { return !(*this == other); }
 };
 
 /**
@@ -119,6 +143,33 @@ struct MappedRegion {
     bool isLocked() const { return data != nullptr; }
 };
 
+/**
+ * @brief Location of one image plane inside a buffer
+ * 
+ * Planes follow the android_ycbcr model: YUV formats always expose
+ * Y, Cb, Cr in that order, and semi-planar chroma is described by two
+ * planes with a sampleStride of 2 that point into the same bytes.
+ */
+struct PlaneLayout {
+    size_t offset = 0;          ///< Byte offset from the start of the buffer
+    uint32_t rowStride = 0;     ///< Bytes between rows
+    uint32_t sampleStride = 1;  ///< Bytes between adjacent samples (0 = bit-packed)
+    uint32_t width = 0;         ///< Samples per row
+    uint32_t height = 0;        ///< Rows
+};
+
+/**
+ * @brief Pixel rectangle within a buffer
+ */
+struct Rect {
+    uint32_t x = 0;
+    uint32_t y = 0;
+    uint32_t width = 0;
+    uint32_t height = 0;
+    
+    bool isEmpty() const { return width == 0 || height == 0; }
+};
+
 /**
  * @brief Statistics for buffer pool monitoring
  */
@@ -129,6 +180,8 @@ struct PoolStatistics {
     size_t peakAllocatedBytes = 0;
     uint64_t allocationCount = 0;
     uint64_t reuseCount = 0;
+    uint64_t failedAllocations = 0;    ///< Buffers grow() asked for but did not get
+    AllocationStatus lastFailure = AllocationStatus::SUCCESS;
     double hitRate = 0.0;
 };
 
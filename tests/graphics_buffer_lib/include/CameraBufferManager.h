@@ -11,6 +11,10 @@
 #include "BufferPool.h"
 #include "IBufferAllocator.h"
 #include "BufferTypes.h"
+#include "FenceManager.h"
+#include <atomic>
+#include <condition_variable>
+#include <deque>
 #include <map>
 #include <vector>
 #include <memory>
@@ -20,10 +24,10 @@ namespace android {
 namespace graphics {
 
 // Forward declarations
+class BufferRing;
 class StreamConfiguration;
 class CaptureRequest;
 class CaptureResult;
-class FenceManager;
 
 /**
  * @brief Stream types for camera buffer management
@@ -67,10 +71,12 @@ struct StreamConfiguration {
  * - Per-stream buffer allocation
  * - Stream reconfiguration
  * - Buffer queueing/dequeuing
- * - Fence synchronization
+ * - Fence synchronization with deferred, non-blocking release
  * 
  * Thread Safety:
  * - All public methods are thread-safe
+ * - dequeueBuffer() and releaseBuffer() take only per-stream locks;
+ *   queueBuffer() and acquireBuffer() take none
  * - Callbacks may be invoked from worker threads
  * 
  * @see BufferPool for underlying pool management
@@ -112,9 +118,19 @@ public:
     
     /**
      * @brief Reconfigure an existing stream
+     * 
+     * Fails while the producer or consumer still holds a buffer of the
+     * stream, since the old pool frees them all. The stream is
+     * unavailable while it is rebuilt: calls blocked in acquireBuffer(),
+     * dequeueBuffer() or dequeueBatch() are woken and fail, calls still
+     * using it on other threads are waited for, and queued buffers not
+     * yet acquired are dropped. Also waits, for a bounded time, for
+     * released buffers whose release fence is still pending before the
+     * old pool is freed.
+     * 
      * @param streamId Stream to reconfigure
      * @param newConfig New configuration
-     * @return True on success
+     * @return True on success; false keeps the old configuration
      */
     bool reconfigureStream(
         uint32_t streamId,
@@ -123,6 +139,11 @@ public:
     
     /**
      * @brief Remove a stream
+     * 
+     * Calls blocked in acquireBuffer(), dequeueBuffer() or dequeueBatch()
+     * are woken and fail; calls still using the stream on other threads
+     * are waited for before it is freed.
+     * 
      * @param streamId Stream to remove
      * @param waitForBuffers If true, wait for all buffers to be returned
      * @return True on success
@@ -131,6 +152,12 @@ public:
     
     /**
      * @brief Dequeue a buffer for a stream (producer side)
+     * 
+     * Prefers idle pool buffers and buffers whose release fence has
+     * signaled, then pool growth. Only then does it take a buffer still
+     * waiting on its release fence; that fence becomes the acquire fence
+     * (or is waited here when outFenceFd is null).
+     * 
      * @param streamId Target stream
      * @param[out] outFenceFd Acquire fence (-1 if none)
      * @return Buffer or nullptr if not available
@@ -139,10 +166,15 @@ public:
     
     /**
      * @brief Queue a filled buffer (producer side)
+     * 
+     * Lock-free: the buffer goes into the stream's pending ring, which
+     * holds up to poolConfig.maxBuffers entries.
+     * 
      * @param streamId Target stream
      * @param buffer Buffer to queue
-     * @param releaseFenceFd Release fence (-1 if none)
-     * @return True on success
+     * @param releaseFenceFd Release fence (-1 if none); taken on success,
+     *        left with the caller on failure so the call can be retried
+     * @return True on success, false if the stream is unknown or its ring is full
      */
     bool queueBuffer(
         uint32_t streamId,
@@ -152,17 +184,55 @@ public:
     
     /**
      * @brief Acquire a buffer for consumption (consumer side)
+     * 
+     * Lock-free; any number of consumers may call it concurrently.
+     * 
      * @param streamId Source stream
      * @param[out] outFenceFd Acquire fence
      * @return Buffer or nullptr
      */
     GraphicBuffer* acquireBuffer(uint32_t streamId, int* outFenceFd = nullptr);
     
+    /**
+     * @brief Acquire a buffer, waiting for one to be queued
+     * 
+     * Sleeps on the stream's event FD instead of spinning. Returns
+     * nullptr early if the stream is removed meanwhile.
+     * 
+     * @param streamId Source stream
+     * @param[out] outFenceFd Acquire fence
+     * @param timeoutMs Maximum wait time (0 = don't wait)
+     * @return Buffer or nullptr on timeout
+     */
+    GraphicBuffer* acquireBuffer(uint32_t streamId, int* outFenceFd, uint32_t timeoutMs);
+    
+    /**
+     * @brief Get an FD that is readable while the stream has queued buffers
+     * 
+     * Level-triggered: poll or add it to an epoll set with EPOLLIN, then
+     * call acquireBuffer() until it returns nullptr. Readiness can be
+     * spurious, never missed. The FD stays owned by the manager and is
+     * closed when the stream is removed.
+     * 
+     * @code
+     * epoll_event ev{EPOLLIN, {.u32 = streamId}};
+     * epoll_ctl(epfd, EPOLL_CTL_ADD, manager.getStreamEventFd(streamId), &ev);
+     * @endcode
+     * 
+     * @return Event FD, or -1 if the stream is unknown
+     */
+    int getStreamEventFd(uint32_t streamId) const;
+    
     /**
      * @brief Release a consumed buffer (consumer side)
+     * 
+     * Never blocks: a buffer whose release fence is still pending goes
+     * back to the pool from the fence manager's callback thread once the
+     * fence signals.
+     * 
      * @param streamId Source stream
      * @param buffer Buffer to release
-     * @param releaseFenceFd Release fence
+     * @param releaseFenceFd Release fence (takes ownership)
      */
     void releaseBuffer(
         uint32_t streamId,
@@ -170,6 +240,60 @@ public:
         int releaseFenceFd = -1
     );
     
+    /**
+     * @brief Dequeue one buffer from each of several streams, all or nothing
+     * 
+     * Streams are taken in ID order, so concurrent batches cannot
+     * deadlock holding each other's buffers. If any stream stays
+     * exhausted past the timeout, every buffer already taken goes back
+     * to its stream and the call fails. Buffers still waiting on a
+     * release fence are used like in dequeueBuffer(); their fences are
+     * merged into the single acquire fence of the batch.
+     * 
+     * @code
+     * std::vector<GraphicBuffer*> buffers;
+     * int fenceFd;
+     * if (manager.dequeueBatch({previewId, videoId}, buffers, &fenceFd, 33)) {
+     *     render(buffers, fenceFd);
+     *     manager.queueBatch({previewId, videoId}, buffers, renderDoneFd);
+     * }
+     * @endcode
+     * 
+     * @param streamIds Streams to dequeue from; may repeat
+     * @param[out] outBuffers Buffer per entry of streamIds, or empty on failure
+     * @param[out] outFenceFd Acquire fence for the whole batch (-1 if
+     *             every buffer is idle; waited here if null)
+     * @param timeoutMs Maximum wait for exhausted streams (0 = don't wait)
+     * @return True if every stream produced a buffer
+     */
+    bool dequeueBatch(
+        const std::vector<uint32_t>& streamIds,
+        std::vector<GraphicBuffer*>& outBuffers,
+        int* outFenceFd = nullptr,
+        uint32_t timeoutMs = 0
+    );
+    
+    /**
+     * @brief Queue a batch of filled buffers with one release fence
+     * 
+     * Every stream and buffer is validated, and ring room is reserved
+     * for every entry, before anything is queued; each buffer then
+     * carries a duplicate of the fence.
+     * 
+     * @param streamIds Target streams
+     * @param buffers Buffer per entry of streamIds
+     * @param releaseFenceFd Release fence for the whole batch (-1 if
+     *        none); taken on success, left with the caller on failure,
+     *        as for queueBuffer()
+     * @return True if every buffer was queued; an unknown stream, null
+     *         buffer or full ring fails the batch with nothing queued
+     */
+    bool queueBatch(
+        const std::vector<uint32_t>& streamIds,
+        const std::vector<GraphicBuffer*>& buffers,
+        int releaseFenceFd = -1
+    );
+    
     /**
      * @brief Set callback for buffer availability
      */
@@ -195,6 +319,11 @@ public:
      */
     PoolStatistics getStreamStatistics(uint32_t streamId) const;
     
+    /**
+     * @brief Get number of released buffers waiting on their fence
+     */
+    size_t getDeferredReleaseCount(uint32_t streamId) const;
+    
     /**
      * @brief Flush all streams
      * @param timeoutMs Maximum wait time
@@ -213,12 +342,62 @@ public:
     void onPoolExhausted(BufferPool* pool) override;
 
 private:
+    // Bound on waiting for release fences before a pool goes away
+    static constexpr uint32_t kDrainTimeoutMs = 5000;
+    
+    // Set in a user or reader count while a thread waits for it to drain
+    static constexpr uint32_t kQuiescing = 1u << 31;
+    
+    struct DeferredRelease {
+        uint64_t serial = 0;
+        GraphicBuffer* buffer = nullptr;
+        Fence fence;                    // Release fence (dup of the watched one)
+        uint64_t waitId = 0;            // 0 until waitAsync() returns
+    };
+    
     struct StreamInfo {
+        ~StreamInfo();
+        
         StreamConfiguration config;
         std::unique_ptr<BufferPool> pool;
         StreamState state = StreamState::IDLE;
-        std::queue<GraphicBuffer*> pendingBuffers;
-        std::mutex mutex;
+        std::unique_ptr<BufferRing> pending;   // Queued, not yet acquired
+        int eventFd = -1;                      // Readable while pending is non-empty
+        mutable std::mutex mutex;
+        
+        // Released buffers waiting on their release fence, oldest first
+        std::deque<DeferredRelease> deferred;
+        std::condition_variable deferredDone;
+        
+        // Live StreamRefs, plus kQuiescing; removeStream() and
+        // reconfigureStream() touch the stream's internals once it is
+        // unpublished and this drops to zero
+        std::atomic<uint32_t> users{0};
+        std::atomic<bool> closing{false};       // Set while unpublished to wake waiters
+    };
+    
+    // A looked-up stream, kept alive until the reference goes away
+    class StreamRef {
+    public:
+        StreamRef() = default;
+        StreamRef(const CameraBufferManager* owner, StreamInfo* info)
+            : owner_(owner), info_(info) {}
+        StreamRef(StreamRef&& other) noexcept : owner_(other.owner_), info_(other.info_) {
+            other.info_ = nullptr;
+        }
+        StreamRef& operator=(StreamRef&& other) noexcept;
+        ~StreamRef();
+        
+        StreamRef(const StreamRef&) = delete;
+        StreamRef& operator=(const StreamRef&) = delete;
+        
+        StreamInfo* get() const { return info_; }
+        StreamInfo* operator->() const { return info_; }
+        explicit operator bool() const { return info_ != nullptr; }
+
+    private:
+        const CameraBufferManager* owner_ = nullptr;
+        StreamInfo* info_ = nullptr;
     };
     
     std::shared_ptr<IBufferAllocator> allocator_;
@@ -227,13 +406,43 @@ private:
     std::map<uint32_t, std::unique_ptr<StreamInfo>> streams_;
     mutable std::mutex streamsMutex_;
     
+    // Read-mostly copy of streams_ for lock-free lookups. Replaced
+    // wholesale under streamsMutex_; the old table is freed once every
+    // reader that entered under the previous epoch has left.
+    struct StreamTable {
+        std::vector<std::pair<uint32_t, StreamInfo*>> entries;    // Sorted by ID
+    };
+    struct alignas(64) ReaderCount {
+        std::atomic<uint32_t> count{0};
+    };
+    std::atomic<const StreamTable*> streamTable_{nullptr};
+    std::atomic<uint64_t> tableEpoch_{0};
+    mutable ReaderCount tableReaders_[2];
+    
+    // Signaled when a count marked kQuiescing drops to zero. Lives here,
+    // not in the stream, since the stream may be freed right after.
+    mutable std::mutex quiesceMutex_;
+    mutable std::condition_variable quiesced_;
+    
     BufferCallback bufferCallback_;
     ErrorCallback errorCallback_;
     
     std::atomic<uint32_t> nextStreamId_{1};
+    std::atomic<uint64_t> nextDeferredSerial_{1};
+    
+    StreamRef getStream(uint32_t streamId) const;
+    GraphicBuffer* popPending(StreamInfo* info);
+    void publishQueued(StreamInfo* info, uint32_t streamId, GraphicBuffer* buffer);
+    GraphicBuffer* takeIdleBuffer(StreamInfo* info, Fence& outFence);
+    void publishStreamsLocked();
+    void quiesceStream(StreamInfo* info);
+    void releaseCount(std::atomic<uint32_t>& count) const;
+    void waitForZero(std::atomic<uint32_t>& count) const;
     
-    StreamInfo* getStream(uint32_t streamId);
-    const StreamInfo* getStream(uint32_t streamId) const;
+    void deferRelease(StreamInfo* info, GraphicBuffer* buffer, Fence&& fence);
+    void completeDeferredRelease(StreamInfo* info, uint64_t serial, GraphicBuffer* buffer);
+    GraphicBuffer* takeDeferred(StreamInfo* info, bool signaledOnly, Fence& outFence);
+    bool drainDeferred(StreamInfo* info, uint32_t timeoutMs);
 };
 
 } // namespace graphics
@@ -0,0 +1,60 @@
+/**
+ * @file CpuFeatures.h
+ * @brief Runtime CPU feature detection for SIMD kernel dispatch
+ */
+
+#pragma once
+
+#include <cstdint>
+
+namespace android {
+namespace graphics {
+
+/**
+ * @brief SIMD instruction set levels used by buffer kernels
+ */
+enum class SimdLevel {
+    SCALAR = 0,
+    SSE4_1 = 1,     ///< x86 SSE4.1 (implies SSSE3)
+    AVX2 = 2        ///< x86 AVX2
+};
+
+/**
+ * @brief Detects the SIMD level kernels may use on this CPU
+ * 
+ * Detection runs once. A cap can be set to force a lower level, which
+ * is how benchmarks compare kernels and how tests cover the fallbacks.
+ * 
+ * Thread Safety:
+ * - All methods are thread-safe
+ */
+class CpuFeatures {
+public:
+    /**
+     * @brief Get the level kernels should use (detected, capped)
+     */
+    static SimdLevel getSimdLevel();
+    
+    /**
+     * @brief Get the highest level the CPU supports
+     */
+    static SimdLevel getDetectedLevel();
+    
+    /**
+     * @brief Limit dispatch to at most the given level
+     */
+    static void setMaxSimdLevel(SimdLevel level);
+    
+    /**
+     * @brief Check for the SSE4.2 CRC32 instruction
+     */
+    static bool hasSse42();
+    
+    /**
+     * @brief Get a printable name for a level
+     */
+    static const char* toString(SimdLevel level);
+};
+
+} // namespace graphics
+} // namespace android
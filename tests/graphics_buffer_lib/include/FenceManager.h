@@ -4,16 +4,23 @@
  * 
  * Provides abstraction over sync fences for GPU/CPU synchronization
  * in graphics buffer workflows.
+ * 
+ * Fences are pollable file descriptors that become readable (POLLIN)
+ * once signaled, like Android sync_file fds. Fences created here are
+ * Linux eventfds whose counter holds the CLOCK_MONOTONIC signal time,
+ * so they can be waited with poll/epoll next to real sync fences.
  */
 
 #pragma once
 
+#include "FenceTrace.h"
 #include <cstdint>
 #include <memory>
 #include <vector>
 #include <functional>
 #include <atomic>
 #include <mutex>
+#include <string>
 
 namespace android {
 namespace graphics {
@@ -21,6 +28,9 @@ namespace graphics {
 // Forward declarations
 class GraphicBuffer;
 class BufferPool;
+class FenceReactor;
+class FenceTable;
+class NameTable;
 
 /**
  * @brief Fence state enumeration
@@ -34,6 +44,11 @@ enum class FenceState {
 
 /**
  * @brief Represents a synchronization fence
+ * 
+ * An invalid fence (fd -1) stands for "no fence": it never blocks.
+ * 
+ * Thread Safety:
+ * - Const methods and wait() may be called concurrently on one fence
  */
 class Fence {
 public:
@@ -70,7 +85,7 @@ public:
     /**
      * @brief Wait for fence to signal
      * @param timeoutMs Maximum wait time (UINT32_MAX = infinite)
-     * @return True if signaled, false on timeout or error
+     * @return True if signaled (or invalid), false on timeout or error
      */
     bool wait(uint32_t timeoutMs = UINT32_MAX);
     
@@ -95,6 +110,12 @@ public:
      */
     int dup() const;
     
+    /**
+     * @brief Give up ownership of the fence FD
+     * @return The FD (caller owns); the fence becomes invalid
+     */
+    int release();
+    
     /**
      * @brief Check if fence is valid
      */
@@ -109,24 +130,63 @@ public:
     
     /**
      * @brief Merge multiple fences into one
+     * 
+     * Signaled and invalid inputs are not waited for. When at most one
+     * input is still unsignaled, no new fence is created: the result
+     * shares that input (or the latest signaled one), and is invalid
+     * when nothing was given. Merging a pending merged fence again links
+     * to its inputs rather than watching it, so chains of merges do not
+     * grow FD counts or wait latency.
+     * 
+     * Like sync_merge(), an errored input errors the result: it is
+     * returned in the ERROR state when an input has already failed, and
+     * enters it when one fails later. A merge with inputs other than
+     * eventfds is backed by a pipe and has no signal time.
+     * 
      * @param fences Fences to merge
-     * @return Merged fence (signals when all inputs signal)
+     * @return Merged fence (signals when all inputs signal, errors when
+     *         any input does)
      */
     static Fence merge(const std::vector<Fence>& fences);
     
     /**
      * @brief Merge two fences
+     * 
+     * Returns the unsignaled input itself when the other one is
+     * signaled or invalid; an errored input errors the result.
      */
     static Fence merge(Fence&& a, Fence&& b);
     
     /**
      * @brief Get fence signal time (if signaled)
-     * @return Signal time in nanoseconds, or -1
+     * @return CLOCK_MONOTONIC signal time in nanoseconds, or -1 if
+     *         unsignaled or not created by this library
      */
     int64_t getSignalTime() const;
 
 private:
+    friend class FenceManager;
+    
+    static constexpr int64_t kUnknownEventId = -2;
+    
     int fd_ = -1;
+    mutable std::atomic<int64_t> eventId_{kUnknownEventId};
+    
+    /**
+     * @brief eventfd ID of the FD, read from procfs once per fence
+     * @return ID, or -1 for other fence types and older kernels
+     */
+    int64_t eventId() const;
+};
+
+/**
+ * @brief Configuration for FenceManager async waits
+ */
+struct FenceManagerConfig {
+    uint32_t callbackThreads = 2;       ///< Threads running waitAsync callbacks (0 = reactor thread)
+    size_t maxQueuedCallbacks = 256;    ///< Queued callbacks before the reactor runs them itself
+    uint32_t timerResolutionMs = 1;     ///< Granularity of waitAsync timeouts
+    size_t traceCapacity = 0;           ///< Events kept for exportTrace() (0 = tracing off)
 };
 
 /**
@@ -134,9 +194,16 @@ private:
  * 
  * Provides:
  * - Fence creation and tracking
- * - Async wait with callbacks
+ * - Async wait with callbacks, timeouts and cancellation
  * - Fence statistics
- * - Debug timeline info
+ * - Debug timeline info, Chrome trace export and latency histograms
+ * 
+ * Thread Safety:
+ * - All public methods are thread-safe
+ * - Async callbacks run on the manager's callback executor
+ * 
+ * All async waits of a manager share one epoll reactor thread, so
+ * thousands of outstanding fences cost one thread plus the executor.
  */
 class FenceManager {
 public:
@@ -146,6 +213,7 @@ public:
     using SignalCallback = std::function<void(Fence* fence, FenceState state)>;
     
     FenceManager();
+    explicit FenceManager(const FenceManagerConfig& config);
     ~FenceManager();
     
     /**
@@ -157,24 +225,71 @@ public:
     
     /**
      * @brief Signal a fence (for CPU-signaled fences)
+     * 
+     * Signaling an already signaled fence succeeds without effect.
+     * 
      * @param fence Fence to signal
-     * @return True on success
+     * @return True on success, false for fences not created here
      */
     bool signalFence(Fence& fence);
     
     /**
      * @brief Wait for fence asynchronously
+     * 
+     * Waits still pending when the manager is destroyed get their
+     * callback with the fence's current state. Fences that already
+     * signaled complete on the calling thread.
+     * 
      * @param fence Fence to wait on
      * @param callback Called when fence signals
+     * @return Wait ID for cancelWait(), or 0 if the callback already ran
+     */
+    uint64_t waitAsync(Fence&& fence, SignalCallback callback);
+    
+    /**
+     * @brief Wait for fence asynchronously with a timeout
+     * 
+     * @code
+     * uint64_t id = manager.waitAsync(std::move(fence),
+     *     [](Fence* f, FenceState state) {
+     *         if (state == FenceState::UNSIGNALED) {
+     *             // Timed out
+     *         }
+     *     }, 100);
+     * @endcode
+     * 
+     * @param timeoutMs Time after which callback gets UNSIGNALED
+     */
+    uint64_t waitAsync(Fence&& fence, SignalCallback callback, uint32_t timeoutMs);
+    
+    /**
+     * @brief Cancel a pending async wait
+     * 
+     * The fence is closed without running its callback.
+     * 
+     * @return True if cancelled, false if it already completed
+     */
+    bool cancelWait(uint64_t waitId);
+    
+    /**
+     * @brief Get number of async waits not yet completed
      */
-    void waitAsync(Fence&& fence, SignalCallback callback);
+    size_t getPendingWaitCount() const;
     
     /**
      * @brief Wait for multiple fences
+     * 
+     * Waits with one ppoll() over all fences per wake-up, using a
+     * per-thread pollfd array that is reused across calls. Null and
+     * invalid fences count as signaled. When waiting for any fence,
+     * errored fences are dropped and the wait goes on for the others.
+     * 
      * @param fences Fences to wait on
      * @param waitAll If true, wait for all; else wait for any
      * @param timeoutMs Maximum wait time
-     * @return Index of signaled fence (or -1 on timeout)
+     * @return Index of signaled fence (waitAll: the last index), or -1
+     *         on timeout, an empty list, an errored fence (waitAll) or
+     *         every fence errored (any)
      */
     int waitMultiple(
         const std::vector<Fence*>& fences,
@@ -184,6 +299,10 @@ public:
     
     /**
      * @brief Get number of active fences
+     * 
+     * Counts tracked fences not yet signaled through signalFence(). A
+     * fence closed unsignaled stops counting once createFence() hands
+     * out its FD number again.
      */
     size_t getActiveFenceCount() const;
     
@@ -194,23 +313,56 @@ public:
     
     /**
      * @brief Associate a fence with a buffer
+     * @param fence Fence returned by createFence() and still open
      */
     void associateFenceWithBuffer(Fence* fence, GraphicBuffer* buffer);
+    
+    /**
+     * @brief Export the fence timeline as Chrome trace JSON
+     * 
+     * Covers fences created and signaled through this manager and waits
+     * made with waitAsync() and waitMultiple(). Load the result in
+     * chrome://tracing or ui.perfetto.dev.
+     * 
+     * @return JSON, or an empty string when tracing is off
+     */
+    std::string exportTrace() const;
+    
+    /**
+     * @brief Create→signal latency of traced fences
+     */
+    LatencyHistogram::Snapshot getSignalLatency() const;
+    
+    /**
+     * @brief Signal→wake latency of traced waits
+     */
+    LatencyHistogram::Snapshot getWakeLatency() const;
 
 private:
-    struct FenceInfo {
-        std::unique_ptr<Fence> fence;
-        std::string name;
-        int64_t createTime;
-        GraphicBuffer* associatedBuffer = nullptr;
-    };
+    // Lock-free slot map of created fences; signalFence() frees
+    // signaled and closed ones in batches
+    std::unique_ptr<NameTable> names_;
+    std::unique_ptr<FenceTable> fences_;
+    static constexpr size_t kReclaimBatch = 64;
     
-    std::vector<FenceInfo> activeFences_;
-    mutable std::mutex mutex_;
+    // Serializes signalFence() only
+    std::mutex signalMutex_;
     
     std::atomic<uint64_t> fenceCounter_{0};
     
-    void cleanupSignaled();
+    // Started by the first waitAsync()
+    FenceManagerConfig config_;
+    std::unique_ptr<FenceReactor> reactor_;
+    mutable std::mutex reactorMutex_;
+    
+    FenceReactor* getReactor();
+    
+    // Set when FenceManagerConfig::traceCapacity is nonzero
+    std::unique_ptr<FenceTrace> trace_;
+    
+    int pollFences(const std::vector<Fence*>& fences, bool waitAll, uint32_t timeoutMs);
+    void traceWait(const Fence& fence, uint64_t& fenceId, const char*& name) const;
+    void traceWake(const Fence& fence, FenceState state, uint64_t fenceId, const char* name) const;
 };
 
 } // namespace graphics
@@ -0,0 +1,173 @@
+/**
+ * @file FenceTrace.h
+ * @brief Fence timeline tracing and latency histograms
+ * 
+ * Records fence create/signal/wait/wake events into a fixed-size
+ * lock-free ring and exports them as Chrome trace JSON (loadable in
+ * chrome://tracing and ui.perfetto.dev). Alongside the ring, two
+ * log2 histograms collect create→signal and signal→wake latency so the
+ * pipeline stage that eats the frame budget shows up without a trace
+ * viewer.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace android {
+namespace graphics {
+
+/**
+ * @brief Fence trace event type
+ */
+enum class FenceTraceEventType : uint8_t {
+    CREATE,     ///< Fence created
+    SIGNAL,     ///< Fence signaled; latency = create→signal
+    WAIT,       ///< A waiter started waiting
+    WAKE        ///< A waiter observed the signal; latency = signal→wake
+};
+
+/**
+ * @brief One recorded fence event
+ */
+struct FenceTraceEvent {
+    int64_t timeNs = 0;                 ///< CLOCK_MONOTONIC
+    uint64_t fenceId = 0;               ///< Creation number (0 = untracked fence)
+    const char* name = nullptr;         ///< Interned fence name, may be null
+    FenceTraceEventType type = FenceTraceEventType::CREATE;
+    uint32_t threadId = 0;
+    int64_t latencyNs = -1;             ///< SIGNAL/WAKE latency, -1 if unknown
+};
+
+/**
+ * @brief Lock-free log2 latency histogram
+ * 
+ * Bucket i counts latencies in [2^i, 2^(i+1)) nanoseconds; bucket 0
+ * also takes 0 and 1 ns.
+ */
+class LatencyHistogram {
+public:
+    static constexpr size_t kBuckets = 40;   ///< Up to ~18 minutes
+    
+    /**
+     * @brief Plain copy of a histogram
+     */
+    struct Snapshot {
+        uint64_t counts[kBuckets] = {};
+        uint64_t count = 0;
+        int64_t totalNs = 0;
+        int64_t maxNs = 0;
+        
+        int64_t getMeanNs() const { return count ? totalNs / static_cast<int64_t>(count) : 0; }
+        
+        /**
+         * @brief Estimate a percentile
+         * @param percentile In [0, 100]
+         * @return Upper bound of the bucket holding it, in nanoseconds
+         */
+        int64_t getPercentileNs(double percentile) const;
+        
+        /**
+         * @brief One line per non-empty bucket
+         */
+        std::string toString() const;
+    };
+    
+    void record(int64_t latencyNs);
+    Snapshot snapshot() const;
+    void reset();
+
+private:
+    std::atomic<uint64_t> counts_[kBuckets] = {};
+    std::atomic<uint64_t> count_{0};
+    std::atomic<int64_t> totalNs_{0};
+    std::atomic<int64_t> maxNs_{0};
+};
+
+/**
+ * @brief Lock-free ring of fence events
+ * 
+ * Writers claim a slot with one atomic increment and publish it with a
+ * per-slot sequence number; the oldest events are overwritten once the
+ * ring wraps. Readers copy out a consistent snapshot without blocking
+ * writers.
+ * 
+ * Usage:
+ * @code
+ * FenceTrace trace(4096);
+ * trace.record(FenceTraceEventType::CREATE, 1, "acquire");
+ * std::string json = trace.exportChromeJson();
+ * @endcode
+ * 
+ * Thread Safety:
+ * - All methods are thread-safe and lock-free
+ */
+class FenceTrace {
+public:
+    /**
+     * @param capacity Events kept; rounded up to a power of two
+     */
+    explicit FenceTrace(size_t capacity);
+    ~FenceTrace();
+    
+    FenceTrace(const FenceTrace&) = delete;
+    FenceTrace& operator=(const FenceTrace&) = delete;
+    
+    /**
+     * @brief Record an event stamped with the calling thread
+     * @param timeNs CLOCK_MONOTONIC time, or -1 for now
+     */
+    void record(FenceTraceEventType type, uint64_t fenceId, const char* name,
+                int64_t latencyNs = -1, int64_t timeNs = -1);
+    
+    /**
+     * @brief Record a fully specified event
+     */
+    void record(const FenceTraceEvent& event);
+    
+    /**
+     * @brief Copy out the retained events, oldest first
+     */
+    std::vector<FenceTraceEvent> snapshot() const;
+    
+    /**
+     * @brief Export retained events as Chrome trace JSON
+     * 
+     * Each fence becomes an async slice from create to signal and each
+     * wait an async slice from WAIT to WAKE; signals are instant events.
+     */
+    std::string exportChromeJson() const;
+    
+    /**
+     * @brief Events recorded, including overwritten ones
+     */
+    uint64_t getRecordedCount() const { return head_.load(std::memory_order_relaxed); }
+    
+    size_t getCapacity() const { return mask_ + 1; }
+    
+    /// Create→signal latency of traced fences
+    LatencyHistogram& getSignalLatency() { return signalLatency_; }
+    const LatencyHistogram& getSignalLatency() const { return signalLatency_; }
+    
+    /// Signal→wake latency of traced waits
+    LatencyHistogram& getWakeLatency() { return wakeLatency_; }
+    const LatencyHistogram& getWakeLatency() const { return wakeLatency_; }
+
+private:
+    struct Slot;
+    
+    std::unique_ptr<Slot[]> slots_;
+    size_t mask_;
+    std::atomic<uint64_t> head_{0};
+    
+    LatencyHistogram signalLatency_;
+    LatencyHistogram wakeLatency_;
+};
+
+} // namespace graphics
+} // namespace android
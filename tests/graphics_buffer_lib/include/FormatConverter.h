@@ -0,0 +1,85 @@
+/**
+ * @file FormatConverter.h
+ * @brief SIMD pixel-format conversion between locked buffers
+ * 
+ * Replaces per-consumer scalar conversion loops with kernels selected
+ * at runtime for the host CPU (AVX2, SSE4.1 or portable scalar).
+ */
+
+#pragma once
+
+#include "BufferTypes.h"
+#include "CpuFeatures.h"
+
+namespace android {
+namespace graphics {
+
+// Forward declarations
+class GraphicBuffer;
+
+/**
+ * @brief Pixel-format converter with runtime CPU dispatch
+ * 
+ * Supported conversions:
+ * - NV21 / NV12 -> RGBA_8888, RGBX_8888, BGRA_8888 (BT.601 limited range)
+ * - NV21 / NV12 -> YV12 (Y copy + chroma deinterleave)
+ * - RGBA_8888 / RGBX_8888 <-> BGRA_8888 (red/blue swap)
+ * - Any format -> the same format (stride-aware plane copy)
+ * 
+ * All conversions respect the source and destination strides, so
+ * gralloc padding is never read or written as pixel data. YUV images
+ * with an odd stride are rejected, since their chroma rows overlap.
+ * 
+ * @code
+ * GraphicBuffer* preview = ...;   // NV21 from the camera
+ * GraphicBuffer* texture = ...;   // RGBA_8888, same size
+ * if (!FormatConverter::convert(preview, texture)) {
+ *     // Unsupported pair or lock failure
+ * }
+ * @endcode
+ * 
+ * Thread Safety:
+ * - Stateless; concurrent conversions on different buffers are safe
+ */
+class FormatConverter {
+public:
+    /**
+     * @brief Check if a conversion is available
+     */
+    static bool isSupported(PixelFormat src, PixelFormat dst);
+    
+    /**
+     * @brief Convert one buffer into another
+     * 
+     * Locks src for reading and dst for writing for the duration of the
+     * call. Both buffers must have the same width and height.
+     * 
+     * @param src Source buffer
+     * @param dst Destination buffer
+     * @return True on success
+     */
+    static bool convert(GraphicBuffer* src, GraphicBuffer* dst);
+    
+    /**
+     * @brief Convert between already-mapped images
+     * @param src Start of the source image
+     * @param srcDesc Source geometry (stride must be resolved)
+     * @param dst Start of the destination image
+     * @param dstDesc Destination geometry (stride must be resolved)
+     * @return True on success
+     */
+    static bool convert(
+        const void* src,
+        const BufferDescriptor& srcDesc,
+        void* dst,
+        const BufferDescriptor& dstDesc
+    );
+    
+    /**
+     * @brief Get the kernel level conversions currently dispatch to
+     */
+    static SimdLevel getActiveLevel() { return CpuFeatures::getSimdLevel(); }
+};
+
+} // namespace graphics
+} // namespace android
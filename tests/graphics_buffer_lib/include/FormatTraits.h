@@ -0,0 +1,279 @@
+/**
+ * @file FormatTraits.h
+ * @brief Compile-time layout traits for every PixelFormat
+ * 
+ * One table describes how each format is laid out in memory. Size,
+ * stride, plane and capability queries across the library read it
+ * instead of keeping their own switch statements, and kernels can take
+ * the traits as template parameters so layout choices are resolved at
+ * compile time rather than per pixel.
+ */
+
+#pragma once
+
+#include "BufferTypes.h"
+
+namespace android {
+namespace graphics {
+
+/**
+ * @brief Memory layout of one pixel format
+ * 
+ * For multi-plane formats the first plane is luma and chroma planes
+ * are 8-bit, subsampled by chromaShiftX/chromaShiftY.
+ */
+struct FormatInfo {
+    const char* name = "UNKNOWN";
+    uint32_t planeCount = 1;         ///< 1 packed, 2 semi-planar, 3 planar
+    uint32_t bitsPerPixel = 32;      ///< Storage bits per pixel of the first plane
+    uint32_t sampleBits = 8;         ///< Bits per color sample
+    uint32_t chromaShiftX = 0;       ///< log2 of horizontal chroma subsampling
+    uint32_t chromaShiftY = 0;       ///< log2 of vertical chroma subsampling
+    uint32_t strideAlignment = 1;    ///< Stride must be a multiple of this (pixels)
+    bool crFirst = false;            ///< Cr precedes Cb in memory
+    bool blueFirst = false;          ///< Blue precedes red in memory
+    bool yuv = false;                ///< Luma/chroma planes
+    bool raw = false;                ///< Single-channel Bayer samples
+    bool compressed = false;         ///< Opaque byte stream (BLOB)
+    bool allocatable = false;        ///< Backed by the gralloc allocator
+    
+    /// Storage bytes of one pixel, rounded up for bit-packed formats
+    constexpr uint32_t bytesPerPixel() const { return (bitsPerPixel + 7) / 8; }
+    
+    /// Pixels are not byte aligned (RAW10/RAW12)
+    constexpr bool isPacked() const { return bitsPerPixel % 8 != 0; }
+    
+    /// Pixels in the smallest byte-aligned group
+    constexpr uint32_t groupPixels() const {
+        uint32_t pixels = 1;
+        while (pixels * bitsPerPixel % 8 != 0) {
+            ++pixels;
+        }
+        return pixels;
+    }
+    
+    /// Bytes of one byte-aligned pixel group
+    constexpr uint32_t groupBytes() const { return groupPixels() * bitsPerPixel / 8; }
+    
+    /// Bytes of a first-plane row, rounded up to whole groups
+    constexpr size_t rowBytes(uint32_t width) const {
+        return (static_cast<size_t>(width) + groupPixels() - 1) / groupPixels() * groupBytes();
+    }
+    
+    /// Dimension of a chroma plane for a luma dimension
+    static constexpr uint32_t subsample(uint32_t size, uint32_t shift) {
+        return (size + (1u << shift) - 1) >> shift;
+    }
+    
+    /// Bytes of one image layer with the given stride (pixels) and height
+    constexpr size_t imageSize(uint32_t stride, uint32_t height) const {
+        size_t size = rowBytes(stride) * height;
+        if (planeCount > 1) {
+            // Two chroma samples per subsampled position, in one or two planes
+            size += static_cast<size_t>(subsample(stride, chromaShiftX)) * 2 *
+                    subsample(height, chromaShiftY);
+        }
+        return size;
+    }
+};
+
+namespace detail {
+
+constexpr FormatInfo makeRgbFormat(const char* name, uint32_t bits, bool blueFirst = false) {
+    FormatInfo info;
+    info.name = name;
+    info.bitsPerPixel = bits;
+    info.sampleBits = bits == 16 ? 5 : 8;
+    info.blueFirst = blueFirst;
+    info.allocatable = true;
+    return info;
+}
+
+constexpr FormatInfo makeYuv420Format(const char* name, uint32_t planes, bool crFirst) {
+    FormatInfo info;
+    info.name = name;
+    info.planeCount = planes;
+    info.bitsPerPixel = 8;
+    info.chromaShiftX = 1;
+    info.chromaShiftY = 1;
+    info.strideAlignment = 2;
+    info.crFirst = crFirst;
+    info.yuv = true;
+    info.allocatable = true;
+    return info;
+}
+
+constexpr FormatInfo makeRawFormat(const char* name, uint32_t bits) {
+    FormatInfo info;
+    info.name = name;
+    info.bitsPerPixel = bits;
+    info.sampleBits = bits;
+    info.raw = true;
+    info.allocatable = true;
+    return info;
+}
+
+constexpr FormatInfo makeOpaqueFormat(
+    const char* name, uint32_t bits, bool compressed, bool allocatable
+) {
+    FormatInfo info;
+    info.name = name;
+    info.bitsPerPixel = bits;
+    info.compressed = compressed;
+    info.allocatable = allocatable;
+    return info;
+}
+
+} // namespace detail
+
+/**
+ * @brief Compile-time traits of a pixel format
+ * 
+ * @code
+ * template <PixelFormat Format>
+ * void fillRow(uint8_t* row, uint32_t width) {
+ *     constexpr FormatInfo info = FormatTraits<Format>::kInfo;
+ *     static_assert(!info.isPacked(), "byte-aligned formats only");
+ *     // info.bytesPerPixel() etc. fold to constants here
+ * }
+ * @endcode
+ * 
+ * Use getFormatInfo() when the format is only known at runtime.
+ */
+template <PixelFormat Format>
+struct FormatTraits {
+    static constexpr PixelFormat kFormat = Format;
+    static constexpr FormatInfo kInfo = FormatInfo();
+};
+
+template <>
+struct FormatTraits<PixelFormat::RGBA_8888> {
+    static constexpr PixelFormat kFormat = PixelFormat::RGBA_8888;
+    static constexpr FormatInfo kInfo = detail::makeRgbFormat("RGBA_8888", 32);
+};
+
+template <>
+struct FormatTraits<PixelFormat::RGBX_8888> {
+    static constexpr PixelFormat kFormat = PixelFormat::RGBX_8888;
+    static constexpr FormatInfo kInfo = detail::makeRgbFormat("RGBX_8888", 32);
+};
+
+template <>
+struct FormatTraits<PixelFormat::RGB_888> {
+    static constexpr PixelFormat kFormat = PixelFormat::RGB_888;
+    static constexpr FormatInfo kInfo = detail::makeRgbFormat("RGB_888", 24);
+};
+
+template <>
+struct FormatTraits<PixelFormat::RGB_565> {
+    static constexpr PixelFormat kFormat = PixelFormat::RGB_565;
+    static constexpr FormatInfo kInfo = detail::makeRgbFormat("RGB_565", 16);
+};
+
+template <>
+struct FormatTraits<PixelFormat::BGRA_8888> {
+    static constexpr PixelFormat kFormat = PixelFormat::BGRA_8888;
+    static constexpr FormatInfo kInfo = detail::makeRgbFormat("BGRA_8888", 32, true);
+};
+
+template <>
+struct FormatTraits<PixelFormat::YV12> {
+    static constexpr PixelFormat kFormat = PixelFormat::YV12;
+    static constexpr FormatInfo kInfo = detail::makeYuv420Format("YV12", 3, true);
+};
+
+template <>
+struct FormatTraits<PixelFormat::NV21> {
+    static constexpr PixelFormat kFormat = PixelFormat::NV21;
+    static constexpr FormatInfo kInfo = detail::makeYuv420Format("NV21", 2, true);
+};
+
+template <>
+struct FormatTraits<PixelFormat::NV12> {
+    static constexpr PixelFormat kFormat = PixelFormat::NV12;
+    static constexpr FormatInfo kInfo = detail::makeYuv420Format("NV12", 2, false);
+};
+
+template <>
+struct FormatTraits<PixelFormat::RAW10> {
+    static constexpr PixelFormat kFormat = PixelFormat::RAW10;
+    static constexpr FormatInfo kInfo = detail::makeRawFormat("RAW10", 10);
+};
+
+template <>
+struct FormatTraits<PixelFormat::RAW12> {
+    static constexpr PixelFormat kFormat = PixelFormat::RAW12;
+    static constexpr FormatInfo kInfo = detail::makeRawFormat("RAW12", 12);
+};
+
+template <>
+struct FormatTraits<PixelFormat::RAW16> {
+    static constexpr PixelFormat kFormat = PixelFormat::RAW16;
+    static constexpr FormatInfo kInfo = detail::makeRawFormat("RAW16", 16);
+};
+
+template <>
+struct FormatTraits<PixelFormat::BLOB> {
+    static constexpr PixelFormat kFormat = PixelFormat::BLOB;
+    static constexpr FormatInfo kInfo = detail::makeOpaqueFormat("BLOB", 8, true, true);
+};
+
+template <>
+struct FormatTraits<PixelFormat::IMPLEMENTATION_DEFINED> {
+    static constexpr PixelFormat kFormat = PixelFormat::IMPLEMENTATION_DEFINED;
+    static constexpr FormatInfo kInfo =
+        detail::makeOpaqueFormat("IMPLEMENTATION_DEFINED", 32, false, false);
+};
+
+/**
+ * @brief Look up the traits of a format known only at runtime
+ * 
+ * Unknown values get the UNKNOWN traits (32-bit, not allocatable).
+ */
+constexpr const FormatInfo& getFormatInfo(PixelFormat format) {
+    switch (format) {
+        case PixelFormat::RGBA_8888:
+            return FormatTraits<PixelFormat::RGBA_8888>::kInfo;
+        case PixelFormat::RGBX_8888:
+            return FormatTraits<PixelFormat::RGBX_8888>::kInfo;
+        case PixelFormat::RGB_888:
+            return FormatTraits<PixelFormat::RGB_888>::kInfo;
+        case PixelFormat::RGB_565:
+            return FormatTraits<PixelFormat::RGB_565>::kInfo;
+        case PixelFormat::BGRA_8888:
+            return FormatTraits<PixelFormat::BGRA_8888>::kInfo;
+        case PixelFormat::YV12:
+            return FormatTraits<PixelFormat::YV12>::kInfo;
+        case PixelFormat::NV21:
+            return FormatTraits<PixelFormat::NV21>::kInfo;
+        case PixelFormat::NV12:
+            return FormatTraits<PixelFormat::NV12>::kInfo;
+        case PixelFormat::RAW10:
+            return FormatTraits<PixelFormat::RAW10>::kInfo;
+        case PixelFormat::RAW12:
+            return FormatTraits<PixelFormat::RAW12>::kInfo;
+        case PixelFormat::RAW16:
+            return FormatTraits<PixelFormat::RAW16>::kInfo;
+        case PixelFormat::BLOB:
+            return FormatTraits<PixelFormat::BLOB>::kInfo;
+        case PixelFormat::IMPLEMENTATION_DEFINED:
+            return FormatTraits<PixelFormat::IMPLEMENTATION_DEFINED>::kInfo;
+        default:
+            return FormatTraits<PixelFormat::UNKNOWN>::kInfo;
+    }
+}
+
+// Layout facts the rest of the library relies on
+static_assert(FormatTraits<PixelFormat::RAW10>::kInfo.groupPixels() == 4 &&
+              FormatTraits<PixelFormat::RAW10>::kInfo.groupBytes() == 5,
+              "RAW10 packs 4 pixels into 5 bytes");
+static_assert(FormatTraits<PixelFormat::RAW12>::kInfo.groupPixels() == 2 &&
+              FormatTraits<PixelFormat::RAW12>::kInfo.groupBytes() == 3,
+              "RAW12 packs 2 pixels into 3 bytes");
+static_assert(FormatTraits<PixelFormat::NV21>::kInfo.imageSize(64, 48) == 64 * 48 * 3 / 2,
+              "4:2:0 images are 12 bits per pixel");
+static_assert(FormatTraits<PixelFormat::RAW16>::kInfo.rowBytes(10) == 20,
+              "RAW16 rows are 2 bytes per pixel");
+
+} // namespace graphics
+} // namespace android
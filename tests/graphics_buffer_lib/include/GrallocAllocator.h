@@ -10,8 +10,16 @@
 
 #include "IBufferAllocator.h"
 #include "BufferMapper.h"
+#include "BufferReserve.h"
 #include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <deque>
+#include <vector>
+#include <chrono>
+#include <map>
 #include <unordered_map>
+#include <unordered_set>
 
 namespace android {
 namespace graphics {
@@ -30,15 +38,35 @@ enum class GrallocVersion {
     GRALLOC_AIDL
 };
 
+/**
+ * @brief Scheduling priority for asynchronous allocation requests
+ */
+enum class AllocationPriority {
+    LOW = 0,
+    NORMAL = 1,
+    HIGH = 2
+};
+
 /**
  * @brief Gralloc-based allocator using Android HAL
  * 
  * Features:
  * - Automatic HAL version detection
  * - Buffer handle caching for performance
+ * - Warm reserve of recently used descriptors (see BufferReserve),
+ *   zeroed on reuse like fresh allocations
+ * - memfd backing honoring row alignment, huge pages and guard pages
+ * - Batch allocation carving several buffers from one backing
  * - Async allocation support via thread pool
  * - Format negotiation with gralloc
  * 
+ * Async Allocation:
+ * - A fixed set of worker threads serves a bounded priority queue
+ * - Pending requests with identical descriptors are coalesced into
+ *   a single job served by one allocateBatch() call
+ * - The queue bound counts requests, coalesced or not
+ * - Queued requests can be cancelled until a worker picks them up
+ * 
  * Thread Safety:
  * - All public methods are thread-safe
  * - Internal caching uses fine-grained locking
@@ -47,6 +75,10 @@ enum class GrallocVersion {
  */
 class GrallocAllocator : public IBufferAllocator {
 public:
+    static constexpr size_t kAsyncWorkerCount = 2;     ///< Async worker threads
+    static constexpr size_t kMaxAsyncQueueDepth = 32;  ///< Max queued async requests
+    static constexpr size_t kHugePageSize = 2 * 1024 * 1024;
+    
     /**
      * @brief Create allocator with automatic HAL detection
      */
@@ -66,11 +98,51 @@ public:
         std::unique_ptr<GraphicBuffer>& outBuffer
     ) override;
     
+    AllocationStatus allocateBatch(
+        const BufferDescriptor& descriptor,
+        uint32_t count,
+        std::vector<std::unique_ptr<GraphicBuffer>>& outBuffers
+    ) override;
+    
     void allocateAsync(
         const BufferDescriptor& descriptor,
         AllocationCallback callback
     ) override;
     
+    /**
+     * @brief Submit an async allocation with explicit priority
+     * 
+     * If the queue is full the callback is invoked immediately with
+     * ERROR_QUEUE_FULL. Requests for a descriptor that is already
+     * queued are coalesced into the existing job.
+     * 
+     * @param descriptor Buffer requirements
+     * @param callback Called when allocation completes or is cancelled
+     * @param priority Scheduling priority
+     * @return Request ID for cancelAsync(), or 0 if rejected
+     */
+    uint64_t submitAsync(
+        const BufferDescriptor& descriptor,
+        AllocationCallback callback,
+        AllocationPriority priority = AllocationPriority::NORMAL
+    );
+    
+    /**
+     * @brief Cancel a queued async request
+     * 
+     * The callback is invoked with ERROR_CANCELLED. Requests already
+     * picked up by a worker cannot be cancelled.
+     * 
+     * @param requestId ID returned by submitAsync()
+     * @return True if the request was still queued and is now cancelled
+     */
+    bool cancelAsync(uint64_t requestId);
+    
+    /**
+     * @brief Get number of async requests waiting for a worker
+     */
+    size_t getAsyncQueueDepth() const;
+    
     void free(GraphicBuffer* buffer) override;
     
     AllocationStatus importBuffer(
@@ -86,6 +158,20 @@ public:
         BufferUsage usage
     ) const override;
     
+    BackingFlags getSupportedBackingFlags() const override;
+    
+    bool lockHandle(
+        const NativeHandle& handle,
+        BufferUsage usage,
+        void** outData
+    ) override;
+    
+    bool unlockHandle(const NativeHandle& handle) override;
+    
+    size_t releaseCachedMemory() override;
+    size_t getCachedBytes() const override;
+    size_t getAllocationSize(const BufferDescriptor& descriptor) const override;
+    
     const char* getName() const override { return "GrallocAllocator"; }
     
     /**
@@ -111,6 +197,29 @@ public:
         uint32_t& outStride
     ) const;
     
+    /**
+     * @brief Speculatively allocate handles into the warm reserve
+     * 
+     * Marks the descriptor as predicted so subsequent allocate() calls,
+     * e.g. from a new BufferPool, are served without a HAL round trip.
+     * 
+     * @param descriptor Buffer shape expected soon
+     * @param count Number of handles to pre-allocate
+     * @return Number of handles added to the reserve
+     */
+    uint32_t prewarm(const BufferDescriptor& descriptor, uint32_t count);
+    
+    /**
+     * @brief Release every handle held in the warm reserve
+     * @return Bytes released
+     */
+    size_t trimReserve();
+    
+    /**
+     * @brief Get warm reserve statistics
+     */
+    BufferReserveStatistics getReserveStatistics() const;
+    
     /**
      * @brief Dump allocator state for debugging
      */
@@ -120,20 +229,98 @@ private:
     GrallocVersion version_;
     std::unique_ptr<GrallocMapper> mapper_;
     std::unique_ptr<BufferCache> cache_;
+    std::unique_ptr<BufferReserve> reserve_;
     
     mutable std::mutex allocMutex_;
     std::unordered_map<uint64_t, GraphicBuffer*> activeBuffers_;
+    std::unordered_set<uint64_t> importedBuffers_;  // Never kept in reserve
+    std::unordered_map<int, uint32_t> backingRefs_;  // Handles sharing each fd
     
     // HAL-specific handles (opaque)
     void* halHandle_ = nullptr;
     
+    // Async allocation worker pool
+    using Clock = std::chrono::steady_clock;
+    
+    struct AsyncRequest {
+        uint64_t requestId = 0;
+        AllocationCallback callback;
+        Clock::time_point submitTime;
+    };
+    
+    struct AsyncJob {
+        BufferDescriptor descriptor;
+        AllocationPriority priority = AllocationPriority::NORMAL;
+        std::vector<AsyncRequest> requests;
+    };
+    
+    struct AsyncMetrics {
+        uint64_t submitted = 0;
+        uint64_t completed = 0;
+        uint64_t coalesced = 0;
+        uint64_t rejected = 0;
+        uint64_t cancelled = 0;
+        size_t peakQueueDepth = 0;
+        uint64_t totalWaitUs = 0;     ///< Submit to worker pickup
+        uint64_t maxWaitUs = 0;
+        uint64_t totalLatencyUs = 0;  ///< Submit to callback
+        uint64_t maxLatencyUs = 0;
+    };
+    
+    std::vector<std::thread> asyncWorkers_;
+    std::deque<AsyncJob> asyncQueue_;  // Sorted by priority, FIFO within
+    size_t asyncPendingRequests_ = 0;
+    mutable std::mutex asyncMutex_;
+    std::condition_variable asyncCondition_;
+    bool asyncStopping_ = false;
+    uint64_t nextAsyncRequestId_ = 1;
+    AsyncMetrics asyncMetrics_;
+    
     bool initializeHal();
     void shutdownHal();
     
+    void startAsyncWorkers();
+    void stopAsyncWorkers();
+    void asyncWorkerLoop();
+    void enqueueAsyncJob(AsyncJob&& job);
+    
     AllocationStatus allocateInternal(
         const BufferDescriptor& descriptor,
         NativeHandle& outHandle
     );
+    
+    /**
+     * @brief Allocate handles, carving them from shared backings when possible
+     * @param[out] outHandles Allocated handles are appended here
+     */
+    AllocationStatus allocateBatchInternal(
+        const BufferDescriptor& descriptor,
+        uint32_t count,
+        std::vector<NativeHandle>& outHandles
+    );
+    
+    /**
+     * @brief Wrap a handle in a GraphicBuffer and start tracking it
+     */
+    std::unique_ptr<GraphicBuffer> createBuffer(
+        const BufferDescriptor& descriptor,
+        const NativeHandle& handle
+    );
+    
+    void releaseHandle(NativeHandle& handle);
+    
+    /**
+     * @brief Zero a handle taken from the warm reserve
+     * 
+     * Reused handles still hold the previous owner's pixels; clearing them
+     * keeps warm buffers indistinguishable from zero-filled cold ones.
+     */
+    void clearHandle(const NativeHandle& handle);
+    
+    /**
+     * @brief Resolve the stride the HAL would pick for a descriptor
+     */
+    BufferDescriptor resolveLayout(const BufferDescriptor& descriptor) const;
 };
 
 /**
@@ -184,10 +371,30 @@ public:
         void* outData,
         size_t& size
     );
+    
+    /**
+     * @brief Drop any cached CPU mapping for a buffer being freed
+     * @param handle Buffer handle
+     */
+    void release(const NativeHandle& handle);
 
 private:
+    struct Mapping {
+        void* base = nullptr;   ///< Start of the reserved range (incl. guards)
+        size_t span = 0;        ///< Length of the reserved range
+        void* data = nullptr;   ///< Start of the buffer contents
+    };
+    
     GrallocVersion version_;
     void* mapperHandle_ = nullptr;
+    
+    // Mappings are kept until release() so repeated locks skip mmap.
+    // Keyed by (fd, offset) since batch buffers share one backing fd.
+    std::map<std::pair<int, size_t>, Mapping> mappings_;
+    std::mutex mappingMutex_;
+    
+    bool mapHandle(const NativeHandle& handle, Mapping& outMapping);
+    void unmap(Mapping& mapping);
 };
 
 } // namespace graphics
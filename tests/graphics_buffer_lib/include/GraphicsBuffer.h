@@ -31,22 +31,32 @@
 
 // Core types
 #include "BufferTypes.h"
+#include "FormatTraits.h"
+#include "ImageView.h"
 
 // Allocation interfaces
 #include "IBufferAllocator.h"
 #include "GrallocAllocator.h"
+#include "BudgetedAllocator.h"
 
 // Buffer classes
 #include "GraphicBuffer.h"
 #include "BufferPool.h"
 #include "BufferMapper.h"
+#include "FormatConverter.h"
+#include "RawPacking.h"
+#include "CpuFeatures.h"
+#include "WorkStealingPool.h"
 #include "BufferCache.h"
+#include "BufferReserve.h"
+#include "FrameRecorder.h"
 
 // Camera integration
 #include "CameraBufferManager.h"
 
 // Synchronization
 #include "FenceManager.h"
+#include "FenceTrace.h"
 
 namespace android {
 namespace graphics {
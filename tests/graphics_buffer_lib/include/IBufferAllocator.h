@@ -9,8 +9,10 @@
 #pragma once
 
 #include "BufferTypes.h"
+#include <atomic>
 #include <memory>
 #include <functional>
+#include <vector>
 
 namespace android {
 namespace graphics {
@@ -46,6 +48,25 @@ public:
         std::unique_ptr<GraphicBuffer>& outBuffer
     ) = 0;
     
+    /**
+     * @brief Allocate several buffers with the same descriptor
+     * 
+     * Implementations should amortize locking and HAL round trips across
+     * the batch. The default implementation calls allocate() in a loop.
+     * 
+     * @param descriptor Buffer geometry and usage requirements
+     * @param count Number of buffers requested
+     * @param[out] outBuffers Allocated buffers are appended here; on
+     *             failure it holds the buffers allocated before the error
+     * @return SUCCESS if all count buffers were allocated, otherwise the
+     *         status of the first failed allocation
+     */
+    virtual AllocationStatus allocateBatch(
+        const BufferDescriptor& descriptor,
+        uint32_t count,
+        std::vector<std::unique_ptr<GraphicBuffer>>& outBuffers
+    );
+    
     /**
      * @brief Asynchronously allocate a buffer
      * @param descriptor Buffer requirements
@@ -89,10 +110,100 @@ public:
         BufferUsage usage
     ) const = 0;
     
+    /**
+     * @brief Get backing options this allocator honors
+     * 
+     * Flags outside this mask are ignored by allocate(); the buffer is
+     * still created with regular page backing.
+     */
+    virtual BackingFlags getSupportedBackingFlags() const { return BackingFlags::NONE; }
+    
+    /**
+     * @brief Map a buffer's backing memory for CPU access
+     * 
+     * The default implementation provides no CPU mapping.
+     * 
+     * @param handle Native handle of a buffer from this allocator
+     * @param usage CPU access mode
+     * @param[out] outData Mapped pointer (nullptr if not CPU-mappable)
+     * @return True on success
+     */
+    virtual bool lockHandle(
+        const NativeHandle& handle,
+        BufferUsage /*usage*/,
+        void** outData
+    ) {
+        *outData = nullptr;
+        return handle.isValid();
+    }
+    
+    /**
+     * @brief Finish CPU access started with lockHandle()
+     */
+    virtual bool unlockHandle(const NativeHandle& handle) {
+        return handle.isValid();
+    }
+    
+    /**
+     * @brief Called by BufferPool when it starts drawing from this allocator
+     * 
+     * Lets memory-aware allocators ask pools to shrink under pressure.
+     * The pool calls unregisterPool() before it is destroyed.
+     */
+    virtual void registerPool(BufferPool* /*pool*/) {}
+    
+    /**
+     * @brief Called by BufferPool before it is destroyed
+     */
+    virtual void unregisterPool(BufferPool* /*pool*/) {}
+    
+    /**
+     * @brief Release memory the allocator holds for reuse (caches, reserves)
+     * @return Number of bytes released
+     */
+    virtual size_t releaseCachedMemory() { return 0; }
+    
+    /**
+     * @brief Get bytes held for reuse that belong to no live buffer
+     */
+    virtual size_t getCachedBytes() const { return 0; }
+    
+    /**
+     * @brief Get the bytes one allocation with this descriptor occupies
+     * 
+     * Includes layout, page and huge-page rounding. The default is the
+     * descriptor's own size.
+     */
+    virtual size_t getAllocationSize(const BufferDescriptor& descriptor) const {
+        return descriptor.calculateSize();
+    }
+    
+    /**
+     * @brief Route buffers created from now on to another allocator
+     * 
+     * A decorator sets itself as owner so free() and CPU locks of the
+     * buffers this allocator creates reach it first. Implementations pass
+     * getBufferOwner() to every GraphicBuffer they construct. Pass nullptr
+     * to restore; an allocator has at most one owner.
+     */
+    void setBufferOwner(IBufferAllocator* owner) { bufferOwner_ = owner; }
+    
     /**
      * @brief Get the allocator name for debugging
      */
     virtual const char* getName() const = 0;
+
+protected:
+    /**
+     * @brief Allocator recorded in new buffers (this unless re-owned)
+     */
+    IBufferAllocator* getBufferOwner() {
+        IBufferAllocator* owner = bufferOwner_.load();
+        return owner ? owner : this;
+    }
+
+private:
+    std::atomic<IBufferAllocator*> bufferOwner_{nullptr};
 };
 
 /**
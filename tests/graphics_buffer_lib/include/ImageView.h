@@ -0,0 +1,255 @@
+/**
+ * @file ImageView.h
+ * @brief Non-owning typed views over mapped image planes
+ * 
+ * Views carry the plane geometry next to the pointer, so code handed a
+ * locked buffer can walk rows and samples in place instead of
+ * recomputing offsets or copying into a temporary container.
+ */
+
+#pragma once
+
+#include "BufferTypes.h"
+#include "FormatTraits.h"
+#include <type_traits>
+
+namespace android {
+namespace graphics {
+
+/**
+ * @brief Strided view of one image plane
+ * 
+ * Strides are in bytes, so the same plane can be viewed with any sample
+ * type: the Cb plane of NV21 is a PlaneView<uint8_t> with a sample
+ * stride of 2, and a RAW16 plane becomes PlaneView<uint16_t> via as().
+ * Bit-packed planes (RAW10/RAW12) have a sample stride of 0 and only
+ * support row access.
+ * 
+ * @code
+ * PlaneView<const uint8_t> luma = view.plane(0);
+ * uint64_t sum = 0;
+ * for (uint32_t y = 0; y < luma.getHeight(); ++y) {
+ *     const uint8_t* row = luma.row(y);
+ *     for (uint32_t x = 0; x < luma.getWidth(); ++x) {
+ *         sum += row[x];
+ *     }
+ * }
+ * @endcode
+ * 
+ * Thread Safety:
+ * - A view is a plain value; it is valid only while the mapping it
+ *   points into stays locked
+ */
+template <typename T>
+class PlaneView {
+public:
+    /// uint8_t with the constness of T
+    using Byte = std::conditional_t<std::is_const<T>::value, const uint8_t, uint8_t>;
+    
+    PlaneView() = default;
+    
+    PlaneView(T* data, size_t rowStride, uint32_t sampleStride, uint32_t width, uint32_t height)
+        : data_(data), rowStride_(rowStride), sampleStride_(sampleStride),
+          width_(width), height_(height) {}
+    
+    /// Views of mutable samples convert to views of const samples
+    template <typename U, typename = std::enable_if_t<std::is_same<const U, T>::value>>
+    PlaneView(const PlaneView<U>& other)
+        : PlaneView(other.getData(), other.getRowStride(), other.getSampleStride(),
+                    other.getWidth(), other.getHeight()) {}
+    
+    T* getData() const { return data_; }
+    size_t getRowStride() const { return rowStride_; }
+    uint32_t getSampleStride() const { return sampleStride_; }
+    uint32_t getWidth() const { return width_; }
+    uint32_t getHeight() const { return height_; }
+    bool empty() const { return !data_ || width_ == 0 || height_ == 0; }
+    
+    /// Rows are back to back with samples densely packed
+    bool isContiguous() const {
+        return sampleStride_ == sizeof(T) && rowStride_ == static_cast<size_t>(width_) * sizeof(T);
+    }
+    
+    /**
+     * @brief First sample of row y
+     */
+    T* row(uint32_t y) const {
+        return reinterpret_cast<T*>(bytes() + static_cast<size_t>(y) * rowStride_);
+    }
+    
+    /**
+     * @brief Sample at column x of row y (not for bit-packed planes)
+     */
+    T& at(uint32_t x, uint32_t y) const {
+        return *reinterpret_cast<T*>(bytes() + static_cast<size_t>(y) * rowStride_ +
+                                     static_cast<size_t>(x) * sampleStride_);
+    }
+    
+    /**
+     * @brief View of a rectangle of this plane (not for bit-packed planes)
+     * @return Empty view if the rectangle is out of bounds
+     */
+    PlaneView subview(uint32_t x, uint32_t y, uint32_t width, uint32_t height) const {
+        if (static_cast<uint64_t>(x) + width > width_ ||
+            static_cast<uint64_t>(y) + height > height_) {
+            return PlaneView();
+        }
+        return PlaneView(&at(x, y), rowStride_, sampleStride_, width, height);
+    }
+    
+    /**
+     * @brief Reinterpret the samples as another type with the same geometry
+     */
+    template <typename U>
+    PlaneView<U> as() const {
+        static_assert(std::is_const<U>::value || !std::is_const<T>::value,
+                      "cannot drop const from a read-only view");
+        return PlaneView<U>(reinterpret_cast<U*>(data_), rowStride_, sampleStride_,
+                            width_, height_);
+    }
+
+private:
+    Byte* bytes() const { return reinterpret_cast<Byte*>(data_); }
+    
+    T* data_ = nullptr;
+    size_t rowStride_ = 0;
+    uint32_t sampleStride_ = 0;
+    uint32_t width_ = 0;
+    uint32_t height_ = 0;
+};
+
+/**
+ * @brief View of all planes of a mapped image
+ * 
+ * Planes follow PlaneLayout: YUV formats expose Y, Cb, Cr (semi-planar
+ * chroma as two views with a sample stride of 2 into the same bytes),
+ * every other format a single plane. Obtain one from
+ * BufferLockGuard::getImageView() or BufferMapper::getImageView().
+ * 
+ * @code
+ * BufferLockGuard guard(buffer, BufferLockGuard::LockMode::ReadWrite);
+ * ImageView image = guard.getImageView();
+ * PlaneView<uint8_t> cr = image.plane(2);
+ * for (uint32_t y = 0; y < cr.getHeight(); ++y) {
+ *     for (uint32_t x = 0; x < cr.getWidth(); ++x) {
+ *         cr.at(x, y) = 128;
+ *     }
+ * }
+ * @endcode
+ */
+template <typename Byte>
+class BasicImageView {
+public:
+    using Plane = PlaneView<Byte>;
+    
+    BasicImageView() = default;
+    
+    /**
+     * @brief Build a view from resolved plane layouts
+     * @param data Start of the mapping the layouts are relative to
+     * @param descriptor Image geometry
+     * @param layouts Plane layouts (see BufferMapper::getPlaneLayouts)
+     * @param planeCount Number of layouts
+     */
+    BasicImageView(
+        Byte* data,
+        const BufferDescriptor& descriptor,
+        const PlaneLayout* layouts,
+        uint32_t planeCount
+    )
+        : format_(descriptor.format), width_(descriptor.width), height_(descriptor.height)
+    {
+        if (!data || planeCount > kMaxPlanes) {
+            return;
+        }
+        for (uint32_t i = 0; i < planeCount; ++i) {
+            const PlaneLayout& layout = layouts[i];
+            planes_[i] = Plane(data + layout.offset, layout.rowStride, layout.sampleStride,
+                               layout.width, layout.height);
+        }
+        planeCount_ = planeCount;
+    }
+    
+    /// Views of mutable images convert to views of const images
+    template <typename U, typename = std::enable_if_t<std::is_same<const U, Byte>::value>>
+    BasicImageView(const BasicImageView<U>& other)
+        : format_(other.getFormat()), width_(other.getWidth()), height_(other.getHeight()),
+          planeCount_(other.getPlaneCount())
+    {
+        for (uint32_t i = 0; i < planeCount_; ++i) {
+            planes_[i] = other.plane(i);
+        }
+    }
+    
+    static constexpr uint32_t kMaxPlanes = 3;
+    
+    PixelFormat getFormat() const { return format_; }
+    uint32_t getWidth() const { return width_; }
+    uint32_t getHeight() const { return height_; }
+    uint32_t getPlaneCount() const { return planeCount_; }
+    
+    explicit operator bool() const { return planeCount_ > 0; }
+    
+    /**
+     * @brief Get plane i (empty view if out of range)
+     */
+    const Plane& plane(uint32_t i) const {
+        static const Plane kEmpty;
+        return i < planeCount_ ? planes_[i] : kEmpty;
+    }
+    
+    /**
+     * @brief View of a rectangle of the image
+     * 
+     * Chroma planes cover every subsampled position the rectangle
+     * touches. For RAW10/RAW12, rect.x must start a packed pixel group.
+     * 
+     * @return Empty view if the rectangle is out of bounds or misaligned
+     */
+    BasicImageView subview(const Rect& rect) const {
+        const FormatInfo& info = getFormatInfo(format_);
+        if (!*this || rect.isEmpty() ||
+            static_cast<uint64_t>(rect.x) + rect.width > width_ ||
+            static_cast<uint64_t>(rect.y) + rect.height > height_ ||
+            rect.x % info.groupPixels() != 0) {
+            return BasicImageView();
+        }
+        
+        BasicImageView view = *this;
+        view.width_ = rect.width;
+        view.height_ = rect.height;
+        for (uint32_t i = 0; i < planeCount_; ++i) {
+            const Plane& plane = planes_[i];
+            uint32_t shiftX = i > 0 ? info.chromaShiftX : 0;
+            uint32_t shiftY = i > 0 ? info.chromaShiftY : 0;
+            uint32_t x0 = rect.x >> shiftX;
+            uint32_t y0 = rect.y >> shiftY;
+            uint32_t x1 = FormatInfo::subsample(rect.x + rect.width, shiftX);
+            uint32_t y1 = FormatInfo::subsample(rect.y + rect.height, shiftY);
+            
+            // Packed planes address columns through whole pixel groups
+            size_t columnBytes = plane.getSampleStride() != 0
+                ? static_cast<size_t>(x0) * plane.getSampleStride()
+                : info.rowBytes(x0);
+            view.planes_[i] = Plane(plane.row(y0) + columnBytes, plane.getRowStride(),
+                                    plane.getSampleStride(), x1 - x0, y1 - y0);
+        }
+        return view;
+    }
+
+private:
+    PixelFormat format_ = PixelFormat::UNKNOWN;
+    uint32_t width_ = 0;
+    uint32_t height_ = 0;
+    uint32_t planeCount_ = 0;
+    Plane planes_[kMaxPlanes];
+};
+
+/// View of a writable mapping
+using ImageView = BasicImageView<uint8_t>;
+
+/// View of a read-only mapping
+using ConstImageView = BasicImageView<const uint8_t>;
+
+} // namespace graphics
+} // namespace android
@@ -0,0 +1,134 @@
+/**
+ * @file RawPacking.h
+ * @brief Unpack and pack MIPI RAW10/RAW12 Bayer data
+ * 
+ * Sensor RAW10/RAW12 buffers are bit-packed; analytics want one 16-bit
+ * sample per pixel. Row kernels are selected at runtime (AVX2, SSE4.1
+ * or scalar) like FormatConverter's.
+ */
+
+#pragma once
+
+#include "BufferTypes.h"
+#include "CpuFeatures.h"
+
+namespace android {
+namespace graphics {
+
+// Forward declarations
+class GraphicBuffer;
+
+/**
+ * @brief Conversion between packed RAW rows and 16-bit samples
+ * 
+ * Layouts (MIPI CSI-2, as used by Android RAW10/RAW12):
+ * - RAW10: 4 pixels in 5 bytes; bytes 0-3 hold bits 9:2 of each pixel,
+ *   byte 4 holds bits 1:0 of pixel 0 in its lowest two bits, and so on
+ * - RAW12: 2 pixels in 3 bytes; bytes 0-1 hold bits 11:4, byte 2 holds
+ *   bits 3:0 of pixel 0 in its low nibble and pixel 1 in its high nibble
+ * - RAW16: already one little-endian sample per pixel (plain copy)
+ * 
+ * Unpacked samples are right aligned (0..1023 for RAW10). Packing masks
+ * samples to the format's bit depth.
+ * 
+ * @code
+ * std::vector<uint16_t> samples(width * height);
+ * if (RawPacking::unpack(rawBuffer, samples.data())) {
+ *     runAnalytics(samples.data(), width, height);
+ * }
+ * @endcode
+ * 
+ * Thread Safety:
+ * - Stateless; concurrent calls on different buffers are safe
+ */
+class RawPacking {
+public:
+    /**
+     * @brief Check if a format can be unpacked (RAW10, RAW12, RAW16)
+     */
+    static bool isSupported(PixelFormat format);
+    
+    /**
+     * @brief Unpack a whole buffer to 16-bit samples
+     * @param buffer RAW buffer (locked for reading during the call)
+     * @param dst Destination samples
+     * @param dstStride Samples between destination rows (0 = width)
+     * @return True on success
+     */
+    static bool unpack(GraphicBuffer* buffer, uint16_t* dst, uint32_t dstStride = 0);
+    
+    /**
+     * @brief Pack 16-bit samples into a whole buffer
+     * @param src Source samples
+     * @param srcStride Samples between source rows (0 = width)
+     * @param buffer RAW buffer (locked for writing during the call)
+     * @return True on success
+     */
+    static bool pack(const uint16_t* src, uint32_t srcStride, GraphicBuffer* buffer);
+    
+    /**
+     * @brief Unpack an already-mapped image
+     * @param src Start of the packed image
+     * @param descriptor Image geometry (stride must be resolved)
+     * @param dst Destination samples
+     * @param dstStride Samples between destination rows (0 = width)
+     * @return True on success
+     */
+    static bool unpack(
+        const void* src,
+        const BufferDescriptor& descriptor,
+        uint16_t* dst,
+        uint32_t dstStride = 0
+    );
+    
+    /**
+     * @brief Pack samples into an already-mapped image
+     * @param src Source samples
+     * @param srcStride Samples between source rows (0 = width)
+     * @param dst Start of the packed image
+     * @param descriptor Image geometry (stride must be resolved)
+     * @return True on success
+     */
+    static bool pack(
+        const uint16_t* src,
+        uint32_t srcStride,
+        void* dst,
+        const BufferDescriptor& descriptor
+    );
+    
+    /**
+     * @brief Unpack one row
+     * @param format RAW10, RAW12 or RAW16
+     * @param packed Packed row of BufferMapper::getRowBytes(format, width) bytes
+     * @param samples Destination for width samples
+     * @param width Pixels in the row
+     */
+    static void unpackRow(
+        PixelFormat format,
+        const uint8_t* packed,
+        uint16_t* samples,
+        uint32_t width
+    );
+    
+    /**
+     * @brief Pack one row; a partial last group is padded with zeros
+     * @param format RAW10, RAW12 or RAW16
+     * @param samples Source of width samples
+     * @param packed Destination of BufferMapper::getRowBytes(format, width) bytes
+     * @param width Pixels in the row
+     */
+    static void packRow(
+        PixelFormat format,
+        const uint16_t* samples,
+        uint8_t* packed,
+        uint32_t width
+    );
+    
+    /**
+     * @brief Get the kernel level rows currently dispatch to
+     */
+    static SimdLevel getActiveLevel() { return CpuFeatures::getSimdLevel(); }
+};
+
+} // namespace graphics
+} // namespace android
@@ -0,0 +1,109 @@
+/**
+ * @file WorkStealingPool.h
+ * @brief Work-stealing thread pool for data-parallel buffer kernels
+ */
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace android {
+namespace graphics {
+
+/**
+ * @brief Thread pool that runs index ranges with per-worker queues
+ * 
+ * Features:
+ * - Each worker owns a queue seeded with a contiguous run of indices,
+ *   so neighbouring tiles stay on one core
+ * - Idle workers steal from the far end of other queues
+ * - The calling thread helps until its own batch has finished, which
+ *   also makes nested parallelFor() calls safe
+ * 
+ * @code
+ * WorkStealingPool& pool = WorkStealingPool::getShared();
+ * pool.parallelFor(bandCount, [&](uint32_t band) {
+ *     processBand(band);
+ * });
+ * @endcode
+ * 
+ * Thread Safety:
+ * - parallelFor() may be called from any thread, including workers
+ */
+class WorkStealingPool {
+public:
+    /**
+     * @brief Create a pool
+     * @param threadCount Worker threads (0 = one less than the core count)
+     */
+    explicit WorkStealingPool(uint32_t threadCount = 0);
+    
+    /**
+     * @brief Destructor - finishes queued work and joins the workers
+     */
+    ~WorkStealingPool();
+    
+    // Non-copyable
+    WorkStealingPool(const WorkStealingPool&) = delete;
+    WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+    
+    /**
+     * @brief Run fn(i) for every i in [0, count) and wait for completion
+     * @param count Number of indices
+     * @param fn Work item; invoked concurrently from several threads
+     */
+    void parallelFor(uint32_t count, const std::function<void(uint32_t index)>& fn);
+    
+    /**
+     * @brief Get the number of worker threads (excluding callers)
+     */
+    uint32_t getThreadCount() const { return static_cast<uint32_t>(workers_.size()); }
+    
+    /**
+     * @brief Get the process-wide pool sized to the machine
+     */
+    static WorkStealingPool& getShared();
+
+private:
+    struct Batch {
+        const std::function<void(uint32_t)>* fn = nullptr;
+        std::atomic<uint32_t> remaining{0};
+        std::mutex mutex;
+        std::condition_variable done;
+    };
+    
+    struct Task {
+        Batch* batch = nullptr;
+        uint32_t index = 0;
+    };
+    
+    struct Queue {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+    
+    std::vector<std::unique_ptr<Queue>> queues_;
+    std::vector<std::thread> workers_;
+    
+    // Sleeping workers wake when tasks are queued
+    std::atomic<size_t> pending_{0};
+    std::mutex sleepMutex_;
+    std::condition_variable wake_;
+    bool stopping_ = false;
+    
+    void workerLoop(size_t self);
+    bool popLocal(size_t self, Task& outTask);
+    bool steal(size_t self, Task& outTask);
+    void runTask(const Task& task);
+};
+
+} // namespace graphics
+} // namespace android
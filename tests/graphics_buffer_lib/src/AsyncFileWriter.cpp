@@ -0,0 +1,352 @@
+/**
+ * @file AsyncFileWriter.cpp
+ * @brief io_uring and worker-thread backends for AsyncFileWriter
+ */
+
+#include "AsyncFileWriter.h"
+#include <algorithm>
+#include <cerrno>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace android {
+namespace graphics {
+
+namespace {
+
+#if defined(__NR_io_uring_setup) && defined(__NR_io_uring_enter)
+
+int ioUringSetup(uint32_t entries, io_uring_params* params) {
+    return static_cast<int>(syscall(__NR_io_uring_setup, entries, params));
+}
+
+int ioUringEnter(int ringFd, uint32_t toSubmit, uint32_t minComplete, uint32_t flags) {
+    return static_cast<int>(
+        syscall(__NR_io_uring_enter, ringFd, toSubmit, minComplete, flags, nullptr, 0));
+}
+
+/**
+ * @brief Writer that submits IORING_OP_WRITE through a private ring
+ * 
+ * The rings are driven directly: the caller is the only submitter and
+ * the only reaper, so ring indices need acquire/release ordering only
+ * against the kernel.
+ */
+class IoUringWriter : public AsyncFileWriter {
+public:
+    explicit IoUringWriter(int fd) : fd_(fd) {}
+    
+    ~IoUringWriter() override {
+        // Buffers belong to the caller; never leave the kernel writing into them
+        while (inFlight_ > 0 && reap(true, [](uint32_t, int64_t) {}) > 0) {
+        }
+        if (sqes_ != MAP_FAILED) {
+            munmap(sqes_, sqesSize_);
+        }
+        if (cqRing_ != MAP_FAILED && cqRing_ != sqRing_) {
+            munmap(cqRing_, cqRingSize_);
+        }
+        if (sqRing_ != MAP_FAILED) {
+            munmap(sqRing_, sqRingSize_);
+        }
+        if (ringFd_ >= 0) {
+            close(ringFd_);
+        }
+    }
+    
+    bool init(uint32_t depth) {
+        io_uring_params params;
+        std::memset(&params, 0, sizeof(params));
+        ringFd_ = ioUringSetup(depth, &params);
+        if (ringFd_ < 0) {
+            return false;
+        }
+        
+        sqRingSize_ = params.sq_off.array + params.sq_entries * sizeof(uint32_t);
+        cqRingSize_ = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        bool singleMmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+        if (singleMmap) {
+            sqRingSize_ = cqRingSize_ = std::max(sqRingSize_, cqRingSize_);
+        }
+        
+        sqRing_ = mmap(nullptr, sqRingSize_, PROT_READ | PROT_WRITE,
+                       MAP_SHARED | MAP_POPULATE, ringFd_, IORING_OFF_SQ_RING);
+        if (sqRing_ == MAP_FAILED) {
+            return false;
+        }
+        cqRing_ = singleMmap ? sqRing_
+                             : mmap(nullptr, cqRingSize_, PROT_READ | PROT_WRITE,
+                                    MAP_SHARED | MAP_POPULATE, ringFd_, IORING_OFF_CQ_RING);
+        if (cqRing_ == MAP_FAILED) {
+            return false;
+        }
+        sqesSize_ = params.sq_entries * sizeof(io_uring_sqe);
+        sqes_ = mmap(nullptr, sqesSize_, PROT_READ | PROT_WRITE,
+                     MAP_SHARED | MAP_POPULATE, ringFd_, IORING_OFF_SQES);
+        if (sqes_ == MAP_FAILED) {
+            return false;
+        }
+        
+        uint8_t* sq = static_cast<uint8_t*>(sqRing_);
+        sqTail_ = reinterpret_cast<uint32_t*>(sq + params.sq_off.tail);
+        sqMask_ = *reinterpret_cast<uint32_t*>(sq + params.sq_off.ring_mask);
+        sqArray_ = reinterpret_cast<uint32_t*>(sq + params.sq_off.array);
+        
+        uint8_t* cq = static_cast<uint8_t*>(cqRing_);
+        cqHead_ = reinterpret_cast<uint32_t*>(cq + params.cq_off.head);
+        cqTail_ = reinterpret_cast<uint32_t*>(cq + params.cq_off.tail);
+        cqMask_ = *reinterpret_cast<uint32_t*>(cq + params.cq_off.ring_mask);
+        cqes_ = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+        
+        // The CQ ring is at least as large as the SQ ring, so it cannot overflow
+        capacity_ = std::min(depth, params.sq_entries);
+        return true;
+    }
+    
+    bool submit(uint32_t tag, const void* data, size_t size, uint64_t offset) override {
+        if (inFlight_ >= capacity_ || size > UINT32_MAX) {
+            return false;
+        }
+        
+        uint32_t tail = *sqTail_;
+        uint32_t index = tail & sqMask_;
+        io_uring_sqe* sqe = static_cast<io_uring_sqe*>(sqes_) + index;
+        std::memset(sqe, 0, sizeof(*sqe));
+        sqe->opcode = IORING_OP_WRITE;
+        sqe->fd = fd_;
+        sqe->addr = reinterpret_cast<uint64_t>(data);
+        sqe->len = static_cast<uint32_t>(size);
+        sqe->off = offset;
+        sqe->user_data = tag;
+        sqArray_[index] = index;
+        __atomic_store_n(sqTail_, tail + 1, __ATOMIC_RELEASE);
+        
+        inFlight_++;
+        unsubmitted_++;
+        enter(0, 0);
+        return true;
+    }
+    
+    uint32_t reap(bool wait, const Completion& completion) override {
+        uint32_t count = 0;
+        for (;;) {
+            uint32_t head = *cqHead_;
+            uint32_t tail = __atomic_load_n(cqTail_, __ATOMIC_ACQUIRE);
+            for (; head != tail; ++head) {
+                const io_uring_cqe& cqe = cqes_[head & cqMask_];
+                uint32_t tag = static_cast<uint32_t>(cqe.user_data);
+                int64_t result = cqe.res;
+                __atomic_store_n(cqHead_, head + 1, __ATOMIC_RELEASE);
+                inFlight_--;
+                count++;
+                completion(tag, result);
+            }
+            
+            if (count > 0 || !wait || inFlight_ == 0) {
+                if (unsubmitted_ > 0) {
+                    enter(0, 0);
+                }
+                return count;
+            }
+            if (!enter(1, IORING_ENTER_GETEVENTS)) {
+                return 0;
+            }
+        }
+    }
+    
+    uint32_t getInFlight() const override { return inFlight_; }
+    
+    const char* getName() const override { return "io_uring"; }
+
+private:
+    int fd_;
+    int ringFd_ = -1;
+    void* sqRing_ = MAP_FAILED;
+    void* cqRing_ = MAP_FAILED;
+    void* sqes_ = MAP_FAILED;
+    size_t sqRingSize_ = 0;
+    size_t cqRingSize_ = 0;
+    size_t sqesSize_ = 0;
+    
+    uint32_t* sqTail_ = nullptr;
+    uint32_t* sqArray_ = nullptr;
+    uint32_t sqMask_ = 0;
+    uint32_t* cqHead_ = nullptr;
+    uint32_t* cqTail_ = nullptr;
+    uint32_t cqMask_ = 0;
+    io_uring_cqe* cqes_ = nullptr;
+    
+    uint32_t capacity_ = 0;
+    uint32_t inFlight_ = 0;
+    uint32_t unsubmitted_ = 0;   // Queued SQEs the kernel has not consumed yet
+    
+    // Hand queued SQEs to the kernel, optionally waiting for completions
+    bool enter(uint32_t minComplete, uint32_t flags) {
+        for (;;) {
+            int ret = ioUringEnter(ringFd_, unsubmitted_, minComplete, flags);
+            if (ret >= 0) {
+                unsubmitted_ -= std::min<uint32_t>(static_cast<uint32_t>(ret), unsubmitted_);
+                return true;
+            }
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno == EAGAIN || errno == EBUSY) {
+                // SQEs stay queued for the next call; waiters retry
+                if (minComplete == 0) {
+                    return true;
+                }
+                std::this_thread::yield();
+                continue;
+            }
+            return false;
+        }
+    }
+};
+
+#endif
+
+/**
+ * @brief Writer that runs pwrite() on a dedicated thread
+ */
+class ThreadWriter : public AsyncFileWriter {
+public:
+    explicit ThreadWriter(int fd) : fd_(fd) {
+        worker_ = std::thread(&ThreadWriter::workerLoop, this);
+    }
+    
+    ~ThreadWriter() override {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopping_ = true;
+        }
+        workReady_.notify_one();
+        worker_.join();
+    }
+    
+    bool submit(uint32_t tag, const void* data, size_t size, uint64_t offset) override {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            pending_.push_back(Request{tag, data, size, offset});
+            inFlight_++;
+        }
+        workReady_.notify_one();
+        return true;
+    }
+    
+    uint32_t reap(bool wait, const Completion& completion) override {
+        std::deque<std::pair<uint32_t, int64_t>> done;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            if (wait) {
+                doneReady_.wait(lock, [this] { return !done_.empty() || inFlight_ == 0; });
+            }
+            done.swap(done_);
+            inFlight_ -= static_cast<uint32_t>(done.size());
+        }
+        for (const auto& entry : done) {
+            completion(entry.first, entry.second);
+        }
+        return static_cast<uint32_t>(done.size());
+    }
+    
+    uint32_t getInFlight() const override {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return inFlight_;
+    }
+    
+    const char* getName() const override { return "pwrite"; }
+
+private:
+    struct Request {
+        uint32_t tag;
+        const void* data;
+        size_t size;
+        uint64_t offset;
+    };
+    
+    int fd_;
+    std::deque<Request> pending_;
+    std::deque<std::pair<uint32_t, int64_t>> done_;
+    uint32_t inFlight_ = 0;
+    bool stopping_ = false;
+    mutable std::mutex mutex_;
+    std::condition_variable workReady_;
+    std::condition_variable doneReady_;
+    std::thread worker_;
+    
+    void workerLoop() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        for (;;) {
+            workReady_.wait(lock, [this] { return stopping_ || !pending_.empty(); });
+            if (pending_.empty()) {
+                return;  // Stopping with nothing left to write
+            }
+            Request request = pending_.front();
+            pending_.pop_front();
+            
+            lock.unlock();
+            int64_t result = writeFully(request);
+            lock.lock();
+            
+            done_.emplace_back(request.tag, result);
+            doneReady_.notify_one();
+        }
+    }
+    
+    int64_t writeFully(const Request& request) {
+        const uint8_t* data = static_cast<const uint8_t*>(request.data);
+        size_t written = 0;
+        while (written < request.size) {
+            ssize_t ret = pwrite(fd_, data + written, request.size - written,
+                                 static_cast<off_t>(request.offset + written));
+            if (ret < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                return -errno;
+            }
+            if (ret == 0) {
+                return -EIO;
+            }
+            written += static_cast<size_t>(ret);
+        }
+        return static_cast<int64_t>(written);
+    }
+};
+
+} // anonymous namespace
+
+std::unique_ptr<AsyncFileWriter> AsyncFileWriter::create(
+    int fd,
+    uint32_t depth,
+    bool preferIoUring
+) {
+    if (fd < 0 || depth == 0) {
+        return nullptr;
+    }
+
+#if defined(__NR_io_uring_setup) && defined(__NR_io_uring_enter)
+    if (preferIoUring) {
+        auto writer = std::make_unique<IoUringWriter>(fd);
+        if (writer->init(depth)) {
+            return writer;
+        }
+        // Not supported or blocked (seccomp, io_uring_disabled): use a thread
+    }
+#else
+    (void)preferIoUring;
+#endif
+    
+    return std::make_unique<ThreadWriter>(fd);
+}
+
+} // namespace graphics
+} // namespace android
@@ -0,0 +1,58 @@
+/**
+ * @file AsyncFileWriter.h
+ * @brief Internal asynchronous positional file writer used by FrameRecorder
+ * 
+ * Writes are submitted with a caller-chosen tag and completed out of
+ * line; the caller polls completions to recycle its buffers. The
+ * io_uring backend talks to the kernel through raw syscalls so no
+ * liburing dependency is needed, and a worker-thread pwrite() backend
+ * covers kernels or sandboxes that refuse io_uring.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+
+namespace android {
+namespace graphics {
+
+class AsyncFileWriter {
+public:
+    /// Called once per finished write with its tag and result (bytes or -errno)
+    using Completion = std::function<void(uint32_t tag, int64_t result)>;
+    
+    /**
+     * @brief Create a writer for an open file descriptor
+     * @param fd File to write (not owned)
+     * @param depth Maximum writes in flight
+     * @param preferIoUring Try io_uring before falling back to a thread
+     */
+    static std::unique_ptr<AsyncFileWriter> create(int fd, uint32_t depth, bool preferIoUring);
+    
+    virtual ~AsyncFileWriter() = default;
+    
+    /**
+     * @brief Queue a write of size bytes at offset
+     * 
+     * The data must stay valid until the write completes. At most depth
+     * writes may be in flight.
+     */
+    virtual bool submit(uint32_t tag, const void* data, size_t size, uint64_t offset) = 0;
+    
+    /**
+     * @brief Report finished writes
+     * @param wait Block until at least one write finishes (if any are in flight)
+     * @return Number of completions reported
+     */
+    virtual uint32_t reap(bool wait, const Completion& completion) = 0;
+    
+    virtual uint32_t getInFlight() const = 0;
+    
+    virtual const char* getName() const = 0;
+};
+
+} // namespace graphics
+} // namespace android
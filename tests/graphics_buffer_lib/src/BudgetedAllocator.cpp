@@ -0,0 +1,490 @@
+/**
+ * @file BudgetedAllocator.cpp
+ * @brief Implementation of BudgetedAllocator class
+ */
+
+#include "BudgetedAllocator.h"
+#include "BufferPool.h"
+#include <algorithm>
+#include <chrono>
+#include <sstream>
+
+namespace android {
+namespace graphics {
+
+namespace {
+
+// Allocator trimming pools on this thread; frees it causes meanwhile
+// leave parked requests until the trim is over
+thread_local const BudgetedAllocator* trimmingAllocator = nullptr;
+
+} // anonymous namespace
+
+BudgetedAllocator::BudgetedAllocator(
+    std::shared_ptr<IBufferAllocator> inner,
+    const MemoryBudgetConfig& config
+)
+    : inner_(std::move(inner))
+    , config_(config)
+{
+    stats_.budgetBytes = config_.budgetBytes;
+    
+    // Frees of the buffers inner_ creates must pass through the budget
+    inner_->setBufferOwner(this);
+}
+
+BudgetedAllocator::~BudgetedAllocator() {
+    std::deque<DeferredRequest> abandoned;
+    
+    {
+        std::unique_lock<std::mutex> lock(budgetMutex_);
+        abandoned.swap(deferred_);
+        
+        // Completions from the inner allocator still reference this object
+        bytesFreed_.wait(lock, [this]() { return asyncInFlight_ == 0; });
+    }
+    
+    inner_->setBufferOwner(nullptr);
+    
+    for (auto& request : abandoned) {
+        if (request.callback) {
+            request.callback(AllocationStatus::ERROR_CANCELLED, nullptr);
+        }
+    }
+}
+
+AllocationStatus BudgetedAllocator::allocate(
+    const BufferDescriptor& descriptor,
+    std::unique_ptr<GraphicBuffer>& outBuffer
+) {
+    size_t size = estimateSize(descriptor);
+    
+    if (!tryReserve(size)) {
+        relievePressure(size);
+        
+        if (!tryReserve(size)) {
+            std::unique_lock<std::mutex> lock(budgetMutex_);
+            
+            // Optionally wait for other streams to return memory
+            auto deadline = std::chrono::steady_clock::now() +
+                            std::chrono::milliseconds(config_.deferTimeoutMs);
+            bool fits = config_.deferTimeoutMs > 0 &&
+                bytesFreed_.wait_until(lock, deadline, [this, size]() {
+                    return getFootprintLocked() + size <= config_.budgetBytes;
+                });
+            
+            if (!fits) {
+                stats_.rejectedCount++;
+                return AllocationStatus::ERROR_NO_MEMORY;
+            }
+            
+            usedBytes_ += size;
+            stats_.peakUsedBytes = std::max(stats_.peakUsedBytes, getFootprintLocked());
+        }
+    }
+    
+    AllocationStatus status = inner_->allocate(descriptor, outBuffer);
+    
+    if (status != AllocationStatus::SUCCESS || !outBuffer) {
+        unreserve(size);
+        return status;
+    }
+    
+    charge(*outBuffer, size);
+    return AllocationStatus::SUCCESS;
+}
+
+AllocationStatus BudgetedAllocator::allocateBatch(
+    const BufferDescriptor& descriptor,
+    uint32_t count,
+    std::vector<std::unique_ptr<GraphicBuffer>>& outBuffers
+) {
+    size_t size = estimateSize(descriptor);
+    if (count == 0) {
+        return AllocationStatus::SUCCESS;
+    }
+    
+    if (!hasRoom(size * count)) {
+        relievePressure(size * count);
+    }
+    
+    // Reserve as much of the batch as the budget allows
+    uint32_t granted = 0;
+    while (granted < count && tryReserve(size)) {
+        granted++;
+    }
+    
+    if (granted == 0) {
+        std::lock_guard<std::mutex> lock(budgetMutex_);
+        stats_.rejectedCount++;
+        return AllocationStatus::ERROR_NO_MEMORY;
+    }
+    
+    size_t first = outBuffers.size();
+    AllocationStatus status = inner_->allocateBatch(descriptor, granted, outBuffers);
+    
+    uint32_t allocated = static_cast<uint32_t>(outBuffers.size() - first);
+    for (size_t i = first; i < outBuffers.size(); ++i) {
+        charge(*outBuffers[i], size);
+    }
+    if (allocated < granted) {
+        unreserve(size * (granted - allocated));
+    }
+    
+    if (status == AllocationStatus::SUCCESS && granted < count) {
+        std::lock_guard<std::mutex> lock(budgetMutex_);
+        stats_.rejectedCount++;
+        return AllocationStatus::ERROR_NO_MEMORY;
+    }
+    return status;
+}
+
+void BudgetedAllocator::allocateAsync(
+    const BufferDescriptor& descriptor,
+    AllocationCallback callback
+) {
+    DeferredRequest request;
+    request.descriptor = descriptor;
+    request.size = estimateSize(descriptor);
+    request.callback = std::move(callback);
+    
+    // Larger than the whole budget: it would stay parked forever
+    bool tooLarge = false;
+    {
+        std::lock_guard<std::mutex> lock(budgetMutex_);
+        if (request.size > config_.budgetBytes) {
+            stats_.rejectedCount++;
+            tooLarge = true;
+        }
+    }
+    if (tooLarge) {
+        if (request.callback) {
+            request.callback(AllocationStatus::ERROR_NO_MEMORY, nullptr);
+        }
+        return;
+    }
+    
+    bool reserved = tryReserve(request.size);
+    if (!reserved) {
+        relievePressure(request.size);
+        reserved = tryReserve(request.size);
+    }
+    
+    if (reserved) {
+        submitAsync(std::move(request));
+        return;
+    }
+    
+    {
+        std::lock_guard<std::mutex> lock(budgetMutex_);
+        if (deferred_.size() < config_.maxDeferredRequests) {
+            // Parked until enough memory is freed
+            deferred_.push_back(std::move(request));
+            stats_.deferredCount++;
+            return;
+        }
+        stats_.rejectedCount++;
+    }
+    
+    if (request.callback) {
+        request.callback(AllocationStatus::ERROR_NO_MEMORY, nullptr);
+    }
+}
+
+void BudgetedAllocator::free(GraphicBuffer* buffer) {
+    if (!buffer) return;
+    
+    {
+        std::lock_guard<std::mutex> lock(budgetMutex_);
+        
+        auto it = charges_.find(buffer->getBufferId());
+        if (it != charges_.end()) {
+            usedBytes_ -= it->second;
+            charges_.erase(it);
+        }
+    }
+    
+    inner_->free(buffer);
+    
+    bytesFreed_.notify_all();
+    if (trimmingAllocator != this) {
+        submitDeferred();
+    }
+}
+
+AllocationStatus BudgetedAllocator::importBuffer(
+    const NativeHandle& handle,
+    const BufferDescriptor& descriptor,
+    std::unique_ptr<GraphicBuffer>& outBuffer
+) {
+    // Imported memory belongs to another process and is not charged
+    return inner_->importBuffer(handle, descriptor, outBuffer);
+}
+
+BufferUsage BudgetedAllocator::getSupportedUsage() const {
+    return inner_->getSupportedUsage();
+}
+
+bool BudgetedAllocator::isFormatSupported(
+    PixelFormat format,
+    BufferUsage usage
+) const {
+    return inner_->isFormatSupported(format, usage);
+}
+
+BackingFlags BudgetedAllocator::getSupportedBackingFlags() const {
+    return inner_->getSupportedBackingFlags();
+}
+
+bool BudgetedAllocator::lockHandle(
+    const NativeHandle& handle,
+    BufferUsage usage,
+    void** outData
+) {
+    return inner_->lockHandle(handle, usage, outData);
+}
+
+bool BudgetedAllocator::unlockHandle(const NativeHandle& handle) {
+    return inner_->unlockHandle(handle);
+}
+
+void BudgetedAllocator::registerPool(BufferPool* pool) {
+    {
+        std::lock_guard<std::mutex> lock(poolsMutex_);
+        pools_.push_back(pool);
+    }
+    inner_->registerPool(pool);
+}
+
+void BudgetedAllocator::unregisterPool(BufferPool* pool) {
+    {
+        std::lock_guard<std::mutex> lock(poolsMutex_);
+        pools_.erase(std::remove(pools_.begin(), pools_.end(), pool), pools_.end());
+    }
+    inner_->unregisterPool(pool);
+}
+
+size_t BudgetedAllocator::releaseCachedMemory() {
+    return inner_->releaseCachedMemory();
+}
+
+void BudgetedAllocator::setBudget(size_t budgetBytes) {
+    bool overBudget = false;
+    
+    {
+        std::lock_guard<std::mutex> lock(budgetMutex_);
+        config_.budgetBytes = budgetBytes;
+        stats_.budgetBytes = budgetBytes;
+        overBudget = getFootprintLocked() > budgetBytes;
+    }
+    
+    if (overBudget) {
+        relievePressure(0);
+    }
+    
+    // Also fails parked requests the new budget can never fit
+    bytesFreed_.notify_all();
+    submitDeferred();
+}
+
+MemoryBudgetStatistics BudgetedAllocator::getStatistics() const {
+    std::lock_guard<std::mutex> lock(budgetMutex_);
+    
+    MemoryBudgetStatistics stats = stats_;
+    stats.usedBytes = usedBytes_;
+    stats.cachedBytes = inner_->getCachedBytes();
+    stats.deferredRequests = deferred_.size();
+    return stats;
+}
+
+std::string BudgetedAllocator::dumpState() const {
+    MemoryBudgetStatistics stats = getStatistics();
+    
+    std::ostringstream ss;
+    ss << "BudgetedAllocator State:\n";
+    ss << "  Inner allocator: " << inner_->getName() << "\n";
+    ss << "  Budget: " << stats.usedBytes << " live + " << stats.cachedBytes
+       << " cached / " << stats.budgetBytes << " bytes (peak " << stats.peakUsedBytes << ")\n";
+    ss << "  Pressure events: " << stats.pressureEvents
+       << ", reclaimed " << stats.reclaimedBytes << " bytes\n";
+    ss << "  Deferred: " << stats.deferredRequests << " pending, "
+       << stats.deferredCount << " total, rejected " << stats.rejectedCount << "\n";
+    return ss.str();
+}
+
+size_t BudgetedAllocator::estimateSize(const BufferDescriptor& descriptor) const {
+    return inner_->getAllocationSize(descriptor);
+}
+
+size_t BudgetedAllocator::getFootprintLocked() const {
+    // Warm caches of the inner allocator are memory the process holds too
+    return usedBytes_ + inner_->getCachedBytes();
+}
+
+bool BudgetedAllocator::tryReserve(size_t size) {
+    std::lock_guard<std::mutex> lock(budgetMutex_);
+    
+    if (getFootprintLocked() + size > config_.budgetBytes) {
+        return false;
+    }
+    
+    usedBytes_ += size;
+    stats_.peakUsedBytes = std::max(stats_.peakUsedBytes, getFootprintLocked());
+    return true;
+}
+
+bool BudgetedAllocator::hasRoom(size_t size) const {
+    std::lock_guard<std::mutex> lock(budgetMutex_);
+    return getFootprintLocked() + size <= config_.budgetBytes;
+}
+
+void BudgetedAllocator::unreserve(size_t size) {
+    {
+        std::lock_guard<std::mutex> lock(budgetMutex_);
+        usedBytes_ -= size;
+    }
+    
+    bytesFreed_.notify_all();
+    submitDeferred();
+}
+
+void BudgetedAllocator::charge(const GraphicBuffer& buffer, size_t reserved) {
+    // Swap the reservation for what the allocator really holds
+    size_t actual = inner_->getAllocationSize(buffer.getDescriptor());
+    
+    std::lock_guard<std::mutex> lock(budgetMutex_);
+    usedBytes_ = usedBytes_ - reserved + actual;
+    charges_[buffer.getBufferId()] = actual;
+    stats_.peakUsedBytes = std::max(stats_.peakUsedBytes, getFootprintLocked());
+}
+
+void BudgetedAllocator::relievePressure(size_t neededBytes) {
+    size_t footprintBefore = 0;
+    {
+        std::lock_guard<std::mutex> lock(budgetMutex_);
+        stats_.pressureEvents++;
+        footprintBefore = getFootprintLocked();
+    }
+    
+    // Allocator caches hold no live buffers; give those up first
+    inner_->releaseCachedMemory();
+    
+    // Then trim free buffers one at a time, only until the request fits.
+    // Parked requests are submitted after poolsMutex_ is released, so
+    // their callbacks cannot reenter it.
+    {
+        std::lock_guard<std::mutex> lock(poolsMutex_);
+        const BudgetedAllocator* outerTrim = trimmingAllocator;
+        trimmingAllocator = this;
+        for (BufferPool* pool : pools_) {
+            while (!hasRoom(neededBytes)) {
+                uint32_t freeCount = pool->getFreeCount();
+                if (freeCount == 0 || pool->shrink(freeCount - 1) == 0) {
+                    break;
+                }
+                // The freed buffer may have landed in an allocator cache
+                inner_->releaseCachedMemory();
+            }
+        }
+        trimmingAllocator = outerTrim;
+    }
+    
+    {
+        std::lock_guard<std::mutex> lock(budgetMutex_);
+        size_t footprint = getFootprintLocked();
+        if (footprint < footprintBefore) {
+            stats_.reclaimedBytes += footprintBefore - footprint;
+        }
+    }
+    submitDeferred();
+}
+
+void BudgetedAllocator::submitDeferred() {
+    bool relieved = false;
+    
+    for (;;) {
+        DeferredRequest request;
+        bool fits = false;
+        bool tooLarge = false;
+        
+        {
+            std::lock_guard<std::mutex> lock(budgetMutex_);
+            
+            // Strict FIFO so large requests are not starved
+            if (deferred_.empty()) {
+                return;
+            }
+            
+            // The budget was lowered below what this request needs
+            tooLarge = deferred_.front().size > config_.budgetBytes;
+            fits = getFootprintLocked() + deferred_.front().size <= config_.budgetBytes;
+            if (tooLarge) {
+                request = std::move(deferred_.front());
+                deferred_.pop_front();
+                stats_.rejectedCount++;
+            } else if (fits) {
+                request = std::move(deferred_.front());
+                deferred_.pop_front();
+                usedBytes_ += request.size;
+                stats_.peakUsedBytes = std::max(stats_.peakUsedBytes, getFootprintLocked());
+            } else if (relieved) {
+                return;
+            }
+        }
+        
+        if (tooLarge) {
+            if (request.callback) {
+                request.callback(AllocationStatus::ERROR_NO_MEMORY, nullptr);
+            }
+            continue;
+        }
+        
+        if (!fits) {
+            // A free often just moves bytes into the inner allocator's warm
+            // reserve, which still counts toward the footprint. Give those up
+            // once before leaving the queue parked. Pools are not trimmed as
+            // relievePressure() would, since free() may run inside one.
+            size_t released = inner_->releaseCachedMemory();
+            {
+                std::lock_guard<std::mutex> lock(budgetMutex_);
+                stats_.pressureEvents++;
+                stats_.reclaimedBytes += released;
+            }
+            bytesFreed_.notify_all();
+            relieved = true;
+            continue;
+        }
+        
+        submitAsync(std::move(request));
+    }
+}
+
+void BudgetedAllocator::submitAsync(DeferredRequest&& request) {
+    {
+        std::lock_guard<std::mutex> lock(budgetMutex_);
+        asyncInFlight_++;
+    }
+    
+    size_t reserved = request.size;
+    AllocationCallback callback = std::move(request.callback);
+    
+    inner_->allocateAsync(request.descriptor,
+        [this, reserved, callback](AllocationStatus status, GraphicBuffer* buffer) {
+            if (status == AllocationStatus::SUCCESS && buffer) {
+                charge(*buffer, reserved);
+            } else {
+                unreserve(reserved);
+            }
+            
+            if (callback) {
+                callback(status, buffer);
+            }
+            
+            std::lock_guard<std::mutex> lock(budgetMutex_);
+            asyncInFlight_--;
+            bytesFreed_.notify_all();
+        });
+}
+
+} // namespace graphics
+} // namespace android
@@ -0,0 +1,595 @@
+/**
+ * @file BufferMapper.cpp
+ * @brief Implementation of BufferLockGuard and BufferMapper classes
+ */
+
+#include "BufferMapper.h"
+#include "FormatConverter.h"
+#include "FormatTraits.h"
+#include "WorkStealingPool.h"
+#include <algorithm>
+#include <cstring>
+#include <numeric>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace android {
+namespace graphics {
+
+namespace {
+
+// Byte span of one plane as rectangle copies see it. Semi-planar
+// chroma is a single span of CbCr pairs rather than two planes.
+struct CopyPlane {
+    size_t offset = 0;
+    size_t rowStride = 0;
+    uint32_t bytesPerPixel = 0;
+    uint32_t shift = 0;          // log2 of the subsampling factor
+};
+
+bool fitsStride(const PlaneLayout& plane) {
+    // Odd YUV strides leave chroma rows narrower than the plane
+    return plane.rowStride >= static_cast<size_t>(plane.width) * plane.sampleStride;
+}
+
+uint32_t getCopyPlanes(const BufferDescriptor& descriptor, CopyPlane* outPlanes) {
+    PlaneLayout planes[BufferMapper::kMaxPlanes];
+    uint32_t count = BufferMapper::getPlaneLayouts(descriptor, planes);
+    if (count == 0) {
+        return 0;
+    }
+    
+    outPlanes[0].offset = planes[0].offset;
+    outPlanes[0].rowStride = planes[0].rowStride;
+    outPlanes[0].bytesPerPixel = planes[0].sampleStride;
+    outPlanes[0].shift = 0;
+    if (count == 1) {
+        return 1;
+    }
+    
+    for (uint32_t i = 1; i < count; ++i) {
+        if (!fitsStride(planes[i])) {
+            return 0;
+        }
+    }
+    
+    if (descriptor.format == PixelFormat::NV21 || descriptor.format == PixelFormat::NV12) {
+        outPlanes[1].offset = std::min(planes[1].offset, planes[2].offset);
+        outPlanes[1].rowStride = planes[1].rowStride;
+        outPlanes[1].bytesPerPixel = 2;
+        outPlanes[1].shift = 1;
+        return 2;
+    }
+    
+    for (uint32_t i = 1; i < count; ++i) {
+        outPlanes[i].offset = planes[i].offset;
+        outPlanes[i].rowStride = planes[i].rowStride;
+        outPlanes[i].bytesPerPixel = planes[i].sampleStride;
+        outPlanes[i].shift = 1;
+    }
+    return count;
+}
+
+bool fitsWithin(uint32_t x, uint32_t y, uint32_t width, uint32_t height,
+                const BufferDescriptor& descriptor) {
+    return static_cast<uint64_t>(x) + width <= descriptor.width &&
+           static_cast<uint64_t>(y) + height <= descriptor.height;
+}
+
+// Copy with non-temporal stores; the caller issues the closing fence
+void streamCopy(uint8_t* dst, const uint8_t* src, size_t bytes) {
+#if defined(__SSE2__)
+    // Align the destination for movntdq
+    size_t head = (16 - (reinterpret_cast<uintptr_t>(dst) & 15)) & 15;
+    head = std::min(head, bytes);
+    std::memcpy(dst, src, head);
+    dst += head;
+    src += head;
+    bytes -= head;
+    
+    for (; bytes >= 64; bytes -= 64, src += 64, dst += 64) {
+        __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src));
+        __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 16));
+        __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 32));
+        __m128i d = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 48));
+        _mm_stream_si128(reinterpret_cast<__m128i*>(dst), a);
+        _mm_stream_si128(reinterpret_cast<__m128i*>(dst + 16), b);
+        _mm_stream_si128(reinterpret_cast<__m128i*>(dst + 32), c);
+        _mm_stream_si128(reinterpret_cast<__m128i*>(dst + 48), d);
+    }
+    for (; bytes >= 16; bytes -= 16, src += 16, dst += 16) {
+        _mm_stream_si128(reinterpret_cast<__m128i*>(dst),
+                         _mm_loadu_si128(reinterpret_cast<const __m128i*>(src)));
+    }
+#endif
+    std::memcpy(dst, src, bytes);
+}
+
+} // namespace
+
+// BufferLockGuard implementation
+
+BufferLockGuard::BufferLockGuard(GraphicBuffer* buffer, LockMode mode)
+    : buffer_(buffer)
+    , locked_(false)
+{
+    if (!buffer_) return;
+    
+    if (mode == LockMode::Read) {
+        locked_ = buffer_->lockForRead(region_);
+    } else {
+        locked_ = buffer_->lockForWrite(region_);
+    }
+}
+
+BufferLockGuard::BufferLockGuard(
+    GraphicBuffer* buffer,
+    [[maybe_unused]] LockMode mode,
+    uint32_t x, uint32_t y,
+    uint32_t width, uint32_t height
+)
+    : buffer_(buffer)
+    , locked_(false)
+{
+    if (!buffer_) return;
+    
+    // Region locks are always read-write; mode only documents intent
+    locked_ = buffer_->lockRegion(x, y, width, height, region_);
+    if (locked_) {
+        rect_ = Rect{x, y, width, height};
+    }
+}
+
+BufferLockGuard::~BufferLockGuard() {
+    unlock();
+}
+
+BufferLockGuard::BufferLockGuard(BufferLockGuard&& other) noexcept
+    : buffer_(other.buffer_)
+    , region_(other.region_)
+    , rect_(other.rect_)
+    , locked_(other.locked_)
+{
+    other.buffer_ = nullptr;
+    other.region_ = MappedRegion();
+    other.rect_ = Rect();
+    other.locked_ = false;
+}
+
+void BufferLockGuard::unlock() {
+    if (locked_ && buffer_) {
+        buffer_->unlock();
+    }
+    locked_ = false;
+    region_ = MappedRegion();
+    rect_ = Rect();
+}
+
+ImageView BufferLockGuard::getImageView() {
+    return makeImageView();
+}
+
+ConstImageView BufferLockGuard::getImageView() const {
+    return makeImageView();
+}
+
+ImageView BufferLockGuard::makeImageView() const {
+    if (!locked_ || !buffer_ || !region_.data) {
+        return ImageView();
+    }
+    
+    const BufferDescriptor& descriptor = buffer_->getDescriptor();
+    uint8_t* data = static_cast<uint8_t*>(region_.data);
+    if (rect_.isEmpty()) {
+        return BufferMapper::getImageView(data, descriptor);
+    }
+    
+    // A region lock points at the rectangle origin in the first plane;
+    // step back to the mapping start so chroma planes can be reached
+    size_t origin = rect_.y * BufferMapper::getRowBytes(descriptor.format, descriptor.stride) +
+                    BufferMapper::getRowBytes(descriptor.format, rect_.x);
+    return BufferMapper::getImageView(data - origin, descriptor).subview(rect_);
+}
+
+// BufferMapper implementation
+
+size_t BufferMapper::copyFromBuffer(
+    GraphicBuffer* buffer,
+    void* dest,
+    size_t size
+) {
+    if (!dest) return 0;
+    
+    BufferLockGuard guard(buffer, BufferLockGuard::LockMode::Read);
+    if (!guard || !guard.getRawData()) {
+        return 0;
+    }
+    
+    size_t bytes = std::min(size, guard.getSize());
+    std::memcpy(dest, guard.getRawData(), bytes);
+    return bytes;
+}
+
+bool BufferMapper::copyToBuffer(
+    GraphicBuffer* buffer,
+    const void* src,
+    size_t size
+) {
+    if (!src) return false;
+    
+    BufferLockGuard guard(buffer, BufferLockGuard::LockMode::Write);
+    if (!guard || !guard.getRawData() || size > guard.getSize()) {
+        return false;
+    }
+    
+    std::memcpy(guard.getRawData(), src, size);
+    return true;
+}
+
+bool BufferMapper::fillBuffer(GraphicBuffer* buffer, uint8_t value) {
+    BufferLockGuard guard(buffer, BufferLockGuard::LockMode::Write);
+    if (!guard || !guard.getRawData()) {
+        return false;
+    }
+    
+    std::memset(guard.getRawData(), value, guard.getSize());
+    return true;
+}
+
+bool BufferMapper::processBuffer(
+    GraphicBuffer* buffer,
+    std::function<void(void* data, size_t size)> processor
+) {
+    if (!processor) return false;
+    
+    BufferLockGuard guard(buffer, BufferLockGuard::LockMode::ReadWrite);
+    if (!guard) {
+        return false;
+    }
+    
+    processor(guard.getRawData(), guard.getSize());
+    return true;
+}
+
+bool BufferMapper::processBufferTiled(
+    GraphicBuffer* buffer,
+    std::function<void(const BufferTile& tile)> processor,
+    const TileConfig& config
+) {
+    if (!processor) return false;
+    
+    BufferLockGuard guard(buffer, BufferLockGuard::LockMode::ReadWrite);
+    if (!guard || !guard.getRawData()) {
+        return false;
+    }
+    
+    const BufferDescriptor& descriptor = buffer->getDescriptor();
+    PlaneLayout planes[kMaxPlanes];
+    if (getPlaneLayouts(descriptor, planes) == 0) {
+        return false;
+    }
+    
+    const PlaneLayout& plane = planes[0];
+    uint32_t bpp = plane.sampleStride;
+    
+    // Tile columns cover whole cache lines so tiles never share one
+    uint32_t tileWidth = descriptor.width;
+    if (config.tileWidth > 0 && config.tileWidth < descriptor.width && bpp > 0) {
+        uint32_t step = kCacheLineSize / std::gcd(kCacheLineSize, bpp);
+        tileWidth = std::min(descriptor.width,
+                             (config.tileWidth + step - 1) / step * step);
+    }
+    
+    uint32_t tileHeight = config.tileHeight;
+    if (tileHeight == 0) {
+        size_t tileRowBytes = std::max<size_t>(1, getRowBytes(descriptor.format, tileWidth));
+        tileHeight = static_cast<uint32_t>(std::min<size_t>(
+            descriptor.height,
+            std::max<size_t>(1, config.targetTileBytes / tileRowBytes)));
+    }
+    if (isYuvFormat(descriptor.format)) {
+        tileHeight = (tileHeight + 1) & ~1u;  // Keep shared chroma rows whole
+    }
+    tileHeight = std::min(tileHeight, descriptor.height);
+    
+    uint32_t columns = (descriptor.width + tileWidth - 1) / tileWidth;
+    uint32_t rows = (descriptor.height + tileHeight - 1) / tileHeight;
+    uint8_t* base = static_cast<uint8_t*>(guard.getRawData());
+    
+    WorkStealingPool& pool = config.pool ? *config.pool : WorkStealingPool::getShared();
+    pool.parallelFor(columns * rows, [&](uint32_t index) {
+        BufferTile tile;
+        tile.index = index;
+        tile.x = (index % columns) * tileWidth;
+        tile.y = (index / columns) * tileHeight;
+        tile.width = std::min(tileWidth, descriptor.width - tile.x);
+        tile.height = std::min(tileHeight, descriptor.height - tile.y);
+        tile.base = base;
+        tile.rowStride = plane.rowStride;
+        tile.data = base + plane.offset + static_cast<size_t>(tile.y) * plane.rowStride +
+                    static_cast<size_t>(tile.x) * bpp;
+        processor(tile);
+    });
+    return true;
+}
+
+bool BufferMapper::copyRect(
+    GraphicBuffer* buffer,
+    const Rect& rect,
+    void* dest,
+    uint32_t destStride
+) {
+    if (!dest) return false;
+    
+    BufferLockGuard guard(buffer, BufferLockGuard::LockMode::Read);
+    if (!guard || !guard.getRawData()) {
+        return false;
+    }
+    
+    BufferDescriptor destDesc = buffer->getDescriptor();
+    destDesc.width = rect.width;
+    destDesc.height = rect.height;
+    destDesc.stride = destStride ? destStride : rect.width;
+    
+    return blit(guard.getRawData(), buffer->getDescriptor(), rect,
+                dest, destDesc, 0, 0);
+}
+
+bool BufferMapper::copyRect(
+    const void* src,
+    uint32_t srcStride,
+    GraphicBuffer* buffer,
+    const Rect& rect
+) {
+    if (!src) return false;
+    
+    BufferLockGuard guard(buffer, BufferLockGuard::LockMode::Write);
+    if (!guard || !guard.getRawData()) {
+        return false;
+    }
+    
+    BufferDescriptor srcDesc = buffer->getDescriptor();
+    srcDesc.width = rect.width;
+    srcDesc.height = rect.height;
+    srcDesc.stride = srcStride ? srcStride : rect.width;
+    
+    Rect whole{0, 0, rect.width, rect.height};
+    return blit(src, srcDesc, whole,
+                guard.getRawData(), buffer->getDescriptor(), rect.x, rect.y);
+}
+
+bool BufferMapper::blit(
+    GraphicBuffer* src,
+    const Rect& srcRect,
+    GraphicBuffer* dst,
+    uint32_t dstX,
+    uint32_t dstY
+) {
+    if (!src || !dst || src == dst) {
+        return false;
+    }
+    
+    BufferLockGuard srcGuard(src, BufferLockGuard::LockMode::Read);
+    BufferLockGuard dstGuard(dst, BufferLockGuard::LockMode::Write);
+    if (!srcGuard || !dstGuard || !srcGuard.getRawData() || !dstGuard.getRawData()) {
+        return false;
+    }
+    
+    return blit(srcGuard.getRawData(), src->getDescriptor(), srcRect,
+                dstGuard.getRawData(), dst->getDescriptor(), dstX, dstY);
+}
+
+bool BufferMapper::blit(
+    const void* src,
+    const BufferDescriptor& srcDesc,
+    const Rect& srcRect,
+    void* dst,
+    const BufferDescriptor& dstDesc,
+    uint32_t dstX,
+    uint32_t dstY
+) {
+    if (!src || !dst || srcRect.isEmpty() || srcDesc.format != dstDesc.format) {
+        return false;
+    }
+    
+    // Packed RAW pixels do not start on byte boundaries
+    if (srcDesc.format == PixelFormat::RAW10 || srcDesc.format == PixelFormat::RAW12) {
+        return false;
+    }
+    
+    if (!fitsWithin(srcRect.x, srcRect.y, srcRect.width, srcRect.height, srcDesc) ||
+        !fitsWithin(dstX, dstY, srcRect.width, srcRect.height, dstDesc)) {
+        return false;
+    }
+    
+    // Subsampled chroma cannot be split between pixel pairs
+    if (isYuvFormat(srcDesc.format) && ((srcRect.x | srcRect.y | dstX | dstY) & 1)) {
+        return false;
+    }
+    
+    CopyPlane srcPlanes[kMaxPlanes];
+    CopyPlane dstPlanes[kMaxPlanes];
+    uint32_t count = getCopyPlanes(srcDesc, srcPlanes);
+    if (count == 0 || getCopyPlanes(dstDesc, dstPlanes) != count) {
+        return false;
+    }
+    
+    const uint8_t* in = static_cast<const uint8_t*>(src);
+    uint8_t* out = static_cast<uint8_t*>(dst);
+    
+    for (uint32_t i = 0; i < count; ++i) {
+        const CopyPlane& sp = srcPlanes[i];
+        const CopyPlane& dp = dstPlanes[i];
+        uint32_t round = (1u << sp.shift) - 1;
+        
+        uint32_t x = srcRect.x >> sp.shift;
+        uint32_t y = srcRect.y >> sp.shift;
+        uint32_t width = ((srcRect.x + srcRect.width + round) >> sp.shift) - x;
+        uint32_t height = ((srcRect.y + srcRect.height + round) >> sp.shift) - y;
+        
+        copyRows(in + sp.offset + y * sp.rowStride + static_cast<size_t>(x) * sp.bytesPerPixel,
+                 sp.rowStride,
+                 out + dp.offset + (dstY >> sp.shift) * dp.rowStride +
+                     static_cast<size_t>(dstX >> sp.shift) * dp.bytesPerPixel,
+                 dp.rowStride,
+                 static_cast<size_t>(width) * sp.bytesPerPixel,
+                 height);
+    }
+    return true;
+}
+
+void BufferMapper::copyRows(
+    const void* src,
+    size_t srcStride,
+    void* dst,
+    size_t dstStride,
+    size_t rowBytes,
+    uint32_t rows
+) {
+    const uint8_t* in = static_cast<const uint8_t*>(src);
+    uint8_t* out = static_cast<uint8_t*>(dst);
+    
+    // Unpadded images are one contiguous copy
+    if (rowBytes == srcStride && rowBytes == dstStride) {
+        rowBytes *= rows;
+        rows = rows ? 1 : 0;
+    }
+    
+    bool stream = rowBytes * rows >= kNonTemporalThreshold;
+    for (uint32_t row = 0; row < rows; ++row) {
+        if (stream) {
+            streamCopy(out + row * dstStride, in + row * srcStride, rowBytes);
+        } else {
+            std::memcpy(out + row * dstStride, in + row * srcStride, rowBytes);
+        }
+    }
+
+#if defined(__SSE2__)
+    if (stream) {
+        _mm_sfence();  // Order streaming stores before the unlock
+    }
+#endif
+}
+
+uint32_t BufferMapper::calculateStride(PixelFormat format, uint32_t width) {
+    return static_cast<uint32_t>(getRowBytes(format, width));
+}
+
+uint32_t BufferMapper::calculateAlignedStride(
+    PixelFormat format,
+    uint32_t width,
+    uint32_t alignment
+) {
+    const FormatInfo& info = getFormatInfo(format);
+    
+    // Smallest pixel step whose byte size is a multiple of alignment;
+    // packed formats step in whole pixel groups
+    uint32_t step = info.groupPixels();
+    if (alignment > 1) {
+        step *= alignment / std::gcd(alignment, info.groupBytes());
+    }
+    step = std::lcm(step, info.strideAlignment);
+    
+    return (width + step - 1) / step * step;
+}
+
+uint32_t BufferMapper::getBytesPerPixel(PixelFormat format) {
+    return getFormatInfo(format).bytesPerPixel();
+}
+
+uint32_t BufferMapper::getPlaneLayouts(
+    const BufferDescriptor& descriptor,
+    PlaneLayout* outPlanes
+) {
+    if (!descriptor.isValid() || !outPlanes) {
+        return 0;
+    }
+    
+    const FormatInfo& info = getFormatInfo(descriptor.format);
+    uint32_t stride = std::max(descriptor.stride, descriptor.width);
+    
+    // Bit-packed samples have no byte stride
+    PlaneLayout& y = outPlanes[0];
+    y.offset = 0;
+    y.rowStride = static_cast<uint32_t>(info.rowBytes(stride));
+    y.sampleStride = info.isPacked() ? 0 : info.bytesPerPixel();
+    y.width = descriptor.width;
+    y.height = descriptor.height;
+    if (info.planeCount == 1) {
+        return 1;
+    }
+    
+    uint32_t chromaWidth = FormatInfo::subsample(descriptor.width, info.chromaShiftX);
+    uint32_t chromaHeight = FormatInfo::subsample(descriptor.height, info.chromaShiftY);
+    size_t lumaSize = static_cast<size_t>(y.rowStride) * descriptor.height;
+    
+    PlaneLayout& cb = outPlanes[1];
+    PlaneLayout& cr = outPlanes[2];
+    PlaneLayout& first = info.crFirst ? cr : cb;
+    PlaneLayout& second = info.crFirst ? cb : cr;
+    
+    if (info.planeCount == 2) {
+        // Interleaved chroma: NV12 is CbCr, NV21 is CrCb
+        first.offset = lumaSize;
+        second.offset = lumaSize + 1;
+        for (PlaneLayout* c : {&cb, &cr}) {
+            c->rowStride = stride;
+            c->sampleStride = 2;
+        }
+    } else {
+        // Fully planar: Y, then the first chroma plane, then the second
+        uint32_t chromaStride = stride >> info.chromaShiftX;
+        first.offset = lumaSize;
+        second.offset = lumaSize + static_cast<size_t>(chromaStride) * chromaHeight;
+        for (PlaneLayout* c : {&cb, &cr}) {
+            c->rowStride = chromaStride;
+            c->sampleStride = 1;
+        }
+    }
+    
+    for (PlaneLayout* c : {&cb, &cr}) {
+        c->width = chromaWidth;
+        c->height = chromaHeight;
+    }
+    return 3;
+}
+
+static_assert(ImageView::kMaxPlanes == BufferMapper::kMaxPlanes,
+              "image views hold every plane layout");
+
+ImageView BufferMapper::getImageView(void* data, const BufferDescriptor& descriptor) {
+    PlaneLayout planes[kMaxPlanes];
+    uint32_t count = data ? getPlaneLayouts(descriptor, planes) : 0;
+    if (count == 0) {
+        return ImageView();
+    }
+    return ImageView(static_cast<uint8_t*>(data), descriptor, planes, count);
+}
+
+ConstImageView BufferMapper::getImageView(
+    const void* data,
+    const BufferDescriptor& descriptor
+) {
+    return getImageView(const_cast<void*>(data), descriptor);
+}
+
+bool BufferMapper::convertBuffer(GraphicBuffer* src, GraphicBuffer* dst) {
+    return FormatConverter::convert(src, dst);
+}
+
+size_t BufferMapper::getRowBytes(PixelFormat format, uint32_t width) {
+    return getFormatInfo(format).rowBytes(width);
+}
+
+bool BufferMapper::isYuvFormat(PixelFormat format) {
+    return getFormatInfo(format).yuv;
+}
+
+bool BufferMapper::isCompressedFormat(PixelFormat format) {
+    return getFormatInfo(format).compressed;
+}
+
+} // namespace graphics
+} // namespace android
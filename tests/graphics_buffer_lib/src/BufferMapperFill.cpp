@@ -0,0 +1,453 @@
+/**
+ * @file BufferMapperFill.cpp
+ * @brief BufferMapper fill primitives and test pattern generators
+ * 
+ * Constant fills expand the encoded pixel into a short repeating period
+ * and store it with the widest vector unit available. Patterns encode
+ * one prototype row per row type and replicate it down the image.
+ */
+
+#include "BufferMapper.h"
+#include "CpuFeatures.h"
+#include "FormatTraits.h"
+#include "RawPacking.h"
+#include <algorithm>
+#include <cstring>
+#include <numeric>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+namespace android {
+namespace graphics {
+
+namespace {
+
+constexpr size_t kVectorBytes = 32;
+constexpr size_t kMaxPeriodBytes = 160;    // lcm(5, 32) for RAW10 groups
+constexpr uint32_t kCheckerSize = 32;
+
+/**
+ * Encoded pixel group repeated to a whole number of vectors
+ */
+struct FillPeriod {
+    uint8_t bytes[kMaxPeriodBytes];
+    size_t size = 0;
+};
+
+FillPeriod makePeriod(const uint8_t* unit, size_t unitBytes) {
+    FillPeriod period;
+    period.size = unitBytes / std::gcd(unitBytes, kVectorBytes) * kVectorBytes;
+    for (size_t i = 0; i < period.size; ++i) {
+        period.bytes[i] = unit[i % unitBytes];
+    }
+    return period;
+}
+
+using FillRowFn = void (*)(uint8_t* dst, size_t bytes, const FillPeriod& period);
+
+void fillRowScalar(uint8_t* dst, size_t bytes, const FillPeriod& period) {
+    for (; bytes >= period.size; bytes -= period.size, dst += period.size) {
+        std::memcpy(dst, period.bytes, period.size);
+    }
+    std::memcpy(dst, period.bytes, bytes);
+}
+
+#if defined(__SSE2__)
+void fillRowSse2(uint8_t* dst, size_t bytes, const FillPeriod& period) {
+    __m128i vectors[kMaxPeriodBytes / 16];
+    size_t count = period.size / 16;
+    for (size_t i = 0; i < count; ++i) {
+        vectors[i] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(period.bytes + i * 16));
+    }
+    
+    size_t offset = 0;
+    size_t next = 0;
+    for (; offset + 16 <= bytes; offset += 16) {
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + offset), vectors[next]);
+        next = next + 1 == count ? 0 : next + 1;
+    }
+    std::memcpy(dst + offset, period.bytes + next * 16, bytes - offset);
+}
+#endif
+
+#if defined(__x86_64__) || defined(__i386__)
+__attribute__((target("avx2")))
+void fillRowAvx2(uint8_t* dst, size_t bytes, const FillPeriod& period) {
+    __m256i vectors[kMaxPeriodBytes / 32];
+    size_t count = period.size / 32;
+    for (size_t i = 0; i < count; ++i) {
+        vectors[i] = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(period.bytes + i * 32));
+    }
+    
+    size_t offset = 0;
+    size_t next = 0;
+    for (; offset + 32 <= bytes; offset += 32) {
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + offset), vectors[next]);
+        next = next + 1 == count ? 0 : next + 1;
+    }
+    std::memcpy(dst + offset, period.bytes + next * 32, bytes - offset);
+}
+#endif
+
+FillRowFn selectFillRow() {
+    switch (CpuFeatures::getSimdLevel()) {
+#if defined(__x86_64__) || defined(__i386__)
+        case SimdLevel::AVX2:
+            return fillRowAvx2;
+#endif
+#if defined(__SSE2__)
+        case SimdLevel::SSE4_1:
+            return fillRowSse2;
+#endif
+        default:
+            return fillRowScalar;
+    }
+}
+
+void fillPlane(
+    uint8_t* dst, size_t rowStride, size_t rowBytes, uint32_t rows,
+    const FillPeriod& period, FillRowFn fillRow
+) {
+    if (rowBytes == 0 || period.size == 0) {
+        return;
+    }
+    for (uint32_t row = 0; row < rows; ++row) {
+        fillRow(dst + row * rowStride, rowBytes, period);
+    }
+}
+
+// ============================================================================
+// Pixel encoding
+// ============================================================================
+
+struct YuvColor {
+    uint8_t y;
+    uint8_t cb;
+    uint8_t cr;
+};
+
+// BT.601 limited range, the inverse of FormatConverter's YUV -> RGB
+YuvColor toYuv(const Color& c) {
+    YuvColor yuv;
+    yuv.y = static_cast<uint8_t>(((66 * c.r + 129 * c.g + 25 * c.b + 128) >> 8) + 16);
+    yuv.cb = static_cast<uint8_t>(((-38 * c.r - 74 * c.g + 112 * c.b + 128) >> 8) + 128);
+    yuv.cr = static_cast<uint8_t>(((112 * c.r - 94 * c.g - 18 * c.b + 128) >> 8) + 128);
+    return yuv;
+}
+
+uint32_t getRawBits(PixelFormat format) {
+    const FormatInfo& info = getFormatInfo(format);
+    return info.raw ? info.sampleBits : 0;
+}
+
+uint16_t toRawSample(const Color& c, uint32_t bits) {
+    uint32_t luma = (77 * c.r + 150 * c.g + 29 * c.b) >> 8;
+    return static_cast<uint16_t>(luma * ((1u << bits) - 1) / 255);
+}
+
+/**
+ * Encode one pixel of a packed RGB format. Returns bytes per pixel,
+ * or 0 if the format has no RGB encoding.
+ */
+size_t encodeRgb(PixelFormat format, const Color& c, uint8_t* out) {
+    switch (format) {
+        case PixelFormat::RGBA_8888:
+            out[0] = c.r; out[1] = c.g; out[2] = c.b; out[3] = c.a;
+            return 4;
+        case PixelFormat::RGBX_8888:
+            out[0] = c.r; out[1] = c.g; out[2] = c.b; out[3] = 0xFF;
+            return 4;
+        case PixelFormat::BGRA_8888:
+            out[0] = c.b; out[1] = c.g; out[2] = c.r; out[3] = c.a;
+            return 4;
+        case PixelFormat::RGB_888:
+            out[0] = c.r; out[1] = c.g; out[2] = c.b;
+            return 3;
+        case PixelFormat::RGB_565: {
+            uint16_t pixel = static_cast<uint16_t>((c.r >> 3) << 11 | (c.g >> 2) << 5 | c.b >> 3);
+            out[0] = static_cast<uint8_t>(pixel);
+            out[1] = static_cast<uint8_t>(pixel >> 8);
+            return 2;
+        }
+        default:
+            return 0;
+    }
+}
+
+bool isFillable(PixelFormat format) {
+    uint8_t scratch[4];
+    return BufferMapper::isYuvFormat(format) || getRawBits(format) != 0 ||
+           encodeRgb(format, Color(), scratch) != 0;
+}
+
+// ============================================================================
+// Constant fills
+// ============================================================================
+
+void fillYuvPlanes(uint8_t* base, const BufferDescriptor& descriptor, YuvColor color) {
+    PlaneLayout planes[BufferMapper::kMaxPlanes];
+    BufferMapper::getPlaneLayouts(descriptor, planes);
+    FillRowFn fillRow = selectFillRow();
+    
+    fillPlane(base + planes[0].offset, planes[0].rowStride, planes[0].width, planes[0].height,
+              makePeriod(&color.y, 1), fillRow);
+    
+    const PlaneLayout& cb = planes[1];
+    const PlaneLayout& cr = planes[2];
+    if (cb.sampleStride == 2) {
+        // Semi-planar: one span of interleaved pairs
+        bool cbFirst = cb.offset < cr.offset;
+        uint8_t pair[2] = {cbFirst ? color.cb : color.cr, cbFirst ? color.cr : color.cb};
+        fillPlane(base + std::min(cb.offset, cr.offset), cb.rowStride,
+                  static_cast<size_t>(cb.width) * 2, cb.height, makePeriod(pair, 2), fillRow);
+    } else {
+        fillPlane(base + cb.offset, cb.rowStride, cb.width, cb.height,
+                  makePeriod(&color.cb, 1), fillRow);
+        fillPlane(base + cr.offset, cr.rowStride, cr.width, cr.height,
+                  makePeriod(&color.cr, 1), fillRow);
+    }
+}
+
+void fillRawPlane(uint8_t* base, const BufferDescriptor& descriptor, uint16_t sample) {
+    PlaneLayout planes[BufferMapper::kMaxPlanes];
+    BufferMapper::getPlaneLayouts(descriptor, planes);
+    
+    uint16_t samples[4] = {sample, sample, sample, sample};
+    uint8_t unit[5];
+    uint32_t group = getFormatInfo(descriptor.format).groupPixels();
+    RawPacking::packRow(descriptor.format, samples, unit, group);
+    size_t unitBytes = BufferMapper::getRowBytes(descriptor.format, group);
+    size_t rowBytes = BufferMapper::getRowBytes(descriptor.format, descriptor.width);
+    
+    fillPlane(base + planes[0].offset, planes[0].rowStride, rowBytes, descriptor.height,
+              makePeriod(unit, unitBytes), selectFillRow());
+}
+
+// ============================================================================
+// Patterns
+// ============================================================================
+
+uint32_t getRowType(TestPattern pattern, uint32_t y) {
+    return pattern == TestPattern::CHECKERBOARD ? (y / kCheckerSize) & 1 : 0;
+}
+
+Color getPatternColor(TestPattern pattern, uint32_t x, uint32_t width, uint32_t rowType) {
+    // 75% SMPTE order: white, yellow, cyan, green, magenta, red, blue, black
+    static const Color kBars[8] = {
+        {191, 191, 191, 255}, {191, 191, 0, 255}, {0, 191, 191, 255}, {0, 191, 0, 255},
+        {191, 0, 191, 255}, {191, 0, 0, 255}, {0, 0, 191, 255}, {0, 0, 0, 255}
+    };
+    
+    switch (pattern) {
+        case TestPattern::COLOR_BARS:
+            return kBars[static_cast<uint64_t>(x) * 8 / width];
+        case TestPattern::GRADIENT: {
+            uint8_t level = static_cast<uint8_t>(width > 1 ? x * 255u / (width - 1) : 0);
+            return Color{level, level, level, 255};
+        }
+        case TestPattern::CHECKERBOARD: {
+            uint8_t level = ((x / kCheckerSize + rowType) & 1) ? 255 : 0;
+            return Color{level, level, level, 255};
+        }
+    }
+    return Color();
+}
+
+/**
+ * Rows of one plane plus its encoded prototype row per row type
+ */
+struct PatternPlane {
+    size_t offset = 0;
+    size_t rowStride = 0;
+    uint32_t rows = 0;
+    uint32_t subsample = 1;             // Image rows per plane row
+    std::vector<uint8_t> prototypes[2];
+};
+
+std::vector<PatternPlane> buildPatternPlanes(
+    const BufferDescriptor& descriptor,
+    TestPattern pattern
+) {
+    PlaneLayout planes[BufferMapper::kMaxPlanes];
+    BufferMapper::getPlaneLayouts(descriptor, planes);
+    bool yuv = BufferMapper::isYuvFormat(descriptor.format);
+    bool semiPlanar = yuv && planes[1].sampleStride == 2;
+    
+    std::vector<PatternPlane> result(yuv ? (semiPlanar ? 2 : 3) : 1);
+    result[0].offset = planes[0].offset;
+    result[0].rowStride = planes[0].rowStride;
+    result[0].rows = planes[0].height;
+    if (yuv) {
+        for (size_t i = 1; i < result.size(); ++i) {
+            const PlaneLayout& plane = planes[i];
+            result[i].offset = semiPlanar ? std::min(planes[1].offset, planes[2].offset)
+                                          : plane.offset;
+            result[i].rowStride = plane.rowStride;
+            result[i].rows = plane.height;
+            result[i].subsample = 2;
+        }
+    }
+    
+    uint32_t width = descriptor.width;
+    uint32_t rowTypes = pattern == TestPattern::CHECKERBOARD ? 2 : 1;
+    std::vector<Color> colors(width);
+    
+    for (uint32_t type = 0; type < rowTypes; ++type) {
+        for (uint32_t x = 0; x < width; ++x) {
+            colors[x] = getPatternColor(pattern, x, width, type);
+        }
+        
+        if (yuv) {
+            uint32_t chromaWidth = planes[1].width;
+            bool cbFirst = planes[1].offset < planes[2].offset;
+            std::vector<uint8_t>& luma = result[0].prototypes[type];
+            luma.resize(width);
+            for (uint32_t x = 0; x < width; ++x) {
+                luma[x] = toYuv(colors[x]).y;
+            }
+            
+            // Chroma takes the left pixel of each pair
+            for (size_t i = 1; i < result.size(); ++i) {
+                result[i].prototypes[type].resize(semiPlanar ? chromaWidth * 2 : chromaWidth);
+            }
+            for (uint32_t cx = 0; cx < chromaWidth; ++cx) {
+                YuvColor c = toYuv(colors[cx * 2]);
+                if (semiPlanar) {
+                    result[1].prototypes[type][cx * 2] = cbFirst ? c.cb : c.cr;
+                    result[1].prototypes[type][cx * 2 + 1] = cbFirst ? c.cr : c.cb;
+                } else {
+                    result[1].prototypes[type][cx] = c.cb;
+                    result[2].prototypes[type][cx] = c.cr;
+                }
+            }
+            continue;
+        }
+        
+        uint32_t bits = getRawBits(descriptor.format);
+        std::vector<uint8_t>& row = result[0].prototypes[type];
+        if (bits != 0) {
+            std::vector<uint16_t> samples(width);
+            for (uint32_t x = 0; x < width; ++x) {
+                samples[x] = toRawSample(colors[x], bits);
+            }
+            row.resize(BufferMapper::getRowBytes(descriptor.format, width));
+            RawPacking::packRow(descriptor.format, samples.data(), row.data(), width);
+        } else {
+            uint8_t pixel[4];
+            size_t bpp = encodeRgb(descriptor.format, colors[0], pixel);
+            row.resize(width * bpp);
+            for (uint32_t x = 0; x < width; ++x) {
+                encodeRgb(descriptor.format, colors[x], row.data() + x * bpp);
+            }
+        }
+    }
+    return result;
+}
+
+} // namespace
+
+bool BufferMapper::fillColor(GraphicBuffer* buffer, const Color& color) {
+    if (!buffer || !isFillable(buffer->getFormat())) {
+        return false;
+    }
+    
+    BufferLockGuard guard(buffer, BufferLockGuard::LockMode::Write);
+    if (!guard || !guard.getRawData()) {
+        return false;
+    }
+    
+    const BufferDescriptor& descriptor = buffer->getDescriptor();
+    uint8_t* base = guard.getData<uint8_t>();
+    
+    if (isYuvFormat(descriptor.format)) {
+        fillYuvPlanes(base, descriptor, toYuv(color));
+        return true;
+    }
+    
+    uint32_t bits = getRawBits(descriptor.format);
+    if (bits != 0) {
+        fillRawPlane(base, descriptor, toRawSample(color, bits));
+        return true;
+    }
+    
+    PlaneLayout planes[kMaxPlanes];
+    getPlaneLayouts(descriptor, planes);
+    uint8_t unit[4];
+    size_t bpp = encodeRgb(descriptor.format, color, unit);
+    fillPlane(base + planes[0].offset, planes[0].rowStride,
+              static_cast<size_t>(descriptor.width) * bpp, descriptor.height,
+              makePeriod(unit, bpp), selectFillRow());
+    return true;
+}
+
+bool BufferMapper::fillYuv(GraphicBuffer* buffer, uint8_t y, uint8_t cb, uint8_t cr) {
+    if (!buffer || !isYuvFormat(buffer->getFormat())) {
+        return false;
+    }
+    
+    BufferLockGuard guard(buffer, BufferLockGuard::LockMode::Write);
+    if (!guard || !guard.getRawData()) {
+        return false;
+    }
+    
+    fillYuvPlanes(guard.getData<uint8_t>(), buffer->getDescriptor(), YuvColor{y, cb, cr});
+    return true;
+}
+
+bool BufferMapper::fillRaw(GraphicBuffer* buffer, uint16_t sample) {
+    if (!buffer) return false;
+    
+    uint32_t bits = getRawBits(buffer->getFormat());
+    if (bits == 0) {
+        return false;
+    }
+    
+    BufferLockGuard guard(buffer, BufferLockGuard::LockMode::Write);
+    if (!guard || !guard.getRawData()) {
+        return false;
+    }
+    
+    uint16_t maxSample = static_cast<uint16_t>((1u << bits) - 1);
+    fillRawPlane(guard.getData<uint8_t>(), buffer->getDescriptor(),
+                 std::min(sample, maxSample));
+    return true;
+}
+
+bool BufferMapper::fillPattern(GraphicBuffer* buffer, TestPattern pattern) {
+    if (!buffer || !isFillable(buffer->getFormat())) {
+        return false;
+    }
+    
+    BufferLockGuard guard(buffer, BufferLockGuard::LockMode::Write);
+    if (!guard || !guard.getRawData()) {
+        return false;
+    }
+    
+    uint8_t* base = guard.getData<uint8_t>();
+    std::vector<PatternPlane> planes = buildPatternPlanes(buffer->getDescriptor(), pattern);
+    
+    // Replicate each prototype over its run of rows
+    for (const PatternPlane& plane : planes) {
+        uint32_t row = 0;
+        while (row < plane.rows) {
+            uint32_t type = getRowType(pattern, row * plane.subsample);
+            uint32_t end = row + 1;
+            while (end < plane.rows && getRowType(pattern, end * plane.subsample) == type) {
+                ++end;
+            }
+            
+            const std::vector<uint8_t>& prototype = plane.prototypes[type];
+            copyRows(prototype.data(), 0,
+                     base + plane.offset + row * plane.rowStride, plane.rowStride,
+                     prototype.size(), end - row);
+            row = end;
+        }
+    }
+    return true;
+}
+
+} // namespace graphics
+} // namespace android
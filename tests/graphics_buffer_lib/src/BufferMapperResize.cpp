@@ -0,0 +1,431 @@
+/**
+ * @file BufferMapperResize.cpp
+ * @brief BufferMapper resize operations and their scalar kernels
+ * 
+ * Each plane is scaled independently in bands of output rows. Exact 2x
+ * and 4x downscales average whole blocks in one pass; other ratios run a
+ * vectorized vertical pass into a scratch row followed by a horizontal
+ * pass over precomputed taps.
+ */
+
+#include "BufferMapper.h"
+#include "BufferPool.h"
+#include "CpuFeatures.h"
+#include "ResizeKernels.h"
+#include "WorkStealingPool.h"
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+namespace android {
+namespace graphics {
+
+namespace kernels {
+
+void blendRowsScalar(
+    const uint8_t* r0, const uint8_t* r1, uint8_t* out, size_t bytes, uint32_t weight
+) {
+    const uint32_t inverse = 256 - weight;
+    for (size_t i = 0; i < bytes; ++i) {
+        out[i] = static_cast<uint8_t>((r0[i] * inverse + r1[i] * weight + 128) >> 8);
+    }
+}
+
+void accumulateRowScalar(const uint8_t* row, uint32_t* acc, size_t bytes) {
+    for (size_t i = 0; i < bytes; ++i) {
+        acc[i] += row[i];
+    }
+}
+
+void downscale2xScalar(
+    const uint8_t* r0, const uint8_t* r1, uint8_t* out, uint32_t dstWidth, uint32_t channels
+) {
+    for (uint32_t x = 0; x < dstWidth; ++x) {
+        for (uint32_t c = 0; c < channels; ++c) {
+            size_t i = static_cast<size_t>(2 * x) * channels + c;
+            uint32_t sum = r0[i] + r0[i + channels] + r1[i] + r1[i + channels];
+            out[static_cast<size_t>(x) * channels + c] = static_cast<uint8_t>((sum + 2) >> 2);
+        }
+    }
+}
+
+void downscale4xScalar(
+    const uint8_t* const* rows, uint8_t* out, uint32_t dstWidth, uint32_t channels
+) {
+    for (uint32_t x = 0; x < dstWidth; ++x) {
+        for (uint32_t c = 0; c < channels; ++c) {
+            size_t i = static_cast<size_t>(4 * x) * channels + c;
+            uint32_t sum = 0;
+            for (uint32_t r = 0; r < 4; ++r) {
+                for (uint32_t k = 0; k < 4; ++k) {
+                    sum += rows[r][i + k * channels];
+                }
+            }
+            out[static_cast<size_t>(x) * channels + c] = static_cast<uint8_t>((sum + 8) >> 4);
+        }
+    }
+}
+
+const ResizeKernels& getScalarResizeKernels() {
+    static const ResizeKernels scalar = {
+        blendRowsScalar,
+        accumulateRowScalar,
+        downscale2xScalar,
+        downscale4xScalar
+    };
+    return scalar;
+}
+
+} // namespace kernels
+
+namespace {
+
+/// Output rows per parallel work item
+constexpr uint32_t kResizeBandRows = 16;
+
+const kernels::ResizeKernels& selectKernels() {
+#if defined(__x86_64__) || defined(__i386__)
+    switch (CpuFeatures::getSimdLevel()) {
+        case SimdLevel::AVX2:
+            return kernels::getAvx2ResizeKernels();
+        case SimdLevel::SSE4_1:
+            return kernels::getSse41ResizeKernels();
+        default:
+            break;
+    }
+#endif
+    return kernels::getScalarResizeKernels();
+}
+
+bool isResizable(PixelFormat format) {
+    switch (format) {
+        case PixelFormat::RGBA_8888:
+        case PixelFormat::RGBX_8888:
+        case PixelFormat::BGRA_8888:
+        case PixelFormat::NV21:
+        case PixelFormat::NV12:
+        case PixelFormat::YV12:
+            return true;
+        default:
+            return false;
+    }
+}
+
+// One plane as seen by the resize passes (interleaved chroma is one plane)
+struct ResizePlane {
+    size_t offset = 0;
+    size_t rowStride = 0;
+    uint32_t width = 0;
+    uint32_t height = 0;
+    uint32_t channels = 0;
+};
+
+uint32_t getResizePlanes(const BufferDescriptor& descriptor, ResizePlane* outPlanes) {
+    PlaneLayout planes[BufferMapper::kMaxPlanes];
+    uint32_t count = BufferMapper::getPlaneLayouts(descriptor, planes);
+    if (count == 0) {
+        return 0;
+    }
+    
+    auto toResizePlane = [](const PlaneLayout& plane, size_t offset, uint32_t channels) {
+        ResizePlane out;
+        out.offset = offset;
+        out.rowStride = plane.rowStride;
+        out.width = plane.width;
+        out.height = plane.height;
+        out.channels = channels;
+        return out;
+    };
+    
+    if (count == 1) {
+        outPlanes[0] = toResizePlane(planes[0], planes[0].offset, planes[0].sampleStride);
+        return 1;
+    }
+    
+    outPlanes[0] = toResizePlane(planes[0], planes[0].offset, 1);
+    if (planes[1].sampleStride == 2) {
+        outPlanes[1] = toResizePlane(planes[1], std::min(planes[1].offset, planes[2].offset), 2);
+        return 2;
+    }
+    outPlanes[1] = toResizePlane(planes[1], planes[1].offset, 1);
+    outPlanes[2] = toResizePlane(planes[2], planes[2].offset, 1);
+    return 3;
+}
+
+bool fitsStride(const ResizePlane& plane) {
+    // Odd YUV strides leave chroma rows narrower than the plane
+    return plane.rowStride >= static_cast<size_t>(plane.width) * plane.channels;
+}
+
+// Source span [begin, end) averaged into one box-filtered output sample
+struct BoxSpan {
+    uint32_t begin;
+    uint32_t end;
+};
+
+// Source pair and 8-bit weight of the second sample for bilinear output
+struct BilinearTap {
+    uint32_t i0;
+    uint32_t i1;
+    uint32_t weight;
+};
+
+std::vector<BoxSpan> makeBoxSpans(uint32_t srcSize, uint32_t dstSize) {
+    std::vector<BoxSpan> spans(dstSize);
+    for (uint32_t d = 0; d < dstSize; ++d) {
+        uint32_t begin = static_cast<uint32_t>(static_cast<uint64_t>(d) * srcSize / dstSize);
+        uint32_t end = static_cast<uint32_t>(static_cast<uint64_t>(d + 1) * srcSize / dstSize);
+        spans[d] = {begin, std::max(end, begin + 1)};
+    }
+    return spans;
+}
+
+std::vector<BilinearTap> makeBilinearTaps(uint32_t srcSize, uint32_t dstSize) {
+    // 16.16 fixed point, sampling at output pixel centers
+    const int64_t step = (static_cast<int64_t>(srcSize) << 16) / dstSize;
+    
+    std::vector<BilinearTap> taps(dstSize);
+    for (uint32_t d = 0; d < dstSize; ++d) {
+        int64_t pos = std::max<int64_t>(0, d * step + step / 2 - 0x8000);
+        uint32_t i0 = static_cast<uint32_t>(pos >> 16);
+        if (i0 >= srcSize - 1) {
+            taps[d] = {srcSize - 1, srcSize - 1, 0};
+        } else {
+            taps[d] = {i0, i0 + 1, static_cast<uint32_t>((pos >> 8) & 0xFF)};
+        }
+    }
+    return taps;
+}
+
+class PlaneResizer {
+public:
+    PlaneResizer(
+        const uint8_t* src, const ResizePlane& srcPlane,
+        uint8_t* dst, const ResizePlane& dstPlane,
+        ResizeFilter filter, const kernels::ResizeKernels& kernels
+    )
+        : src_(src + srcPlane.offset), srcPlane_(srcPlane),
+          dst_(dst + dstPlane.offset), dstPlane_(dstPlane),
+          kernels_(kernels)
+    {
+        const bool half = srcPlane.width == 2 * dstPlane.width &&
+                          srcPlane.height == 2 * dstPlane.height;
+        const bool quarter = srcPlane.width == 4 * dstPlane.width &&
+                             srcPlane.height == 4 * dstPlane.height;
+        
+        // At exactly 2x a centered bilinear tap is the 2x2 box average
+        if (half) {
+            mode_ = Mode::HALF;
+        } else if (quarter && filter == ResizeFilter::BOX) {
+            mode_ = Mode::QUARTER;
+        } else if (filter == ResizeFilter::BOX) {
+            mode_ = Mode::BOX;
+            xSpans_ = makeBoxSpans(srcPlane.width, dstPlane.width);
+            ySpans_ = makeBoxSpans(srcPlane.height, dstPlane.height);
+        } else {
+            mode_ = Mode::BILINEAR;
+            xTaps_ = makeBilinearTaps(srcPlane.width, dstPlane.width);
+            yTaps_ = makeBilinearTaps(srcPlane.height, dstPlane.height);
+        }
+    }
+    
+    uint32_t getBandCount() const {
+        return (dstPlane_.height + kResizeBandRows - 1) / kResizeBandRows;
+    }
+    
+    void resizeBand(uint32_t band) const {
+        uint32_t begin = band * kResizeBandRows;
+        uint32_t end = std::min(begin + kResizeBandRows, dstPlane_.height);
+        
+        switch (mode_) {
+            case Mode::HALF:
+                resizeHalf(begin, end);
+                break;
+            case Mode::QUARTER:
+                resizeQuarter(begin, end);
+                break;
+            case Mode::BOX:
+                resizeBox(begin, end);
+                break;
+            case Mode::BILINEAR:
+                resizeBilinear(begin, end);
+                break;
+        }
+    }
+
+private:
+    enum class Mode { HALF, QUARTER, BOX, BILINEAR };
+    
+    const uint8_t* srcRow(uint32_t y) const {
+        return src_ + static_cast<size_t>(y) * srcPlane_.rowStride;
+    }
+    
+    uint8_t* dstRow(uint32_t y) const {
+        return dst_ + static_cast<size_t>(y) * dstPlane_.rowStride;
+    }
+    
+    void resizeHalf(uint32_t begin, uint32_t end) const {
+        for (uint32_t y = begin; y < end; ++y) {
+            kernels_.downscale2x(srcRow(2 * y), srcRow(2 * y + 1), dstRow(y),
+                                 dstPlane_.width, dstPlane_.channels);
+        }
+    }
+    
+    void resizeQuarter(uint32_t begin, uint32_t end) const {
+        for (uint32_t y = begin; y < end; ++y) {
+            const uint8_t* rows[4] = {
+                srcRow(4 * y), srcRow(4 * y + 1), srcRow(4 * y + 2), srcRow(4 * y + 3)
+            };
+            kernels_.downscale4x(rows, dstRow(y), dstPlane_.width, dstPlane_.channels);
+        }
+    }
+    
+    void resizeBox(uint32_t begin, uint32_t end) const {
+        const uint32_t channels = srcPlane_.channels;
+        const size_t srcBytes = static_cast<size_t>(srcPlane_.width) * channels;
+        std::vector<uint32_t> sums(srcBytes);
+        
+        for (uint32_t y = begin; y < end; ++y) {
+            const BoxSpan& rows = ySpans_[y];
+            std::fill(sums.begin(), sums.end(), 0);
+            for (uint32_t sy = rows.begin; sy < rows.end; ++sy) {
+                kernels_.accumulateRow(srcRow(sy), sums.data(), srcBytes);
+            }
+            
+            uint8_t* out = dstRow(y);
+            const uint32_t spanRows = rows.end - rows.begin;
+            for (uint32_t x = 0; x < dstPlane_.width; ++x) {
+                const BoxSpan& cols = xSpans_[x];
+                const uint32_t count = spanRows * (cols.end - cols.begin);
+                for (uint32_t c = 0; c < channels; ++c) {
+                    uint32_t sum = 0;
+                    for (uint32_t sx = cols.begin; sx < cols.end; ++sx) {
+                        sum += sums[static_cast<size_t>(sx) * channels + c];
+                    }
+                    out[static_cast<size_t>(x) * channels + c] =
+                        static_cast<uint8_t>((sum + count / 2) / count);
+                }
+            }
+        }
+    }
+    
+    void resizeBilinear(uint32_t begin, uint32_t end) const {
+        const uint32_t channels = srcPlane_.channels;
+        const size_t srcBytes = static_cast<size_t>(srcPlane_.width) * channels;
+        std::vector<uint8_t> blended(srcBytes);
+        
+        for (uint32_t y = begin; y < end; ++y) {
+            const BilinearTap& row = yTaps_[y];
+            kernels_.blendRows(srcRow(row.i0), srcRow(row.i1), blended.data(), srcBytes,
+                               row.weight);
+            
+            uint8_t* out = dstRow(y);
+            for (uint32_t x = 0; x < dstPlane_.width; ++x) {
+                const BilinearTap& col = xTaps_[x];
+                const uint8_t* a = &blended[static_cast<size_t>(col.i0) * channels];
+                const uint8_t* b = &blended[static_cast<size_t>(col.i1) * channels];
+                for (uint32_t c = 0; c < channels; ++c) {
+                    out[static_cast<size_t>(x) * channels + c] = static_cast<uint8_t>(
+                        (a[c] * (256 - col.weight) + b[c] * col.weight + 128) >> 8);
+                }
+            }
+        }
+    }
+    
+    const uint8_t* src_;
+    ResizePlane srcPlane_;
+    uint8_t* dst_;
+    ResizePlane dstPlane_;
+    const kernels::ResizeKernels& kernels_;
+    Mode mode_ = Mode::BOX;
+    std::vector<BoxSpan> xSpans_;
+    std::vector<BoxSpan> ySpans_;
+    std::vector<BilinearTap> xTaps_;
+    std::vector<BilinearTap> yTaps_;
+};
+
+} // namespace
+
+bool BufferMapper::resize(GraphicBuffer* src, GraphicBuffer* dst, ResizeFilter filter) {
+    if (!src || !dst || src == dst) {
+        return false;
+    }
+    
+    BufferLockGuard srcGuard(src, BufferLockGuard::LockMode::Read);
+    BufferLockGuard dstGuard(dst, BufferLockGuard::LockMode::Write);
+    if (!srcGuard || !dstGuard || !srcGuard.getRawData() || !dstGuard.getRawData()) {
+        return false;
+    }
+    
+    return resize(srcGuard.getRawData(), src->getDescriptor(),
+                  dstGuard.getRawData(), dst->getDescriptor(), filter);
+}
+
+bool BufferMapper::resize(
+    const void* src,
+    const BufferDescriptor& srcDesc,
+    void* dst,
+    const BufferDescriptor& dstDesc,
+    ResizeFilter filter,
+    WorkStealingPool* pool
+) {
+    if (!src || !dst || srcDesc.format != dstDesc.format || !isResizable(srcDesc.format)) {
+        return false;
+    }
+    
+    ResizePlane srcPlanes[kMaxPlanes];
+    ResizePlane dstPlanes[kMaxPlanes];
+    uint32_t count = getResizePlanes(srcDesc, srcPlanes);
+    if (count == 0 || getResizePlanes(dstDesc, dstPlanes) != count) {
+        return false;
+    }
+    
+    const kernels::ResizeKernels& kernels = selectKernels();
+    const uint8_t* in = static_cast<const uint8_t*>(src);
+    uint8_t* out = static_cast<uint8_t*>(dst);
+    
+    std::vector<PlaneResizer> resizers;
+    std::vector<uint32_t> firstBand;
+    uint32_t bandCount = 0;
+    resizers.reserve(count);
+    for (uint32_t i = 0; i < count; ++i) {
+        if (srcPlanes[i].width == 0 || srcPlanes[i].height == 0 ||
+            !fitsStride(srcPlanes[i]) || !fitsStride(dstPlanes[i])) {
+            return false;
+        }
+        resizers.emplace_back(in, srcPlanes[i], out, dstPlanes[i], filter, kernels);
+        firstBand.push_back(bandCount);
+        bandCount += resizers.back().getBandCount();
+    }
+    
+    // Bands of every plane share one batch so chroma overlaps luma
+    WorkStealingPool& workers = pool ? *pool : WorkStealingPool::getShared();
+    workers.parallelFor(bandCount, [&](uint32_t band) {
+        uint32_t plane = count - 1;
+        while (band < firstBand[plane]) {
+            --plane;
+        }
+        resizers[plane].resizeBand(band - firstBand[plane]);
+    });
+    return true;
+}
+
+GraphicBuffer* BufferMapper::resizeInto(GraphicBuffer* src, BufferPool& pool, ResizeFilter filter) {
+    if (!src || src->getDescriptor().format != pool.getDescriptor().format) {
+        return nullptr;
+    }
+    
+    GraphicBuffer* dst = pool.acquireBuffer();
+    if (!dst) {
+        return nullptr;
+    }
+    
+    if (!resize(src, dst, filter)) {
+        pool.releaseBuffer(dst);
+        return nullptr;
+    }
+    return dst;
+}
+
+} // namespace graphics
+} // namespace android
@@ -0,0 +1,334 @@
+/**
+ * @file BufferMapperValidate.cpp
+ * @brief BufferMapper checksum and diff operations and their scalar kernels
+ * 
+ * Both walk the visible bytes of each plane row by row, so row padding
+ * never affects a checksum or a diff.
+ */
+
+#include "BufferMapper.h"
+#include "CpuFeatures.h"
+#include "FormatTraits.h"
+#include "RawPacking.h"
+#include "ValidateKernels.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <limits>
+#include <vector>
+
+namespace android {
+namespace graphics {
+
+namespace kernels {
+
+namespace {
+
+/**
+ * Slice-by-8 tables: table[k][b] advances byte b followed by k zero bytes.
+ */
+struct Crc32cTables {
+    uint32_t table[8][256];
+    
+    Crc32cTables() {
+        for (uint32_t b = 0; b < 256; ++b) {
+            uint32_t crc = b;
+            for (int k = 0; k < 8; ++k) {
+                crc = (crc >> 1) ^ (kCrc32cPolynomial & (0u - (crc & 1)));
+            }
+            table[0][b] = crc;
+        }
+        for (uint32_t b = 0; b < 256; ++b) {
+            for (int k = 1; k < 8; ++k) {
+                uint32_t prev = table[k - 1][b];
+                table[k][b] = (prev >> 8) ^ table[0][prev & 0xFF];
+            }
+        }
+    }
+};
+
+const Crc32cTables& getCrcTables() {
+    static const Crc32cTables tables;
+    return tables;
+}
+
+} // namespace
+
+uint32_t crc32cScalar(uint32_t crc, const uint8_t* data, size_t size) {
+    const auto& t = getCrcTables().table;
+    
+    for (; size >= 8; size -= 8, data += 8) {
+        uint32_t lo = crc ^ (data[0] | data[1] << 8 | data[2] << 16 |
+                             static_cast<uint32_t>(data[3]) << 24);
+        crc = t[7][lo & 0xFF] ^ t[6][(lo >> 8) & 0xFF] ^
+              t[5][(lo >> 16) & 0xFF] ^ t[4][lo >> 24] ^
+              t[3][data[4]] ^ t[2][data[5]] ^ t[1][data[6]] ^ t[0][data[7]];
+    }
+    for (; size > 0; --size) {
+        crc = (crc >> 8) ^ t[0][(crc ^ *data++) & 0xFF];
+    }
+    return crc;
+}
+
+void diffRow8Scalar(const uint8_t* a, const uint8_t* b, size_t bytes, DiffSums& sums) {
+    for (size_t i = 0; i < bytes; ++i) {
+        uint32_t d = static_cast<uint32_t>(std::abs(a[i] - b[i]));
+        sums.sad += d;
+        sums.sse += d * d;
+        sums.maxDiff = std::max(sums.maxDiff, d);
+    }
+}
+
+void diffRow16Scalar(const uint16_t* a, const uint16_t* b, size_t count, DiffSums& sums) {
+    for (size_t i = 0; i < count; ++i) {
+        uint32_t d = static_cast<uint32_t>(std::abs(a[i] - b[i]));
+        sums.sad += d;
+        sums.sse += static_cast<uint64_t>(d) * d;
+        sums.maxDiff = std::max(sums.maxDiff, d);
+    }
+}
+
+const DiffKernels& getScalarDiffKernels() {
+    static const DiffKernels scalar = {
+        diffRow8Scalar,
+        diffRow16Scalar
+    };
+    return scalar;
+}
+
+} // namespace kernels
+
+namespace {
+
+kernels::Crc32cFn selectCrc32c() {
+#if defined(__x86_64__) || defined(__i386__)
+    if (CpuFeatures::hasSse42()) {
+        return kernels::crc32cSse42;
+    }
+#endif
+    return kernels::crc32cScalar;
+}
+
+const kernels::DiffKernels& selectDiffKernels() {
+#if defined(__x86_64__) || defined(__i386__)
+    switch (CpuFeatures::getSimdLevel()) {
+        case SimdLevel::AVX2:
+            return kernels::getAvx2DiffKernels();
+        case SimdLevel::SSE4_1:
+            return kernels::getSse41DiffKernels();
+        default:
+            break;
+    }
+#endif
+    return kernels::getScalarDiffKernels();
+}
+
+// Visible bytes of one plane (interleaved chroma is one plane)
+struct VisiblePlane {
+    size_t offset = 0;
+    size_t rowStride = 0;
+    size_t rowBytes = 0;
+    uint32_t rows = 0;
+};
+
+uint32_t getVisiblePlanes(const BufferDescriptor& descriptor, VisiblePlane* outPlanes) {
+    PlaneLayout planes[BufferMapper::kMaxPlanes];
+    uint32_t count = BufferMapper::getPlaneLayouts(descriptor, planes);
+    if (count == 0) {
+        return 0;
+    }
+    
+    auto toVisible = [](const PlaneLayout& plane, size_t offset, size_t rowBytes) {
+        VisiblePlane out;
+        out.offset = offset;
+        out.rowStride = plane.rowStride;
+        out.rowBytes = rowBytes;
+        out.rows = plane.height;
+        return out;
+    };
+    
+    uint32_t visible = 0;
+    if (count == 1) {
+        outPlanes[visible++] = toVisible(
+            planes[0], planes[0].offset, BufferMapper::getRowBytes(descriptor.format, planes[0].width));
+    } else {
+        outPlanes[visible++] = toVisible(planes[0], planes[0].offset, planes[0].width);
+        if (planes[1].sampleStride == 2) {
+            outPlanes[visible++] = toVisible(planes[1], std::min(planes[1].offset, planes[2].offset),
+                                             static_cast<size_t>(planes[1].width) * 2);
+        } else {
+            outPlanes[visible++] = toVisible(planes[1], planes[1].offset, planes[1].width);
+            outPlanes[visible++] = toVisible(planes[2], planes[2].offset, planes[2].width);
+        }
+    }
+    
+    for (uint32_t i = 0; i < visible; ++i) {
+        // Odd YUV strides leave chroma rows narrower than the plane
+        if (outPlanes[i].rowBytes > outPlanes[i].rowStride) {
+            return 0;
+        }
+    }
+    
+    std::sort(outPlanes, outPlanes + visible, [](const VisiblePlane& l, const VisiblePlane& r) {
+        return l.offset < r.offset;
+    });
+    return visible;
+}
+
+uint32_t getSamplePeak(PixelFormat format) {
+    return (1u << getFormatInfo(format).sampleBits) - 1;
+}
+
+} // namespace
+
+bool BufferMapper::checksum(GraphicBuffer* buffer, uint32_t& outCrc) {
+    if (!buffer) {
+        return false;
+    }
+    
+    BufferLockGuard guard(buffer, BufferLockGuard::LockMode::Read);
+    if (!guard || !guard.getRawData()) {
+        return false;
+    }
+    
+    return checksum(guard.getRawData(), buffer->getDescriptor(), outCrc);
+}
+
+bool BufferMapper::checksum(
+    const void* data,
+    const BufferDescriptor& descriptor,
+    uint32_t& outCrc
+) {
+    VisiblePlane planes[kMaxPlanes];
+    uint32_t count = data ? getVisiblePlanes(descriptor, planes) : 0;
+    if (count == 0) {
+        return false;
+    }
+    
+    kernels::Crc32cFn update = selectCrc32c();
+    const uint8_t* base = static_cast<const uint8_t*>(data);
+    
+    uint32_t crc = ~0u;
+    for (uint32_t i = 0; i < count; ++i) {
+        const VisiblePlane& plane = planes[i];
+        const uint8_t* row = base + plane.offset;
+        
+        // Padding-free planes hash as one run
+        if (plane.rowStride == plane.rowBytes) {
+            crc = update(crc, row, plane.rowBytes * plane.rows);
+            continue;
+        }
+        for (uint32_t y = 0; y < plane.rows; ++y, row += plane.rowStride) {
+            crc = update(crc, row, plane.rowBytes);
+        }
+    }
+    
+    outCrc = ~crc;
+    return true;
+}
+
+uint32_t BufferMapper::crc32c(const void* data, size_t size, uint32_t crc) {
+    if (!data || size == 0) {
+        return crc;
+    }
+    return ~selectCrc32c()(~crc, static_cast<const uint8_t*>(data), size);
+}
+
+bool BufferMapper::diff(GraphicBuffer* a, GraphicBuffer* b, BufferDiff& outDiff) {
+    if (!a || !b) {
+        return false;
+    }
+    
+    BufferLockGuard aGuard(a, BufferLockGuard::LockMode::Read);
+    if (!aGuard || !aGuard.getRawData()) {
+        return false;
+    }
+    
+    // Diffing a buffer against itself cannot take a second lock
+    if (a == b) {
+        return diff(aGuard.getRawData(), a->getDescriptor(),
+                    aGuard.getRawData(), a->getDescriptor(), outDiff);
+    }
+    
+    BufferLockGuard bGuard(b, BufferLockGuard::LockMode::Read);
+    if (!bGuard || !bGuard.getRawData()) {
+        return false;
+    }
+    
+    return diff(aGuard.getRawData(), a->getDescriptor(),
+                bGuard.getRawData(), b->getDescriptor(), outDiff);
+}
+
+bool BufferMapper::diff(
+    const void* a,
+    const BufferDescriptor& aDesc,
+    const void* b,
+    const BufferDescriptor& bDesc,
+    BufferDiff& outDiff
+) {
+    // Bytes of 565 pixels are not samples
+    const FormatInfo& info = getFormatInfo(aDesc.format);
+    if (!a || !b || aDesc.format != bDesc.format ||
+        aDesc.width != bDesc.width || aDesc.height != bDesc.height ||
+        (!info.raw && info.sampleBits != 8)) {
+        return false;
+    }
+    
+    VisiblePlane aPlanes[kMaxPlanes];
+    VisiblePlane bPlanes[kMaxPlanes];
+    uint32_t count = getVisiblePlanes(aDesc, aPlanes);
+    if (count == 0 || getVisiblePlanes(bDesc, bPlanes) != count) {
+        return false;
+    }
+    
+    const kernels::DiffKernels& kernels = selectDiffKernels();
+    const uint8_t* aBase = static_cast<const uint8_t*>(a);
+    const uint8_t* bBase = static_cast<const uint8_t*>(b);
+    const PixelFormat format = aDesc.format;
+    const bool packed = info.isPacked();
+    const bool wide = info.raw && !packed;
+    
+    // Packed rows are compared as samples
+    std::vector<uint16_t> aSamples(packed ? aDesc.width : 0);
+    std::vector<uint16_t> bSamples(packed ? aDesc.width : 0);
+    
+    kernels::DiffSums sums;
+    uint64_t samples = 0;
+    for (uint32_t i = 0; i < count; ++i) {
+        const uint8_t* aRow = aBase + aPlanes[i].offset;
+        const uint8_t* bRow = bBase + bPlanes[i].offset;
+        const size_t rowBytes = aPlanes[i].rowBytes;
+        
+        for (uint32_t y = 0; y < aPlanes[i].rows; ++y) {
+            if (packed) {
+                RawPacking::unpackRow(format, aRow, aSamples.data(), aDesc.width);
+                RawPacking::unpackRow(format, bRow, bSamples.data(), aDesc.width);
+                kernels.diffRow16(aSamples.data(), bSamples.data(), aDesc.width, sums);
+            } else if (wide) {
+                kernels.diffRow16(reinterpret_cast<const uint16_t*>(aRow),
+                                  reinterpret_cast<const uint16_t*>(bRow), aDesc.width, sums);
+            } else {
+                kernels.diffRow8(aRow, bRow, rowBytes, sums);
+            }
+            aRow += aPlanes[i].rowStride;
+            bRow += bPlanes[i].rowStride;
+        }
+        samples += static_cast<uint64_t>(aPlanes[i].rows) *
+                   (info.raw ? aDesc.width : rowBytes);
+    }
+    
+    outDiff = BufferDiff();
+    outDiff.samples = samples;
+    outDiff.sad = sums.sad;
+    outDiff.sse = sums.sse;
+    outDiff.maxDiff = sums.maxDiff;
+    outDiff.peak = getSamplePeak(format);
+    outDiff.mse = samples ? static_cast<double>(sums.sse) / samples : 0.0;
+    outDiff.psnr = outDiff.mse > 0.0
+        ? 10.0 * std::log10(static_cast<double>(outDiff.peak) * outDiff.peak / outDiff.mse)
+        : std::numeric_limits<double>::infinity();
+    return true;
+}
+
+} // namespace graphics
+} // namespace android
@@ -19,11 +19,15 @@ BufferPool::BufferPool(
     , descriptor_(descriptor)
     , config_(config)
 {
+    allocator_->registerPool(this);
+    
     // Pre-allocate initial buffers
     grow(config_.preAllocate);
 }
 
 BufferPool::~BufferPool() {
+    allocator_->unregisterPool(this);
+    
     std::lock_guard<std::mutex> lock(mutex_);
     
     // Clear all buffers
@@ -62,6 +66,9 @@ GraphicBuffer* BufferPool::acquireBuffer(uint32_t timeoutMs) {
             }
             return nullptr;
         }
+        if (!blockingEnabled_) {
+            return nullptr;
+        }
         
         if (bufferAvailable_.wait_until(lock, deadline) == 
             std::cv_status::timeout) {
@@ -101,30 +108,51 @@ void BufferPool::releaseBuffer(GraphicBuffer* buffer) {
 }
 
 uint32_t BufferPool::grow(uint32_t count) {
+    uint32_t target = 0;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        
+        size_t committed = allBuffers_.size() + pendingGrowth_;
+        if (committed < config_.maxBuffers) {
+            target = std::min<uint32_t>(count,
+                static_cast<uint32_t>(config_.maxBuffers - committed));
+        }
+        pendingGrowth_ += target;
+    }
+    
+    // Allocate without holding the pool lock: the allocator may block or
+    // call back into pools (e.g. to shrink them under memory pressure)
+    std::vector<std::unique_ptr<GraphicBuffer>> created;
+    AllocationStatus status = AllocationStatus::SUCCESS;
+    if (target > 0) {
+        created.reserve(target);
+        status = allocator_->allocateBatch(descriptor_, target, created);
+    }
+    
     std::lock_guard<std::mutex> lock(mutex_);
+    pendingGrowth_ -= target;
+    
+    // A batch may stop early (budget, memory); record the shortfall so
+    // callers can tell a partial growth from a pool at maxBuffers
+    if (created.size() < target) {
+        stats_.failedAllocations += target - created.size();
+        stats_.lastFailure = status != AllocationStatus::SUCCESS
+            ? status : AllocationStatus::ERROR_NO_MEMORY;
+    }
     
     uint32_t added = 0;
-    for (uint32_t i = 0; i < count; ++i) {
-        if (allBuffers_.size() >= config_.maxBuffers) {
-            break;
-        }
-        
-        std::unique_ptr<GraphicBuffer> buffer;
-        AllocationStatus status = allocator_->allocate(descriptor_, buffer);
+    for (auto& buffer : created) {
+        stats_.allocatedBytes += buffer->getDescriptor().calculateSize();
+        freeBuffers_.push(buffer.get());
+        allBuffers_.push_back(std::move(buffer));
+        added++;
         
-        if (status == AllocationStatus::SUCCESS && buffer) {
-            freeBuffers_.push(buffer.get());
-            allBuffers_.push_back(std::move(buffer));
-            added++;
-            
-            stats_.totalBuffers++;
-            stats_.freeBuffers++;
-            stats_.allocatedBytes += descriptor_.calculateSize();
-            
-            if (stats_.allocatedBytes > stats_.peakAllocatedBytes) {
-                stats_.peakAllocatedBytes = stats_.allocatedBytes;
-            }
-        }
+        stats_.totalBuffers++;
+        stats_.freeBuffers++;
+    }
+    
+    if (stats_.allocatedBytes > stats_.peakAllocatedBytes) {
+        stats_.peakAllocatedBytes = stats_.allocatedBytes;
     }
     
     if (added > 0) {
@@ -136,6 +164,9 @@ uint32_t BufferPool::grow(uint32_t count) {
 }
 
 uint32_t BufferPool::shrink(uint32_t keepCount) {
+    // Freed once the lock is dropped: the allocator may run callbacks or
+    // call back into pools from free()
+    std::vector<std::unique_ptr<GraphicBuffer>> removed;
     std::lock_guard<std::mutex> lock(mutex_);
     
     uint32_t freed = 0;
@@ -152,9 +183,10 @@ uint32_t BufferPool::shrink(uint32_t keepCount) {
             });
         
         if (it != allBuffers_.end()) {
-            stats_.allocatedBytes -= descriptor_.calculateSize();
+            stats_.allocatedBytes -= (*it)->getDescriptor().calculateSize();
             stats_.totalBuffers--;
             stats_.freeBuffers--;
+            removed.push_back(std::move(*it));
             allBuffers_.erase(it);
             freed++;
         }
@@ -174,7 +206,7 @@ bool BufferPool::flush(uint32_t timeoutMs) {
     std::unique_lock<std::mutex> lock(mutex_);
     
     while (freeBuffers_.size() < allBuffers_.size()) {
-        if (std::chrono::steady_clock::now() >= deadline) {
+        if (!blockingEnabled_ || std::chrono::steady_clock::now() >= deadline) {
             return false;
         }
         
@@ -184,6 +216,14 @@ bool BufferPool::flush(uint32_t timeoutMs) {
     return true;
 }
 
+void BufferPool::setBlockingEnabled(bool enabled) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    blockingEnabled_ = enabled;
+    if (!enabled) {
+        bufferAvailable_.notify_all();
+    }
+}
+
 PoolStatistics BufferPool::getStatistics() const {
     std::lock_guard<std::mutex> lock(mutex_);
     
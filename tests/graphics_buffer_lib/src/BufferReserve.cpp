@@ -0,0 +1,144 @@
+/**
+ * @file BufferReserve.cpp
+ * @brief Implementation of BufferReserve class
+ */
+
+#include "BufferReserve.h"
+#include <algorithm>
+
+namespace android {
+namespace graphics {
+
+BufferReserve::BufferReserve(const BufferReserveConfig& config)
+    : config_(config)
+{
+}
+
+BufferReserve::~BufferReserve() = default;
+
+void BufferReserve::recordAllocation(
+    const BufferDescriptor& descriptor,
+    std::vector<NativeHandle>& outEvicted,
+    size_t bufferSize
+) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    
+    auto it = findShape(descriptor);
+    if (it != shapes_.end()) {
+        // Move to front of history
+        shapes_.splice(shapes_.begin(), shapes_, it);
+        return;
+    }
+    
+    Shape shape;
+    shape.descriptor = descriptor;
+    shape.bufferSize = bufferSize ? bufferSize : descriptor.calculateSize();
+    shapes_.push_front(std::move(shape));
+    
+    // Forget the least recently used shapes
+    while (shapes_.size() > config_.maxShapes) {
+        Shape& cold = shapes_.back();
+        reservedBytes_ -= cold.bufferSize * cold.handles.size();
+        stats_.evicted += cold.handles.size();
+        outEvicted.insert(outEvicted.end(), cold.handles.begin(), cold.handles.end());
+        shapes_.pop_back();
+    }
+}
+
+bool BufferReserve::take(const BufferDescriptor& descriptor, NativeHandle& outHandle) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    
+    auto it = findShape(descriptor);
+    if (it == shapes_.end() || it->handles.empty()) {
+        stats_.misses++;
+        return false;
+    }
+    
+    outHandle = it->handles.back();
+    it->handles.pop_back();
+    reservedBytes_ -= it->bufferSize;
+    stats_.hits++;
+    return true;
+}
+
+bool BufferReserve::offer(const BufferDescriptor& descriptor, const NativeHandle& handle) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    
+    auto it = findShape(descriptor);
+    if (it == shapes_.end()) {
+        return false;  // Not a predicted shape
+    }
+    
+    if (it->handles.size() >= config_.maxBuffersPerShape ||
+        reservedBytes_ + it->bufferSize > config_.maxBytes) {
+        return false;
+    }
+    
+    it->handles.push_back(handle);
+    reservedBytes_ += it->bufferSize;
+    stats_.retained++;
+    return true;
+}
+
+bool BufferReserve::isTracked(const BufferDescriptor& descriptor) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return findShape(descriptor) != shapes_.end();
+}
+
+std::vector<BufferDescriptor> BufferReserve::getPredictedShapes() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    
+    std::vector<BufferDescriptor> result;
+    result.reserve(shapes_.size());
+    for (const auto& shape : shapes_) {
+        result.push_back(shape.descriptor);
+    }
+    return result;
+}
+
+size_t BufferReserve::trim(std::vector<NativeHandle>& outReleased) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    
+    for (auto& shape : shapes_) {
+        stats_.evicted += shape.handles.size();
+        outReleased.insert(outReleased.end(), shape.handles.begin(), shape.handles.end());
+        shape.handles.clear();
+    }
+    size_t bytes = reservedBytes_;
+    reservedBytes_ = 0;
+    return bytes;
+}
+
+BufferReserveStatistics BufferReserve::getStatistics() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    
+    BufferReserveStatistics stats = stats_;
+    stats.trackedShapes = shapes_.size();
+    stats.reservedBytes = reservedBytes_;
+    stats.reservedBuffers = 0;
+    for (const auto& shape : shapes_) {
+        stats.reservedBuffers += shape.handles.size();
+    }
+    return stats;
+}
+
+std::list<BufferReserve::Shape>::iterator BufferReserve::findShape(
+    const BufferDescriptor& descriptor
+) {
+    return std::find_if(shapes_.begin(), shapes_.end(),
+        [&descriptor](const Shape& shape) {
+            return shape.descriptor == descriptor;
+        });
+}
+
+std::list<BufferReserve::Shape>::const_iterator BufferReserve::findShape(
+    const BufferDescriptor& descriptor
+) const {
+    return std::find_if(shapes_.begin(), shapes_.end(),
+        [&descriptor](const Shape& shape) {
+            return shape.descriptor == descriptor;
+        });
+}
+
+} // namespace graphics
+} // namespace android
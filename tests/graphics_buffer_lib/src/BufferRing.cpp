@@ -0,0 +1,105 @@
+/**
+ * @file BufferRing.cpp
+ * @brief Implementation of BufferRing
+ */
+
+#include "BufferRing.h"
+#include <algorithm>
+#include <thread>
+
+namespace android {
+namespace graphics {
+
+BufferRing::BufferRing(size_t capacity) {
+    size_t size = 1;
+    while (size < std::max<size_t>(capacity, 2)) {
+        size <<= 1;
+    }
+    cells_.reset(new Cell[size]);
+    for (size_t i = 0; i < size; ++i) {
+        cells_[i].sequence.store(i, std::memory_order_relaxed);
+    }
+    mask_ = size - 1;
+}
+
+BufferRing::~BufferRing() = default;
+
+bool BufferRing::push(GraphicBuffer* buffer) {
+    if (!reserve()) {
+        return false;
+    }
+    pushReserved(buffer);
+    return true;
+}
+
+bool BufferRing::reserve() {
+    size_t reserved = reserved_.load(std::memory_order_relaxed);
+    do {
+        if (reserved > mask_) {
+            return false;
+        }
+    } while (!reserved_.compare_exchange_weak(reserved, reserved + 1,
+                                              std::memory_order_relaxed));
+    return true;
+}
+
+void BufferRing::unreserve() {
+    reserved_.fetch_sub(1, std::memory_order_release);
+}
+
+void BufferRing::pushReserved(GraphicBuffer* buffer) {
+    uint64_t position = tail_.load(std::memory_order_relaxed);
+    for (;;) {
+        Cell& cell = cells_[position & mask_];
+        uint64_t sequence = cell.sequence.load(std::memory_order_acquire);
+        int64_t diff = static_cast<int64_t>(sequence - position);
+        if (diff == 0) {
+            // Cell is free for this lap; claim it
+            if (tail_.compare_exchange_weak(position, position + 1,
+                                            std::memory_order_relaxed)) {
+                cell.buffer = buffer;
+                cell.sequence.store(position + 1, std::memory_order_release);
+                return;
+            }
+        } else if (diff < 0) {
+            // A consumer has claimed the cell but not freed it yet; the
+            // reservation guarantees it will
+            std::this_thread::yield();
+            position = tail_.load(std::memory_order_relaxed);
+        } else {
+            position = tail_.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+bool BufferRing::pop(GraphicBuffer*& buffer) {
+    uint64_t position = head_.load(std::memory_order_relaxed);
+    for (;;) {
+        Cell& cell = cells_[position & mask_];
+        uint64_t sequence = cell.sequence.load(std::memory_order_acquire);
+        int64_t diff = static_cast<int64_t>(sequence - (position + 1));
+        if (diff == 0) {
+            if (head_.compare_exchange_weak(position, position + 1,
+                                            std::memory_order_relaxed)) {
+                buffer = cell.buffer;
+                // Free the cell for the push one lap later, then its room
+                cell.sequence.store(position + mask_ + 1, std::memory_order_release);
+                reserved_.fetch_sub(1, std::memory_order_release);
+                return true;
+            }
+        } else if (diff < 0) {
+            return false;  // Not published yet: empty
+        } else {
+            position = head_.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+size_t BufferRing::size() const {
+    uint64_t head = head_.load(std::memory_order_relaxed);
+    uint64_t tail = tail_.load(std::memory_order_relaxed);
+    return tail > head ? static_cast<size_t>(tail - head) : 0;
+}
+
+} // namespace graphics
+} // namespace android
@@ -0,0 +1,97 @@
+/**
+ * @file BufferRing.h
+ * @brief Internal bounded lock-free ring of buffer pointers
+ * 
+ * Producer→consumer handoff for CameraBufferManager streams. Each cell
+ * carries a sequence number that says whether it is ready for the next
+ * push or the next pop (Vyukov's bounded MPMC queue), so producers and
+ * consumers only contend on their own cursor and never take a lock.
+ * With a single producer and a single consumer every operation is one
+ * uncontended compare-exchange.
+ * 
+ * Room can be reserved ahead of the push, so a batch spanning several
+ * rings either fits in all of them or is not queued at all.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace android {
+namespace graphics {
+
+class GraphicBuffer;
+
+class BufferRing {
+public:
+    /**
+     * @param capacity Maximum queued buffers; rounded up to a power of two
+     */
+    explicit BufferRing(size_t capacity);
+    ~BufferRing();
+    
+    BufferRing(const BufferRing&) = delete;
+    BufferRing& operator=(const BufferRing&) = delete;
+    
+    /**
+     * @brief Append a buffer
+     * @return False if the ring is full
+     */
+    bool push(GraphicBuffer* buffer);
+    
+    /**
+     * @brief Claim room for one later pushReserved()
+     * @return False if the ring is full, counting other reservations
+     */
+    bool reserve();
+    
+    /**
+     * @brief Give back a reservation that will not be pushed
+     */
+    void unreserve();
+    
+    /**
+     * @brief Append a buffer into room claimed by reserve(); never fails
+     */
+    void pushReserved(GraphicBuffer* buffer);
+    
+    /**
+     * @brief Take the oldest buffer
+     * @return False if the ring is empty
+     */
+    bool pop(GraphicBuffer*& buffer);
+    
+    /**
+     * @brief Approximate number of queued buffers
+     */
+    size_t size() const;
+    
+    bool empty() const { return size() == 0; }
+    
+    size_t getCapacity() const { return mask_ + 1; }
+
+private:
+    static constexpr size_t kCacheLineSize = 64;
+    
+    struct Cell {
+        std::atomic<uint64_t> sequence{0};
+        GraphicBuffer* buffer = nullptr;
+    };
+    
+    std::unique_ptr<Cell[]> cells_;
+    size_t mask_;
+    
+    // Queued plus reserved buffers; a slot is given back only once its
+    // pop has freed the cell, so a reservation always finds room
+    alignas(kCacheLineSize) std::atomic<size_t> reserved_{0};
+    
+    // Cursors on their own lines so producers and consumers don't share one
+    alignas(kCacheLineSize) std::atomic<uint64_t> tail_{0};    // Next push
+    alignas(kCacheLineSize) std::atomic<uint64_t> head_{0};    // Next pop
+};
+
+} // namespace graphics
+} // namespace android
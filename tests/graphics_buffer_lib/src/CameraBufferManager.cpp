@@ -4,9 +4,14 @@
  */
 
 #include "CameraBufferManager.h"
+#include "BufferRing.h"
 #include "FenceManager.h"
 #include <sstream>
 #include <algorithm>
+#include <chrono>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
 
 namespace android {
 namespace graphics {
@@ -20,6 +25,32 @@ std::string StreamConfiguration::toString() const {
     return ss.str();
 }
 
+CameraBufferManager::StreamInfo::~StreamInfo() {
+    if (eventFd >= 0) {
+        close(eventFd);
+    }
+}
+
+CameraBufferManager::StreamRef& CameraBufferManager::StreamRef::operator=(
+    StreamRef&& other
+) noexcept {
+    if (this != &other) {
+        if (info_) {
+            owner_->releaseCount(info_->users);
+        }
+        owner_ = other.owner_;
+        info_ = other.info_;
+        other.info_ = nullptr;
+    }
+    return *this;
+}
+
+CameraBufferManager::StreamRef::~StreamRef() {
+    if (info_) {
+        owner_->releaseCount(info_->users);
+    }
+}
+
 CameraBufferManager::CameraBufferManager(
     std::shared_ptr<IBufferAllocator> allocator
 )
@@ -40,8 +71,18 @@ CameraBufferManager::CameraBufferManager(
 CameraBufferManager::~CameraBufferManager() {
     flushAllStreams(1000);
     
+    // Buffers still behind a release fence may be in use by the GPU;
+    // give them time before their pools free them
     std::lock_guard<std::mutex> lock(streamsMutex_);
+    for (auto& [id, info] : streams_) {
+        if (!drainDeferred(info.get(), kDrainTimeoutMs)) {
+            // A stuck release callback still uses it; leak rather than free
+            info->pool->removeListener(this);
+            info.release();
+        }
+    }
     streams_.clear();
+    delete streamTable_.exchange(nullptr);
 }
 
 uint32_t CameraBufferManager::configureStream(const StreamConfiguration& config) {
@@ -63,9 +104,14 @@ uint32_t CameraBufferManager::configureStream(const StreamConfiguration& config)
     // Register as listener
     info->pool->addListener(this);
     
+    // A stream never has more buffers in flight than its pool can hold
+    info->pending = std::make_unique<BufferRing>(config.poolConfig.maxBuffers);
+    info->eventFd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    
     info->state = StreamState::CONFIGURED;
     
     streams_[streamId] = std::move(info);
+    publishStreamsLocked();
     
     return streamId;
 }
@@ -74,22 +120,60 @@ bool CameraBufferManager::reconfigureStream(
     uint32_t streamId,
     const StreamConfiguration& newConfig
 ) {
-    std::lock_guard<std::mutex> lock(streamsMutex_);
+    std::unique_ptr<StreamInfo> owned;
+    {
+        std::lock_guard<std::mutex> lock(streamsMutex_);
+        
+        auto it = streams_.find(streamId);
+        if (it == streams_.end()) {
+            return false;
+        }
+        
+        // Take the stream out while its pool and ring are swapped; calls
+        // made meanwhile fail as if it did not exist
+        owned = std::move(it->second);
+        streams_.erase(it);
+        publishStreamsLocked();
+    }
     
-    auto it = streams_.find(streamId);
-    if (it == streams_.end()) {
+    StreamInfo* info = owned.get();
+    quiesceStream(info);
+    
+    // Remove old pool before creating the new one so its buffers land in
+    // the allocator's warm reserve and can serve the next configuration.
+    // Released buffers whose fences are pending are still in use; wait
+    // for them before the pool frees them. Buffers the producer or
+    // consumer holds cannot be waited for here: nothing can return them
+    // while the stream is unpublished.
+    bool drained = drainDeferred(info, kDrainTimeoutMs);
+    uint32_t held = info->pool->getTotalCount() - info->pool->getFreeCount() -
+                    static_cast<uint32_t>(info->pending->size());
+    if (!drained || held > 0) {
+        // Keep the old pool; a stuck release callback may still use it
+        info->closing.store(false);
+        info->pool->setBlockingEnabled(true);
+        std::lock_guard<std::mutex> lock(streamsMutex_);
+        streams_[streamId] = std::move(owned);
+        publishStreamsLocked();
         return false;
     }
     
-    StreamInfo* info = it->second.get();
-    
-    // Can only reconfigure if idle or configured
-    if (info->state == StreamState::STREAMING) {
-        return false;
+    // Queued buffers belong to the old pool too: drop them, once the
+    // producer is done writing, and clear the stream's readiness
+    GraphicBuffer* queued;
+    while (info->pending->pop(queued)) {
+        queued->waitAcquireFence(kDrainTimeoutMs);
+        info->pool->releaseBuffer(queued);
+    }
+    info->closing.store(false);
+    if (info->eventFd >= 0) {
+        uint64_t count;
+        ssize_t ignored = read(info->eventFd, &count, sizeof(count));
+        (void)ignored;
     }
     
-    // Remove old pool
     info->pool->removeListener(this);
+    info->pool.reset();
     
     // Create new pool with new config
     info->config = newConfig;
@@ -102,42 +186,122 @@ bool CameraBufferManager::reconfigureStream(
     );
     info->pool->addListener(this);
     
+    // Grow the (now empty) ring if needed; nothing can reach it until
+    // the stream is published again
+    if (info->pending->getCapacity() < newConfig.poolConfig.maxBuffers) {
+        info->pending = std::make_unique<BufferRing>(newConfig.poolConfig.maxBuffers);
+    }
+    
+    std::lock_guard<std::mutex> lock(streamsMutex_);
+    streams_[streamId] = std::move(owned);
+    publishStreamsLocked();
+    
     return true;
 }
 
 bool CameraBufferManager::removeStream(uint32_t streamId, bool waitForBuffers) {
-    std::lock_guard<std::mutex> lock(streamsMutex_);
-    
-    auto it = streams_.find(streamId);
-    if (it == streams_.end()) {
-        return false;
+    // Buffers can only come back while the stream is still published.
+    // Wait for them holding a reference rather than the streams lock,
+    // which onPoolExhausted() takes from inside the pool.
+    if (waitForBuffers) {
+        StreamRef info = getStream(streamId);
+        if (!info) {
+            return false;
+        }
+        drainDeferred(info.get(), kDrainTimeoutMs);
+        info->pool->flush(kDrainTimeoutMs);
     }
     
-    StreamInfo* info = it->second.get();
-    
-    if (waitForBuffers) {
-        info->pool->flush(5000);
+    std::unique_ptr<StreamInfo> owned;
+    {
+        std::lock_guard<std::mutex> lock(streamsMutex_);
+        
+        auto it = streams_.find(streamId);
+        if (it == streams_.end()) {
+            return false;
+        }
+        
+        // No new lookups can find it once unpublished
+        owned = std::move(it->second);
+        streams_.erase(it);
+        publishStreamsLocked();
     }
     
-    info->pool->removeListener(this);
-    streams_.erase(it);
+    quiesceStream(owned.get());
     
+    // Nothing can defer a release any more
+    bool drained = drainDeferred(owned.get(), waitForBuffers ? kDrainTimeoutMs : 0);
+    owned->pool->removeListener(this);
+    if (!drained) {
+        owned.release();  // A stuck release callback still uses it; leak rather than free
+    }
     return true;
 }
 
+void CameraBufferManager::quiesceStream(StreamInfo* info) {
+    // Wake consumers sleeping in acquireBuffer(); the event FD stays
+    // readable since they see closing and stop popping. Producers
+    // blocked on the pool fail the same way.
+    info->closing.store(true);
+    if (info->eventFd >= 0) {
+        uint64_t one = 1;
+        ssize_t ignored = write(info->eventFd, &one, sizeof(one));
+        (void)ignored;
+    }
+    info->pool->setBlockingEnabled(false);
+    
+    // Wait out the references taken before, without the streams lock
+    // since their holders may need it (e.g. onPoolExhausted())
+    waitForZero(info->users);
+}
+
+void CameraBufferManager::releaseCount(std::atomic<uint32_t>& count) const {
+    // Only the last release while a waiter is marked takes the lock
+    if (count.fetch_sub(1) == (kQuiescing | 1)) {
+        std::lock_guard<std::mutex> lock(quiesceMutex_);
+        quiesced_.notify_all();
+    }
+}
+
+void CameraBufferManager::waitForZero(std::atomic<uint32_t>& count) const {
+    // One waiter per count: the stream's owner, or the table writer
+    // under streamsMutex_
+    count.fetch_or(kQuiescing);
+    {
+        std::unique_lock<std::mutex> lock(quiesceMutex_);
+        quiesced_.wait(lock, [&count] {
+            return (count.load() & ~kQuiescing) == 0;
+        });
+    }
+    count.fetch_and(~kQuiescing);
+}
+
 GraphicBuffer* CameraBufferManager::dequeueBuffer(
     uint32_t streamId,
     int* outFenceFd
 ) {
-    StreamInfo* info = getStream(streamId);
+    StreamRef info = getStream(streamId);
     if (!info) return nullptr;
     
-    GraphicBuffer* buffer = info->pool->acquireBuffer();
+    Fence acquireFence;
+    GraphicBuffer* buffer = takeIdleBuffer(info.get(), acquireFence);
+    if (!buffer) {
+        buffer = info->pool->acquireBuffer();
+    }
+    if (!buffer) {
+        return nullptr;
+    }
     
-    if (buffer && outFenceFd) {
-        // Create acquire fence
-        Fence fence = fenceManager_->createFence("camera_dequeue");
-        *outFenceFd = fence.dup();
+    if (acquireFence.isValid() && !acquireFence.isSignaled()) {
+        if (outFenceFd) {
+            *outFenceFd = acquireFence.release();
+            return buffer;
+        }
+        acquireFence.wait(info->config.poolConfig.blockTimeoutMs);
+    }
+    
+    if (outFenceFd) {
+        *outFenceFd = -1;  // Idle buffer: nothing to wait for
     }
     
     return buffer;
@@ -148,67 +312,240 @@ bool CameraBufferManager::queueBuffer(
     GraphicBuffer* buffer,
     int releaseFenceFd
 ) {
-    StreamInfo* info = getStream(streamId);
+    StreamRef info = getStream(streamId);
     if (!info || !buffer) return false;
     
+    // Claim ring room before touching the buffer, so a full ring leaves
+    // it and its current fence as they were
+    if (!info->pending->reserve()) {
+        return false;
+    }
+    
     // Handle release fence
     if (releaseFenceFd >= 0) {
         buffer->setAcquireFence(fenceManager_.get(), releaseFenceFd);
     }
+    publishQueued(info.get(), streamId, buffer);
     
-    // Add to pending queue for consumers
-    {
-        std::lock_guard<std::mutex> lock(info->mutex);
-        info->pendingBuffers.push(buffer);
+    return true;
+}
+
+void CameraBufferManager::publishQueued(
+    StreamInfo* info,
+    uint32_t streamId,
+    GraphicBuffer* buffer
+) {
+    info->pending->pushReserved(buffer);
+    if (info->eventFd >= 0) {
+        uint64_t one = 1;
+        ssize_t ignored = write(info->eventFd, &one, sizeof(one));
+        (void)ignored;
     }
     
     // Notify callback
     if (bufferCallback_) {
         bufferCallback_(streamId, buffer);
     }
-    
-    return true;
 }
 
 GraphicBuffer* CameraBufferManager::acquireBuffer(
     uint32_t streamId,
     int* outFenceFd
 ) {
-    StreamInfo* info = getStream(streamId);
+    StreamRef info = getStream(streamId);
     if (!info) return nullptr;
     
-    std::lock_guard<std::mutex> lock(info->mutex);
-    
-    if (info->pendingBuffers.empty()) {
-        return nullptr;
+    GraphicBuffer* buffer = popPending(info.get());
+    if (buffer && outFenceFd) {
+        *outFenceFd = -1;  // Consumer's acquire fence
     }
     
-    GraphicBuffer* buffer = info->pendingBuffers.front();
-    info->pendingBuffers.pop();
+    return buffer;
+}
+
+GraphicBuffer* CameraBufferManager::acquireBuffer(
+    uint32_t streamId,
+    int* outFenceFd,
+    uint32_t timeoutMs
+) {
+    StreamRef info = getStream(streamId);
+    if (!info) return nullptr;
     
-    if (outFenceFd) {
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
+    GraphicBuffer* buffer = popPending(info.get());
+    while (!buffer && !info->closing.load()) {
+        auto remaining = std::chrono::ceil<std::chrono::milliseconds>(
+            deadline - std::chrono::steady_clock::now()).count();
+        if (remaining <= 0) {
+            break;
+        }
+        
+        // Without an event FD, fall back to 1 ms naps
+        pollfd pfd = {info->eventFd, POLLIN, 0};
+        int waitMs = static_cast<int>(std::min<int64_t>(remaining, INT32_MAX));
+        if (info->eventFd < 0) {
+            waitMs = 1;
+        }
+        poll(&pfd, 1, waitMs);
+        
+        // Another consumer may win the buffer; then wait again
+        buffer = popPending(info.get());
+    }
+    
+    if (buffer && outFenceFd) {
         *outFenceFd = -1;  // Consumer's acquire fence
     }
     
     return buffer;
 }
 
+int CameraBufferManager::getStreamEventFd(uint32_t streamId) const {
+    StreamRef info = getStream(streamId);
+    return info ? info->eventFd : -1;
+}
+
 void CameraBufferManager::releaseBuffer(
     uint32_t streamId,
     GraphicBuffer* buffer,
     int releaseFenceFd
 ) {
-    StreamInfo* info = getStream(streamId);
+    Fence fence(releaseFenceFd);
+    StreamRef info = getStream(streamId);
     if (!info || !buffer) return;
     
-    // Wait for consumer's release fence
-    if (releaseFenceFd >= 0) {
-        Fence fence(releaseFenceFd);
-        fence.wait(1000);
+    // Return idle buffers now; the rest once the consumer's fence signals
+    if (fence.isSignaled()) {
+        info->pool->releaseBuffer(buffer);
+        return;
+    }
+    deferRelease(info.get(), buffer, std::move(fence));
+}
+
+bool CameraBufferManager::dequeueBatch(
+    const std::vector<uint32_t>& streamIds,
+    std::vector<GraphicBuffer*>& outBuffers,
+    int* outFenceFd,
+    uint32_t timeoutMs
+) {
+    outBuffers.assign(streamIds.size(), nullptr);
+    if (outFenceFd) {
+        *outFenceFd = -1;
     }
     
-    // Return buffer to pool
-    info->pool->releaseBuffer(buffer);
+    std::vector<StreamRef> infos(streamIds.size());
+    for (size_t i = 0; i < streamIds.size(); ++i) {
+        infos[i] = getStream(streamIds[i]);
+        if (!infos[i]) {
+            outBuffers.clear();
+            return false;
+        }
+    }
+    
+    // Fixed acquisition order: a batch waiting on one stream never holds
+    // a buffer another batch is waiting for on an earlier stream
+    std::vector<size_t> order(streamIds.size());
+    for (size_t i = 0; i < order.size(); ++i) {
+        order[i] = i;
+    }
+    std::stable_sort(order.begin(), order.end(), [&streamIds](size_t a, size_t b) {
+        return streamIds[a] < streamIds[b];
+    });
+    
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
+    std::vector<Fence> fences(streamIds.size());
+    bool complete = true;
+    for (size_t i : order) {
+        GraphicBuffer* buffer = takeIdleBuffer(infos[i].get(), fences[i]);
+        if (!buffer && timeoutMs > 0) {
+            auto remaining = std::chrono::ceil<std::chrono::milliseconds>(
+                deadline - std::chrono::steady_clock::now()).count();
+            if (remaining > 0) {
+                buffer = infos[i]->pool->acquireBuffer(static_cast<uint32_t>(remaining));
+            }
+        }
+        if (!buffer) {
+            complete = false;
+            break;
+        }
+        outBuffers[i] = buffer;
+    }
+    
+    if (!complete) {
+        // Hand back what was taken, busy buffers to their pending fence
+        for (size_t i = 0; i < streamIds.size(); ++i) {
+            if (!outBuffers[i]) {
+                continue;
+            }
+            if (fences[i].isSignaled()) {
+                infos[i]->pool->releaseBuffer(outBuffers[i]);
+            } else {
+                deferRelease(infos[i].get(), outBuffers[i], std::move(fences[i]));
+            }
+        }
+        outBuffers.clear();
+        return false;
+    }
+    
+    if (!outFenceFd) {
+        for (size_t i = 0; i < streamIds.size(); ++i) {
+            fences[i].wait(infos[i]->config.poolConfig.blockTimeoutMs);
+        }
+        return true;
+    }
+    
+    std::vector<Fence> pending;
+    for (Fence& fence : fences) {
+        if (!fence.isSignaled()) {
+            pending.push_back(std::move(fence));
+        }
+    }
+    
+    // Every buffer idle: -1, as for dequeueBuffer()
+    *outFenceFd = pending.empty() ? -1 : Fence::merge(pending).release();
+    
+    return true;
+}
+
+bool CameraBufferManager::queueBatch(
+    const std::vector<uint32_t>& streamIds,
+    const std::vector<GraphicBuffer*>& buffers,
+    int releaseFenceFd
+) {
+    if (streamIds.size() != buffers.size()) {
+        return false;
+    }
+    
+    std::vector<StreamRef> infos(streamIds.size());
+    for (size_t i = 0; i < streamIds.size(); ++i) {
+        infos[i] = getStream(streamIds[i]);
+        if (!infos[i] || !buffers[i]) {
+            return false;
+        }
+    }
+    
+    // Claim ring room for every entry first; a repeated stream claims
+    // once per entry. A full ring gives back what was claimed.
+    for (size_t i = 0; i < streamIds.size(); ++i) {
+        if (!infos[i]->pending->reserve()) {
+            while (i-- > 0) {
+                infos[i]->pending->unreserve();
+            }
+            return false;
+        }
+    }
+    
+    // Nothing can fail from here on: take the fence
+    Fence fence(releaseFenceFd);
+    for (size_t i = 0; i < streamIds.size(); ++i) {
+        // The last buffer takes the original instead of a duplicate
+        if (fence.isValid()) {
+            int fenceFd = i + 1 < streamIds.size() ? fence.dup() : fence.release();
+            buffers[i]->setAcquireFence(fenceManager_.get(), fenceFd);
+        }
+        publishQueued(infos[i].get(), streamIds[i], buffers[i]);
+    }
+    
+    return true;
 }
 
 void CameraBufferManager::setBufferCallback(BufferCallback callback) {
@@ -220,7 +557,7 @@ void CameraBufferManager::setErrorCallback(ErrorCallback callback) {
 }
 
 StreamState CameraBufferManager::getStreamState(uint32_t streamId) const {
-    const StreamInfo* info = getStream(streamId);
+    StreamRef info = getStream(streamId);
     return info ? info->state : StreamState::ERROR;
 }
 
@@ -238,12 +575,20 @@ std::vector<uint32_t> CameraBufferManager::getConfiguredStreams() const {
 }
 
 PoolStatistics CameraBufferManager::getStreamStatistics(uint32_t streamId) const {
-    const StreamInfo* info = getStream(streamId);
+    StreamRef info = getStream(streamId);
     if (!info) return {};
     
     return info->pool->getStatistics();
 }
 
+size_t CameraBufferManager::getDeferredReleaseCount(uint32_t streamId) const {
+    StreamRef info = getStream(streamId);
+    if (!info) return 0;
+    
+    std::lock_guard<std::mutex> lock(info->mutex);
+    return info->deferred.size();
+}
+
 bool CameraBufferManager::flushAllStreams(uint32_t timeoutMs) {
     std::lock_guard<std::mutex> lock(streamsMutex_);
     
@@ -272,6 +617,12 @@ std::string CameraBufferManager::dumpState() const {
         auto stats = info->pool->getStatistics();
         ss << "    Pool: " << stats.freeBuffers << "/" << stats.totalBuffers 
            << " free, hit rate=" << (stats.hitRate * 100) << "%\n";
+        
+        ss << "    Pending: " << info->pending->size() << "/"
+           << info->pending->getCapacity() << "\n";
+        
+        std::lock_guard<std::mutex> streamLock(info->mutex);
+        ss << "    Deferred releases: " << info->deferred.size() << "\n";
     }
     
     return ss.str();
@@ -305,20 +656,191 @@ void CameraBufferManager::onPoolExhausted(BufferPool* pool) {
     }
 }
 
-CameraBufferManager::StreamInfo* CameraBufferManager::getStream(uint32_t streamId) {
-    std::lock_guard<std::mutex> lock(streamsMutex_);
+void CameraBufferManager::deferRelease(
+    StreamInfo* info,
+    GraphicBuffer* buffer,
+    Fence&& fence
+) {
+    uint64_t serial = nextDeferredSerial_.fetch_add(1);
+    Fence watched(fence.dup());
+    {
+        std::lock_guard<std::mutex> lock(info->mutex);
+        DeferredRelease entry;
+        entry.serial = serial;
+        entry.buffer = buffer;
+        entry.fence = std::move(fence);
+        info->deferred.push_back(std::move(entry));
+    }
+    
+    // May complete inline if the fence signaled meanwhile, so no lock here
+    uint64_t waitId = fenceManager_->waitAsync(std::move(watched),
+        [this, info, serial, buffer](Fence*, FenceState) {
+            completeDeferredRelease(info, serial, buffer);
+        });
     
-    auto it = streams_.find(streamId);
-    return it != streams_.end() ? it->second.get() : nullptr;
+    std::lock_guard<std::mutex> lock(info->mutex);
+    for (auto& entry : info->deferred) {
+        if (entry.serial == serial) {
+            entry.waitId = waitId;
+            break;
+        }
+    }
 }
 
-const CameraBufferManager::StreamInfo* CameraBufferManager::getStream(
-    uint32_t streamId
-) const {
-    std::lock_guard<std::mutex> lock(streamsMutex_);
+void CameraBufferManager::completeDeferredRelease(
+    StreamInfo* info,
+    uint64_t serial,
+    GraphicBuffer* buffer
+) {
+    // Released before the entry goes so drainDeferred() outlives the pool use
+    info->pool->releaseBuffer(buffer);
+    
+    std::lock_guard<std::mutex> lock(info->mutex);
+    auto it = std::find_if(info->deferred.begin(), info->deferred.end(),
+        [serial](const DeferredRelease& entry) {
+            return entry.serial == serial;
+        });
+    if (it != info->deferred.end()) {
+        info->deferred.erase(it);
+    }
+    info->deferredDone.notify_all();
+}
+
+GraphicBuffer* CameraBufferManager::takeDeferred(
+    StreamInfo* info,
+    bool signaledOnly,
+    Fence& outFence
+) {
+    std::lock_guard<std::mutex> lock(info->mutex);
+    for (auto it = info->deferred.begin(); it != info->deferred.end(); ++it) {
+        if (it->waitId == 0 || (signaledOnly && !it->fence.isSignaled())) {
+            continue;
+        }
+        // Lost to the callback if it already started; it returns the
+        // buffer to the pool instead
+        if (!fenceManager_->cancelWait(it->waitId)) {
+            continue;
+        }
+        
+        GraphicBuffer* buffer = it->buffer;
+        outFence = std::move(it->fence);
+        info->deferred.erase(it);
+        info->deferredDone.notify_all();
+        return buffer;
+    }
+    return nullptr;
+}
+
+bool CameraBufferManager::drainDeferred(StreamInfo* info, uint32_t timeoutMs) {
+    std::unique_lock<std::mutex> lock(info->mutex);
+    info->deferredDone.wait_for(lock, std::chrono::milliseconds(timeoutMs), [info] {
+        return info->deferred.empty();
+    });
+    
+    // Fences that never signaled: reclaim their buffers now
+    for (auto it = info->deferred.begin(); it != info->deferred.end();) {
+        if (it->waitId != 0 && fenceManager_->cancelWait(it->waitId)) {
+            info->pool->releaseBuffer(it->buffer);
+            it = info->deferred.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    
+    // Callbacks already running finish before the pool can go away,
+    // unless one is stuck behind a blocked executor
+    return info->deferredDone.wait_for(lock, std::chrono::milliseconds(kDrainTimeoutMs), [info] {
+        return info->deferred.empty();
+    });
+}
+
+CameraBufferManager::StreamRef CameraBufferManager::getStream(uint32_t streamId) const {
+    // Register under the current epoch; retry if a writer flipped it
+    // before the registration became visible
+    uint64_t epoch;
+    std::atomic<uint32_t>* readers;
+    for (;;) {
+        epoch = tableEpoch_.load();
+        readers = &tableReaders_[epoch & 1].count;
+        readers->fetch_add(1);
+        if (tableEpoch_.load() == epoch) {
+            break;
+        }
+        releaseCount(*readers);
+    }
+    
+    StreamInfo* info = nullptr;
+    if (const StreamTable* table = streamTable_.load()) {
+        auto it = std::lower_bound(table->entries.begin(), table->entries.end(), streamId,
+            [](const std::pair<uint32_t, StreamInfo*>& entry, uint32_t id) {
+                return entry.first < id;
+            });
+        if (it != table->entries.end() && it->first == streamId) {
+            info = it->second;
+            // Counted before leaving the epoch, so a remover that waited
+            // out this epoch sees the reference
+            info->users.fetch_add(1);
+        }
+    }
+    
+    releaseCount(*readers);
+    return StreamRef(this, info);
+}
+
+GraphicBuffer* CameraBufferManager::takeIdleBuffer(StreamInfo* info, Fence& outFence) {
+    // Idle buffers first, then ones whose release fence already signaled,
+    // then growth; a still-busy buffer only before blocking on the pool
+    GraphicBuffer* buffer = nullptr;
+    if (info->pool->getFreeCount() > 0) {
+        buffer = info->pool->acquireBuffer(0);
+    }
+    if (!buffer) {
+        buffer = takeDeferred(info, true, outFence);
+    }
+    if (!buffer && info->pool->getTotalCount() < info->config.poolConfig.maxBuffers) {
+        buffer = info->pool->acquireBuffer(0);
+    }
+    if (!buffer) {
+        buffer = takeDeferred(info, false, outFence);
+    }
+    return buffer;
+}
+
+GraphicBuffer* CameraBufferManager::popPending(StreamInfo* info) {
+    GraphicBuffer* buffer = nullptr;
+    bool popped = info->pending->pop(buffer);
+    
+    // Took the last one, or found nothing: clear readiness, then re-arm if
+    // a producer pushed in between, or quiesceStream() is waking waiters,
+    // since that write may have been cleared too. Clearing on an empty pop
+    // drops a count left by a producer whose buffer another consumer took
+    // before the write landed; otherwise poll() would never block again.
+    if (info->eventFd >= 0 && info->pending->empty()) {
+        uint64_t count;
+        ssize_t ignored = read(info->eventFd, &count, sizeof(count));
+        (void)ignored;
+        if (!info->pending->empty() || info->closing.load()) {
+            uint64_t one = 1;
+            ignored = write(info->eventFd, &one, sizeof(one));
+        }
+    }
+    return popped ? buffer : nullptr;
+}
+
+void CameraBufferManager::publishStreamsLocked() {
+    auto table = std::make_unique<StreamTable>();
+    table->entries.reserve(streams_.size());
+    for (const auto& [id, info] : streams_) {
+        table->entries.emplace_back(id, info.get());
+    }
+    
+    const StreamTable* old = streamTable_.exchange(table.release());
     
-    auto it = streams_.find(streamId);
-    return it != streams_.end() ? it->second.get() : nullptr;
+    // New readers now register under the next epoch and see the new
+    // table; wait out the ones still registered under this one
+    uint64_t epoch = tableEpoch_.fetch_add(1);
+    waitForZero(tableReaders_[epoch & 1].count);
+    delete old;
 }
 
 } // namespace graphics
@@ -0,0 +1,68 @@
+/**
+ * @file CpuFeatures.cpp
+ * @brief Implementation of CpuFeatures class
+ */
+
+#include "CpuFeatures.h"
+#include <algorithm>
+#include <atomic>
+
+namespace android {
+namespace graphics {
+
+namespace {
+
+std::atomic<int> gMaxLevel{static_cast<int>(SimdLevel::AVX2)};
+
+struct DetectedFeatures {
+    SimdLevel level = SimdLevel::SCALAR;
+    bool sse42 = false;
+    
+    DetectedFeatures() {
+#if defined(__x86_64__) || defined(__i386__)
+        __builtin_cpu_init();
+        sse42 = __builtin_cpu_supports("sse4.2");
+        if (__builtin_cpu_supports("avx2")) {
+            level = SimdLevel::AVX2;
+        } else if (__builtin_cpu_supports("sse4.1")) {
+            level = SimdLevel::SSE4_1;
+        }
+#endif
+    }
+};
+
+const DetectedFeatures& getFeatures() {
+    static const DetectedFeatures features;
+    return features;
+}
+
+} // namespace
+
+SimdLevel CpuFeatures::getSimdLevel() {
+    int detected = static_cast<int>(getFeatures().level);
+    return static_cast<SimdLevel>(std::min(detected, gMaxLevel.load(std::memory_order_relaxed)));
+}
+
+SimdLevel CpuFeatures::getDetectedLevel() {
+    return getFeatures().level;
+}
+
+void CpuFeatures::setMaxSimdLevel(SimdLevel level) {
+    gMaxLevel.store(static_cast<int>(level), std::memory_order_relaxed);
+}
+
+bool CpuFeatures::hasSse42() {
+    return getFeatures().sse42 &&
+           gMaxLevel.load(std::memory_order_relaxed) >= static_cast<int>(SimdLevel::SSE4_1);
+}
+
+const char* CpuFeatures::toString(SimdLevel level) {
+    switch (level) {
+        case SimdLevel::SSE4_1: return "SSE4.1";
+        case SimdLevel::AVX2: return "AVX2";
+        default: return "scalar";
+    }
+}
+
+} // namespace graphics
+} // namespace android
@@ -0,0 +1,789 @@
+/**
+ * @file FenceManager.cpp
+ * @brief eventfd-backed implementation of Fence and FenceManager
+ */
+
+#include "FenceManager.h"
+#include "FenceReactor.h"
+#include "FenceTable.h"
+#include "FenceTrace.h"
+#include "GraphicBuffer.h"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <signal.h>
+#include <sstream>
+#include <sys/eventfd.h>
+#include <time.h>
+#include <unistd.h>
+#include <unordered_map>
+
+namespace android {
+namespace graphics {
+
+namespace {
+
+int64_t monotonicNs() {
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<int64_t>(ts.tv_sec) * 1000000000LL + ts.tv_nsec;
+}
+
+/**
+ * Signal by adding the signal time to the counter. The counter starts
+ * at zero and is never read, so it keeps that time for getSignalTime().
+ */
+bool signalEventFd(int fd, int64_t timeNs) {
+    uint64_t value = static_cast<uint64_t>(timeNs);
+    ssize_t ret;
+    do {
+        ret = write(fd, &value, sizeof(value));
+    } while (ret < 0 && errno == EINTR);
+    return ret == static_cast<ssize_t>(sizeof(value));
+}
+
+/**
+ * Signal the write end of a pipe-backed merge. Its read end may already
+ * be closed; that must not raise SIGPIPE in the process.
+ */
+void signalPipe(int fd, int64_t timeNs) {
+    sigset_t pipeSet;
+    sigset_t oldSet;
+    sigset_t pendingSet;
+    sigemptyset(&pipeSet);
+    sigaddset(&pipeSet, SIGPIPE);
+    pthread_sigmask(SIG_BLOCK, &pipeSet, &oldSet);
+    sigpending(&pendingSet);
+    bool wasPending = sigismember(&pendingSet, SIGPIPE);
+    
+    if (!signalEventFd(fd, timeNs) && errno == EPIPE && !wasPending) {
+        // Consume the SIGPIPE this write raised, before unblocking
+        timespec zero = {0, 0};
+        sigtimedwait(&pipeSet, nullptr, &zero);
+    }
+    pthread_sigmask(SIG_SETMASK, &oldSet, nullptr);
+}
+
+/**
+ * Poll one FD, retrying EINTR against the remaining time
+ * @return poll() revents, 0 on timeout, -1 on failure
+ */
+int pollFd(int fd, uint32_t timeoutMs) {
+    using Clock = std::chrono::steady_clock;
+    bool infinite = timeoutMs == UINT32_MAX;
+    Clock::time_point deadline = Clock::now() + std::chrono::milliseconds(timeoutMs);
+    
+    for (;;) {
+        int waitMs = -1;
+        if (!infinite) {
+            auto left = std::chrono::duration_cast<std::chrono::milliseconds>(
+                deadline - Clock::now()).count();
+            waitMs = static_cast<int>(std::max<int64_t>(0, std::min<int64_t>(left, INT32_MAX)));
+        }
+        
+        pollfd pfd{fd, POLLIN, 0};
+        int ret = poll(&pfd, 1, waitMs);
+        if (ret > 0) {
+            return pfd.revents;
+        }
+        if (ret == 0) {
+            return 0;
+        }
+        if (errno != EINTR) {
+            return -1;
+        }
+    }
+}
+
+/**
+ * An errored fence: the read end of a pipe with no writer, which polls
+ * as POLLHUP without POLLIN
+ */
+Fence erroredFence() {
+    int fds[2];
+    if (pipe2(fds, O_CLOEXEC | O_NONBLOCK) != 0) {
+        return Fence();
+    }
+    close(fds[1]);
+    return Fence(fds[0]);
+}
+
+/**
+ * A merged fence still waiting for inputs. Merging a pending merged
+ * fence again adds the new node as a parent instead of watching the
+ * merged FD, so merge chains stay flat: no extra FD or reactor watch
+ * per level, and one signal propagates straight up the tree.
+ * 
+ * An eventfd cannot report an error, so a merge with an input that may
+ * still fail (anything but an eventfd) outputs a pipe instead: writing
+ * to it signals, closing it unwritten errors it.
+ */
+struct MergeNode {
+    std::atomic<size_t> remaining{0};
+    std::atomic<int64_t> latestNs{-1};
+    std::atomic<bool> failed{false};
+    std::atomic<bool> completed{false};                 // Taken by the one completion that uses output
+    Fence output;                                       // Dup of the merged eventfd, or pipe write end
+    bool pipe = false;
+    int64_t id = -1;                                    // eventfd ID of output
+    
+    // Guarded by MergeGraph::mutex
+    bool done = false;
+    std::vector<std::shared_ptr<MergeNode>> parents;
+};
+
+struct MergeGraph {
+    std::mutex mutex;
+    std::unordered_map<int64_t, std::weak_ptr<MergeNode>> pending;  // By eventfd ID
+};
+
+MergeGraph& mergeGraph() {
+    static MergeGraph graph;
+    return graph;
+}
+
+/**
+ * Count one input of node as done, signaling it and then its parents
+ * once their last input arrives. A failed input errors the node and its
+ * parents at once; they are not waited for any longer.
+ */
+void mergeInputDone(std::shared_ptr<MergeNode> node, int64_t signalNs, bool failed = false) {
+    struct Work {
+        std::shared_ptr<MergeNode> node;
+        int64_t inputNs;
+        bool failed;
+    };
+    std::vector<Work> work;
+    work.push_back({std::move(node), signalNs, failed});
+    
+    while (!work.empty()) {
+        Work item = std::move(work.back());
+        work.pop_back();
+        MergeNode& current = *item.node;
+        
+        // Inputs complete inline in merge() and on the reactor thread;
+        // only the completion that claims the node touches its output
+        int64_t outputNs = -1;
+        if (item.failed) {
+            if (current.completed.exchange(true)) {
+                continue;
+            }
+            current.failed.store(true);
+            current.output = Fence();  // Closes the pipe unwritten
+        } else {
+            int64_t latest = current.latestNs.load();
+            while (item.inputNs > latest &&
+                   !current.latestNs.compare_exchange_weak(latest, item.inputNs)) {
+            }
+            if (current.remaining.fetch_sub(1) != 1 || current.completed.exchange(true)) {
+                continue;
+            }
+            
+            latest = current.latestNs.load();
+            outputNs = latest > 0 ? latest : monotonicNs();
+            if (current.pipe) {
+                signalPipe(current.output.getFd(), outputNs);
+                current.output = Fence();  // Data stays readable
+            } else {
+                signalEventFd(current.output.getFd(), outputNs);
+            }
+        }
+        
+        MergeGraph& graph = mergeGraph();
+        std::lock_guard<std::mutex> lock(graph.mutex);
+        current.done = true;
+        auto it = graph.pending.find(current.id);
+        if (it != graph.pending.end() && it->second.lock() == item.node) {
+            graph.pending.erase(it);
+        }
+        for (auto& parent : current.parents) {
+            work.push_back({std::move(parent), outputNs, item.failed});
+        }
+        current.parents.clear();
+    }
+}
+
+/**
+ * Per-thread pollfd scratch for FenceManager::waitMultiple(), reused
+ * across calls so a per-frame wait on every layer does not allocate.
+ */
+struct PollSet {
+    std::vector<pollfd> fds;
+    std::vector<int> indices;       // fds[i] watches fences[indices[i]]
+};
+
+PollSet& threadPollSet() {
+    thread_local PollSet set;
+    return set;
+}
+
+/**
+ * ppoll() until an absolute CLOCK_MONOTONIC deadline (-1 = none),
+ * retrying EINTR
+ * @return ppoll() result, 0 on timeout
+ */
+int ppollUntil(pollfd* fds, size_t count, int64_t deadlineNs) {
+    for (;;) {
+        timespec timeout;
+        timespec* timeoutPtr = nullptr;
+        if (deadlineNs >= 0) {
+            int64_t leftNs = std::max<int64_t>(0, deadlineNs - monotonicNs());
+            timeout.tv_sec = leftNs / 1000000000;
+            timeout.tv_nsec = leftNs % 1000000000;
+            timeoutPtr = &timeout;
+        }
+        
+        int ret = ppoll(fds, count, timeoutPtr, nullptr);
+        if (ret >= 0 || errno != EINTR) {
+            return ret;
+        }
+    }
+}
+
+} // anonymous namespace
+
+// Fence implementation
+
+Fence::Fence() = default;
+
+Fence::Fence(int fd)
+    : fd_(fd)
+{
+}
+
+Fence::Fence(Fence&& other) noexcept
+    : fd_(other.fd_)
+    , eventId_(other.eventId_.load())
+{
+    other.fd_ = -1;
+    other.eventId_.store(kUnknownEventId);
+}
+
+Fence::~Fence() {
+    if (fd_ >= 0) {
+        close(fd_);
+    }
+}
+
+Fence& Fence::operator=(Fence&& other) noexcept {
+    if (this != &other) {
+        if (fd_ >= 0) {
+            close(fd_);
+        }
+        fd_ = other.fd_;
+        eventId_.store(other.eventId_.load());
+        other.fd_ = -1;
+        other.eventId_.store(kUnknownEventId);
+    }
+    return *this;
+}
+
+bool Fence::wait(uint32_t timeoutMs) {
+    if (fd_ < 0) {
+        return true;  // No fence
+    }
+    int revents = pollFd(fd_, timeoutMs);
+    return revents > 0 && (revents & POLLIN);
+}
+
+bool Fence::isSignaled() const {
+    FenceState state = getState();
+    return state == FenceState::SIGNALED || state == FenceState::INVALID;
+}
+
+FenceState Fence::getState() const {
+    if (fd_ < 0) {
+        return FenceState::INVALID;
+    }
+    int revents = pollFd(fd_, 0);
+    if (revents == 0) {
+        return FenceState::UNSIGNALED;
+    }
+    if (revents < 0 || !(revents & POLLIN)) {
+        return FenceState::ERROR;
+    }
+    return FenceState::SIGNALED;
+}
+
+int Fence::dup() const {
+    if (fd_ < 0) {
+        return -1;
+    }
+    return fcntl(fd_, F_DUPFD_CLOEXEC, 0);
+}
+
+int Fence::release() {
+    int fd = fd_;
+    fd_ = -1;
+    eventId_.store(kUnknownEventId);
+    return fd;
+}
+
+int64_t Fence::eventId() const {
+    // The FD is owned, so its identity cannot change; racing readers
+    // store the same value
+    int64_t id = eventId_.load();
+    if (id == kUnknownEventId) {
+        id = fd_ >= 0 ? eventFdId(fd_) : -1;
+        eventId_.store(id);
+    }
+    return id;
+}
+
+Fence Fence::createSignaled() {
+    Fence fence(eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK));
+    if (fence.isValid()) {
+        signalEventFd(fence.getFd(), monotonicNs());
+    }
+    return fence;
+}
+
+Fence Fence::merge(const std::vector<Fence>& fences) {
+    // Signaled inputs only set the timestamp and invalid ones are no
+    // fence; an errored input errors the result, as sync_merge does
+    std::vector<const Fence*> unsignaled;
+    std::vector<int64_t> ids;
+    const Fence* latestSignaled = nullptr;
+    int64_t latestNs = -1;
+    for (const Fence& fence : fences) {
+        FenceState state = fence.getState();
+        if (state == FenceState::SIGNALED) {
+            int64_t signalNs = fence.getSignalTime();
+            if (!latestSignaled || signalNs > latestNs) {
+                latestSignaled = &fence;
+                latestNs = signalNs;
+            }
+        } else if (state == FenceState::ERROR) {
+            return erroredFence();
+        } else if (state == FenceState::UNSIGNALED) {
+            // The same fence given twice is waited for once
+            int64_t id = fence.eventId();
+            if (id < 0 || std::find(ids.begin(), ids.end(), id) == ids.end()) {
+                unsignaled.push_back(&fence);
+                ids.push_back(id);
+            }
+        }
+    }
+    
+    // Nothing left to combine: reuse an input instead of a new fence.
+    // A pending input signals after every already-signaled one, so its
+    // signal time is the merged time.
+    if (unsignaled.empty()) {
+        return latestSignaled ? Fence(latestSignaled->dup()) : Fence();
+    }
+    if (unsignaled.size() == 1) {
+        Fence shared(unsignaled[0]->dup());
+        if (shared.isValid()) {
+            shared.eventId_.store(ids[0]);
+        }
+        return shared;
+    }
+    
+    auto node = std::make_shared<MergeNode>();
+    node->pipe = std::find(ids.begin(), ids.end(), -1) != ids.end();
+    
+    Fence merged;
+    if (node->pipe) {
+        int fds[2];
+        if (pipe2(fds, O_CLOEXEC | O_NONBLOCK) != 0) {
+            return merged;
+        }
+        merged = Fence(fds[0]);
+        node->output = Fence(fds[1]);
+    } else {
+        merged = Fence(eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK));
+        if (!merged.isValid()) {
+            return merged;
+        }
+        node->output = Fence(merged.dup());
+        node->id = merged.eventId();  // Cached, so merging it again reads nothing
+    }
+    node->remaining.store(unsignaled.size());
+    node->latestNs.store(latestNs);
+    
+    // Pending merged inputs take the new node as a parent; the rest
+    // are watched by the reactor
+    std::vector<Fence> watched;
+    {
+        MergeGraph& graph = mergeGraph();
+        std::lock_guard<std::mutex> lock(graph.mutex);
+        for (size_t i = 0; i < unsignaled.size(); ++i) {
+            std::shared_ptr<MergeNode> child;
+            if (ids[i] >= 0) {
+                auto it = graph.pending.find(ids[i]);
+                if (it != graph.pending.end()) {
+                    child = it->second.lock();
+                }
+            }
+            if (child && !child->done) {
+                child->parents.push_back(node);
+            } else {
+                watched.emplace_back(unsignaled[i]->dup());
+            }
+        }
+        if (node->id >= 0) {
+            graph.pending[node->id] = node;
+        }
+    }
+    
+    for (Fence& fence : watched) {
+        FenceReactor::getShared().watch(std::move(fence), [node](Fence& input, FenceState state) {
+            mergeInputDone(node, input.getSignalTime(), state == FenceState::ERROR);
+        });
+    }
+    
+    // Eventfd inputs only fail here, when they cannot be watched, and
+    // the eventfd output cannot carry that
+    if (!node->pipe && node->failed.load()) {
+        return erroredFence();
+    }
+    return merged;
+}
+
+Fence Fence::merge(Fence&& a, Fence&& b) {
+    // Hand back the only input that still matters without a dup
+    FenceState stateA = a.getState();
+    FenceState stateB = b.getState();
+    bool doneA = stateA == FenceState::SIGNALED || stateA == FenceState::INVALID;
+    bool doneB = stateB == FenceState::SIGNALED || stateB == FenceState::INVALID;
+    if (stateA == FenceState::UNSIGNALED && doneB) {
+        return std::move(a);
+    }
+    if (stateB == FenceState::UNSIGNALED && doneA) {
+        return std::move(b);
+    }
+    
+    std::vector<Fence> fences;
+    fences.push_back(std::move(a));
+    fences.push_back(std::move(b));
+    return merge(fences);
+}
+
+int64_t Fence::getSignalTime() const {
+    if (getState() != FenceState::SIGNALED) {
+        return -1;
+    }
+    
+    // The eventfd counter holds the signal time; fdinfo reads it
+    // without consuming it. Other fence types (e.g. a sync_file) have
+    // no such field.
+    uint64_t count;
+    if (!readFdInfo(fd_, "eventfd-count:", 16, count)) {
+        return -1;
+    }
+    return static_cast<int64_t>(count);
+}
+
+// FenceManager implementation
+
+FenceManager::FenceManager()
+    : FenceManager(FenceManagerConfig())
+{
+}
+
+FenceManager::FenceManager(const FenceManagerConfig& config)
+    : names_(std::make_unique<NameTable>())
+    , fences_(std::make_unique<FenceTable>())
+    , config_(config)
+{
+    if (config_.traceCapacity > 0) {
+        trace_ = std::make_unique<FenceTrace>(config_.traceCapacity);
+    }
+}
+
+FenceManager::~FenceManager() {
+    // Runs outstanding callbacks before the tracked fences go away
+    reactor_.reset();
+}
+
+Fence FenceManager::createFence(const char* name) {
+    Fence fence(eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK));
+    if (!fence.isValid()) {
+        return fence;
+    }
+    
+    uint64_t number = fenceCounter_.fetch_add(1) + 1;
+    const char* interned = names_->intern(name);
+    int64_t eventId = fence.eventId();
+    int64_t now = monotonicNs();
+    if (!fences_->insert(fence.getFd(), eventId, interned, number, now)) {
+        // Table full: retry once after reclaiming, else leave untracked
+        fences_->reclaim();
+        fences_->insert(fence.getFd(), eventId, interned, number, now);
+    }
+    
+    if (trace_) {
+        trace_->record(FenceTraceEventType::CREATE, number, interned, -1, now);
+    }
+    return fence;
+}
+
+bool FenceManager::signalFence(Fence& fence) {
+    if (!fence.isValid()) {
+        return false;
+    }
+    
+    // Serialized so two signalers cannot both add a timestamp
+    std::lock_guard<std::mutex> lock(signalMutex_);
+    if (fence.isSignaled()) {
+        return true;
+    }
+    int64_t now = monotonicNs();
+    if (!signalEventFd(fence.getFd(), now)) {
+        return false;
+    }
+    
+    // Signaled fences are freed in batches, never on the create path
+    uint64_t fenceId = 0;
+    const char* name = nullptr;
+    int64_t createTime = -1;
+    FenceTable::Handle handle = fences_->find(fence.getFd(), fence.eventId(), fenceId, name,
+                                              createTime);
+    if (handle && fences_->markSignaled(handle, now) &&
+        fences_->getQueuedCount() >= kReclaimBatch) {
+        fences_->reclaim();
+    }
+    
+    if (trace_) {
+        int64_t latencyNs = createTime >= 0 ? now - createTime : -1;
+        if (latencyNs >= 0) {
+            trace_->getSignalLatency().record(latencyNs);
+        }
+        trace_->record(FenceTraceEventType::SIGNAL, fenceId, name, latencyNs, now);
+    }
+    return true;
+}
+
+uint64_t FenceManager::waitAsync(Fence&& fence, SignalCallback callback) {
+    return waitAsync(std::move(fence), std::move(callback), FenceReactor::kNoTimeout);
+}
+
+uint64_t FenceManager::waitAsync(Fence&& fence, SignalCallback callback, uint32_t timeoutMs) {
+    if (!callback) return 0;
+    
+    if (trace_ && fence.isValid()) {
+        uint64_t fenceId;
+        const char* name;
+        traceWait(fence, fenceId, name);
+        callback = [this, fenceId, name, callback = std::move(callback)](Fence* signaled, FenceState state) {
+            traceWake(*signaled, state, fenceId, name);
+            callback(signaled, state);
+        };
+    }
+    
+    return getReactor()->watch(std::move(fence),
+        [callback = std::move(callback)](Fence& signaled, FenceState state) {
+            callback(&signaled, state);
+        },
+        timeoutMs);
+}
+
+bool FenceManager::cancelWait(uint64_t waitId) {
+    std::lock_guard<std::mutex> lock(reactorMutex_);
+    return reactor_ && reactor_->cancel(waitId);
+}
+
+size_t FenceManager::getPendingWaitCount() const {
+    std::lock_guard<std::mutex> lock(reactorMutex_);
+    return reactor_ ? reactor_->getPendingCount() : 0;
+}
+
+FenceReactor* FenceManager::getReactor() {
+    std::lock_guard<std::mutex> lock(reactorMutex_);
+    if (!reactor_) {
+        FenceReactorConfig config;
+        config.callbackThreads = config_.callbackThreads;
+        config.maxQueuedCallbacks = config_.maxQueuedCallbacks;
+        config.tickMs = config_.timerResolutionMs;
+        reactor_ = std::make_unique<FenceReactor>(config);
+    }
+    return reactor_.get();
+}
+
+int FenceManager::waitMultiple(
+    const std::vector<Fence*>& fences,
+    bool waitAll,
+    uint32_t timeoutMs
+) {
+    if (!trace_) {
+        return pollFences(fences, waitAll, timeoutMs);
+    }
+    
+    struct TracedWait {
+        uint64_t fenceId;
+        const char* name;
+    };
+    std::vector<TracedWait> traced(fences.size());
+    for (size_t i = 0; i < fences.size(); ++i) {
+        if (fences[i] && fences[i]->isValid()) {
+            traceWait(*fences[i], traced[i].fenceId, traced[i].name);
+        }
+    }
+    int result = pollFences(fences, waitAll, timeoutMs);
+    for (size_t i = 0; i < fences.size(); ++i) {
+        if (fences[i] && fences[i]->isValid()) {
+            traceWake(*fences[i], fences[i]->getState(), traced[i].fenceId, traced[i].name);
+        }
+    }
+    return result;
+}
+
+int FenceManager::pollFences(
+    const std::vector<Fence*>& fences,
+    bool waitAll,
+    uint32_t timeoutMs
+) {
+    if (fences.empty()) {
+        return -1;
+    }
+    
+    PollSet& set = threadPollSet();
+    set.fds.clear();
+    set.indices.clear();
+    for (size_t i = 0; i < fences.size(); ++i) {
+        if (!fences[i] || !fences[i]->isValid()) {
+            if (!waitAll) {
+                return static_cast<int>(i);  // No fence: already signaled
+            }
+            continue;
+        }
+        set.fds.push_back(pollfd{fences[i]->getFd(), POLLIN, 0});
+        set.indices.push_back(static_cast<int>(i));
+    }
+    
+    int64_t deadlineNs = timeoutMs == UINT32_MAX
+        ? -1
+        : monotonicNs() + static_cast<int64_t>(timeoutMs) * 1000000;
+    
+    // One ppoll() per wake-up over every fence still pending; fences that
+    // already signaled make the first call return immediately
+    while (!set.fds.empty()) {
+        int ret = ppollUntil(set.fds.data(), set.fds.size(), deadlineNs);
+        if (ret <= 0) {
+            return -1;
+        }
+        
+        // waitAll: drop signaled fences and wait again on the rest.
+        // Any: drop errored fences, which will never signal, and wait
+        // again on the rest for one that does.
+        size_t kept = 0;
+        for (size_t i = 0; i < set.fds.size(); ++i) {
+            short revents = set.fds[i].revents;
+            if (revents & POLLIN) {
+                if (!waitAll) {
+                    return set.indices[i];
+                }
+                continue;
+            }
+            if (revents != 0) {
+                if (waitAll) {
+                    return -1;  // POLLERR/POLLNVAL: it will never signal
+                }
+                continue;
+            }
+            set.fds[kept] = set.fds[i];
+            set.indices[kept] = set.indices[i];
+            kept++;
+        }
+        set.fds.resize(kept);
+        set.indices.resize(kept);
+    }
+    return waitAll ? static_cast<int>(fences.size() - 1) : -1;  // Any: every fence errored
+}
+
+size_t FenceManager::getActiveFenceCount() const {
+    size_t count = 0;
+    fences_->forEach([&count](const FenceSlot& slot) {
+        if (!slot.queued.load()) {
+            count++;
+        }
+    });
+    return count;
+}
+
+std::string FenceManager::dumpTimeline() const {
+    int64_t now = monotonicNs();
+    
+    // Slots are unordered; sort lines by creation number
+    std::vector<std::pair<uint64_t, std::string>> lines;
+    fences_->forEach([&](const FenceSlot& slot) {
+        std::ostringstream line;
+        line << "  " << slot.name << "#" << slot.sequence << ": ";
+        int64_t signalTime = slot.signalTime.load();
+        if (signalTime >= 0) {
+            line << "signaled after " << (signalTime - slot.createTime) / 1000 << " us";
+        } else if (slot.queued.load()) {
+            line << "closed unsignaled";
+        } else {
+            line << "pending for " << (now - slot.createTime) / 1000 << " us";
+        }
+        if (GraphicBuffer* buffer = slot.associatedBuffer.load()) {
+            line << ", buffer " << buffer->getBufferId();
+        }
+        line << "\n";
+        lines.emplace_back(slot.sequence, line.str());
+    });
+    std::sort(lines.begin(), lines.end());
+    
+    std::ostringstream ss;
+    ss << "FenceManager Timeline:\n";
+    ss << "  Created: " << fenceCounter_.load() << ", tracked: " << lines.size() << "\n";
+    for (const auto& line : lines) {
+        ss << line.second;
+    }
+    if (trace_) {
+        ss << "  Create->signal: " << trace_->getSignalLatency().snapshot().toString();
+        ss << "  Signal->wake: " << trace_->getWakeLatency().snapshot().toString();
+    }
+    return ss.str();
+}
+
+void FenceManager::associateFenceWithBuffer(Fence* fence, GraphicBuffer* buffer) {
+    if (!fence || !fence->isValid()) return;
+    
+    fences_->associate(fence->getFd(), fence->eventId(), buffer);
+}
+
+std::string FenceManager::exportTrace() const {
+    return trace_ ? trace_->exportChromeJson() : std::string();
+}
+
+LatencyHistogram::Snapshot FenceManager::getSignalLatency() const {
+    return trace_ ? trace_->getSignalLatency().snapshot() : LatencyHistogram::Snapshot();
+}
+
+LatencyHistogram::Snapshot FenceManager::getWakeLatency() const {
+    return trace_ ? trace_->getWakeLatency().snapshot() : LatencyHistogram::Snapshot();
+}
+
+void FenceManager::traceWait(const Fence& fence, uint64_t& fenceId, const char*& name) const {
+    // Dups resolve to their fence; foreign fences are traced as ID 0
+    int64_t createTime;
+    fenceId = 0;
+    name = nullptr;
+    fences_->find(fence.getFd(), fence.eventId(), fenceId, name, createTime);
+    trace_->record(FenceTraceEventType::WAIT, fenceId, name);
+}
+
+void FenceManager::traceWake(const Fence& fence, FenceState state,
+                             uint64_t fenceId, const char* name) const {
+    // Timeouts and errors close the wait without a latency
+    int64_t latencyNs = -1;
+    if (state == FenceState::SIGNALED) {
+        int64_t signalTime = fence.getSignalTime();
+        if (signalTime >= 0) {
+            latencyNs = std::max<int64_t>(0, monotonicNs() - signalTime);
+            trace_->getWakeLatency().record(latencyNs);
+        }
+    }
+    trace_->record(FenceTraceEventType::WAKE, fenceId, name, latencyNs);
+}
+
+} // namespace graphics
+} // namespace android
@@ -0,0 +1,322 @@
+/**
+ * @file FenceReactor.cpp
+ * @brief Implementation of FenceReactor class
+ */
+
+#include "FenceReactor.h"
+#include <algorithm>
+#include <cerrno>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+
+namespace android {
+namespace graphics {
+
+namespace {
+
+// epoll user data for the reactor's own FDs; wait IDs start at 1
+constexpr uint64_t kWakeId = 0;
+constexpr uint64_t kTimerId = UINT64_MAX;
+
+constexpr int kMaxEvents = 64;
+
+void drainCounter(int fd) {
+    uint64_t count;
+    while (read(fd, &count, sizeof(count)) < 0 && errno == EINTR) {
+    }
+}
+
+} // anonymous namespace
+
+FenceReactor::FenceReactor(const FenceReactorConfig& config)
+    : config_(config)
+    , epoch_(Clock::now())
+{
+    config_.tickMs = std::max<uint32_t>(config_.tickMs, 1);
+    config_.wheelSlots = std::max<uint32_t>(config_.wheelSlots, 1);
+    wheel_.resize(config_.wheelSlots);
+    
+    epollFd_ = epoll_create1(EPOLL_CLOEXEC);
+    wakeFd_ = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    timerFd_ = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC | TFD_NONBLOCK);
+    
+    epoll_event event = {};
+    event.events = EPOLLIN;
+    event.data.u64 = kWakeId;
+    epoll_ctl(epollFd_, EPOLL_CTL_ADD, wakeFd_, &event);
+    event.data.u64 = kTimerId;
+    epoll_ctl(epollFd_, EPOLL_CTL_ADD, timerFd_, &event);
+    
+    for (uint32_t i = 0; i < config_.callbackThreads; ++i) {
+        executors_.emplace_back(&FenceReactor::executorLoop, this);
+    }
+    reactorThread_ = std::thread(&FenceReactor::reactorLoop, this);
+}
+
+FenceReactor::~FenceReactor() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    uint64_t one = 1;
+    while (write(wakeFd_, &one, sizeof(one)) < 0 && errno == EINTR) {
+    }
+    reactorThread_.join();
+    
+    // Report the waits nobody will complete
+    std::vector<Completion> remaining;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        std::vector<uint64_t> ids;
+        ids.reserve(waits_.size());
+        for (const auto& entry : waits_) {
+            ids.push_back(entry.first);
+        }
+        for (uint64_t id : ids) {
+            remaining.push_back(takeLocked(id, FenceState::UNSIGNALED));
+            remaining.back().state = remaining.back().fence.getState();
+        }
+    }
+    for (Completion& completion : remaining) {
+        dispatch(std::move(completion));
+    }
+    
+    // Executors drain their queue before exiting
+    {
+        std::lock_guard<std::mutex> lock(executorMutex_);
+        executorStopping_ = true;
+    }
+    completionReady_.notify_all();
+    for (auto& executor : executors_) {
+        executor.join();
+    }
+    
+    for (int fd : {timerFd_, wakeFd_, epollFd_}) {
+        if (fd >= 0) {
+            close(fd);
+        }
+    }
+}
+
+FenceReactor& FenceReactor::getShared() {
+    static FenceReactor reactor([] {
+        FenceReactorConfig config;
+        config.callbackThreads = 0;
+        return config;
+    }());
+    return reactor;
+}
+
+uint64_t FenceReactor::watch(Fence&& fence, Callback callback, uint32_t timeoutMs) {
+    if (!callback) return 0;
+    
+    FenceState state = fence.getState();
+    if (state != FenceState::UNSIGNALED || timeoutMs == 0) {
+        callback(fence, state);
+        return 0;
+    }
+    
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (stopping_) {
+        lock.unlock();
+        callback(fence, state);
+        return 0;
+    }
+    
+    uint64_t id = nextWaitId_++;
+    epoll_event event = {};
+    event.events = EPOLLIN | EPOLLONESHOT;
+    event.data.u64 = id;
+    if (epoll_ctl(epollFd_, EPOLL_CTL_ADD, fence.getFd(), &event) != 0) {
+        // Not pollable (or out of epoll watches)
+        lock.unlock();
+        callback(fence, FenceState::ERROR);
+        return 0;
+    }
+    
+    Wait& wait = waits_[id];
+    wait.fence = std::move(fence);
+    wait.callback = std::move(callback);
+    
+    if (timeoutMs != kNoTimeout) {
+        uint64_t ticks = (static_cast<uint64_t>(timeoutMs) + config_.tickMs - 1) / config_.tickMs;
+        wait.deadlineTick = currentTick() + std::max<uint64_t>(ticks, 1);
+        wheel_[wait.deadlineTick % wheel_.size()].push_back(id);
+        timedWaits_++;
+        if (armedTick_ == 0 || wait.deadlineTick < armedTick_) {
+            armTimerLocked(wait.deadlineTick);
+        }
+    }
+    return id;
+}
+
+bool FenceReactor::cancel(uint64_t waitId) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (waits_.find(waitId) == waits_.end()) {
+        return false;  // Already completed or cancelled
+    }
+    // Closes the fence; its wheel entry is dropped lazily
+    takeLocked(waitId, FenceState::UNSIGNALED);
+    return true;
+}
+
+size_t FenceReactor::getPendingCount() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return waits_.size();
+}
+
+uint64_t FenceReactor::currentTick() const {
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(Clock::now() - epoch_);
+    return static_cast<uint64_t>(elapsed.count()) / config_.tickMs;
+}
+
+void FenceReactor::armTimerLocked(uint64_t tick) {
+    itimerspec spec = {};
+    if (tick != 0) {
+        Clock::time_point due = epoch_ + std::chrono::milliseconds(tick * config_.tickMs);
+        int64_t delayNs = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            due - Clock::now()).count();
+        delayNs = std::max<int64_t>(delayNs, 1);  // 0 would disarm
+        spec.it_value.tv_sec = delayNs / 1000000000;
+        spec.it_value.tv_nsec = delayNs % 1000000000;
+    }
+    timerfd_settime(timerFd_, 0, &spec, nullptr);
+    armedTick_ = tick;
+}
+
+void FenceReactor::expireTimersLocked(std::vector<Completion>& expired) {
+    uint64_t now = currentTick();
+    uint64_t slots = wheel_.size();
+    
+    // After a long stall every slot is visited once
+    uint64_t from = processedTick_ + 1;
+    if (now > processedTick_ && now - processedTick_ > slots) {
+        from = now - slots + 1;
+    }
+    for (uint64_t tick = from; tick <= now; ++tick) {
+        std::vector<uint64_t>& slot = wheel_[tick % slots];
+        for (size_t i = 0; i < slot.size();) {
+            auto it = waits_.find(slot[i]);
+            bool stale = it == waits_.end() || it->second.deadlineTick == 0;
+            bool due = !stale && it->second.deadlineTick <= now;
+            if (due) {
+                expired.push_back(takeLocked(slot[i], FenceState::UNSIGNALED));
+            }
+            if (stale || due) {
+                slot[i] = slot.back();
+                slot.pop_back();
+            } else {
+                ++i;  // Due on a later revolution
+            }
+        }
+    }
+    processedTick_ = std::max(processedTick_, now);
+    
+    // Sleep until the next occupied slot
+    uint64_t next = 0;
+    if (timedWaits_ > 0) {
+        for (uint64_t tick = now + 1; tick <= now + slots; ++tick) {
+            if (!wheel_[tick % slots].empty()) {
+                next = tick;
+                break;
+            }
+        }
+    }
+    armTimerLocked(next);
+}
+
+FenceReactor::Completion FenceReactor::takeLocked(uint64_t waitId, FenceState state) {
+    auto it = waits_.find(waitId);
+    Wait& wait = it->second;
+    epoll_ctl(epollFd_, EPOLL_CTL_DEL, wait.fence.getFd(), nullptr);
+    if (wait.deadlineTick != 0) {
+        timedWaits_--;
+    }
+    
+    Completion completion{std::move(wait.fence), std::move(wait.callback), state};
+    waits_.erase(it);
+    return completion;
+}
+
+void FenceReactor::dispatch(Completion&& completion) {
+    if (!executors_.empty()) {
+        std::unique_lock<std::mutex> lock(executorMutex_);
+        if (completions_.size() < config_.maxQueuedCallbacks && !executorStopping_) {
+            completions_.push_back(std::move(completion));
+            lock.unlock();
+            completionReady_.notify_one();
+            return;
+        }
+    }
+    // No executor, or it is saturated: never drop a callback
+    completion.callback(completion.fence, completion.state);
+}
+
+void FenceReactor::reactorLoop() {
+    epoll_event events[kMaxEvents];
+    std::vector<Completion> ready;
+    
+    for (;;) {
+        int count = epoll_wait(epollFd_, events, kMaxEvents, -1);
+        if (count < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            break;
+        }
+        
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (stopping_) {
+                break;
+            }
+            
+            bool timerFired = false;
+            for (int i = 0; i < count; ++i) {
+                uint64_t id = events[i].data.u64;
+                if (id == kWakeId) {
+                    drainCounter(wakeFd_);
+                } else if (id == kTimerId) {
+                    drainCounter(timerFd_);
+                    timerFired = true;
+                } else if (waits_.find(id) != waits_.end()) {
+                    FenceState state = (events[i].events & EPOLLIN)
+                        ? FenceState::SIGNALED
+                        : FenceState::ERROR;
+                    ready.push_back(takeLocked(id, state));
+                }
+            }
+            if (timerFired) {
+                expireTimersLocked(ready);
+            }
+        }
+        
+        for (Completion& completion : ready) {
+            dispatch(std::move(completion));
+        }
+        ready.clear();
+    }
+}
+
+void FenceReactor::executorLoop() {
+    std::unique_lock<std::mutex> lock(executorMutex_);
+    for (;;) {
+        completionReady_.wait(lock, [this] {
+            return executorStopping_ || !completions_.empty();
+        });
+        if (completions_.empty()) {
+            return;  // Stopping and drained
+        }
+        
+        Completion completion = std::move(completions_.front());
+        completions_.pop_front();
+        lock.unlock();
+        completion.callback(completion.fence, completion.state);
+        lock.lock();
+    }
+}
+
+} // namespace graphics
+} // namespace android
@@ -0,0 +1,131 @@
+/**
+ * @file FenceReactor.h
+ * @brief Internal epoll reactor that runs callbacks as fences signal
+ * 
+ * Backs FenceManager::waitAsync() and Fence::merge(). One thread waits
+ * on an epoll set holding every watched fence FD, a wake eventfd and a
+ * timerfd that drives a hashed timing wheel for wait timeouts, so
+ * thousands of outstanding waits cost one thread. Callbacks run on a
+ * small executor with a bounded queue; when it is full the reactor
+ * runs the callback itself rather than drop it.
+ */
+
+#pragma once
+
+#include "FenceManager.h"
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace android {
+namespace graphics {
+
+/**
+ * @brief Reactor sizing
+ */
+struct FenceReactorConfig {
+    uint32_t callbackThreads = 2;      ///< Executor threads (0 = run on the reactor thread)
+    size_t maxQueuedCallbacks = 256;   ///< Executor queue bound
+    uint32_t tickMs = 1;               ///< Timeout resolution
+    uint32_t wheelSlots = 512;         ///< Timing wheel size (ticks per revolution)
+};
+
+class FenceReactor {
+public:
+    /// Receives SIGNALED, ERROR, UNSIGNALED on timeout, or the current
+    /// state when the reactor shuts down
+    using Callback = std::function<void(Fence& fence, FenceState state)>;
+    
+    static constexpr uint32_t kNoTimeout = UINT32_MAX;
+    
+    explicit FenceReactor(const FenceReactorConfig& config = FenceReactorConfig());
+    
+    /**
+     * @brief Destructor - stops the reactor; pending callbacks run with
+     *        the fence's current state
+     */
+    ~FenceReactor();
+    
+    FenceReactor(const FenceReactor&) = delete;
+    FenceReactor& operator=(const FenceReactor&) = delete;
+    
+    /**
+     * @brief Process-wide reactor for fences without a manager
+     * 
+     * Runs callbacks on the reactor thread; they must be short.
+     */
+    static FenceReactor& getShared();
+    
+    /**
+     * @brief Run callback once fence signals or the timeout expires
+     * 
+     * Fences that are invalid, already signaled or not pollable, and
+     * zero timeouts, complete immediately on the calling thread.
+     * 
+     * @return Wait ID for cancel(), or 0 if the callback already ran
+     */
+    uint64_t watch(Fence&& fence, Callback callback, uint32_t timeoutMs = kNoTimeout);
+    
+    /**
+     * @brief Cancel a pending wait
+     * @return True if the callback will not run
+     */
+    bool cancel(uint64_t waitId);
+    
+    size_t getPendingCount() const;
+
+private:
+    using Clock = std::chrono::steady_clock;
+    
+    struct Wait {
+        Fence fence;
+        Callback callback;
+        uint64_t deadlineTick = 0;      // 0 = no timeout
+    };
+    
+    struct Completion {
+        Fence fence;
+        Callback callback;
+        FenceState state;
+    };
+    
+    FenceReactorConfig config_;
+    int epollFd_ = -1;
+    int wakeFd_ = -1;
+    int timerFd_ = -1;
+    Clock::time_point epoch_;
+    
+    // Pending waits by ID; the wheel holds IDs and is cleaned lazily
+    std::unordered_map<uint64_t, Wait> waits_;
+    std::vector<std::vector<uint64_t>> wheel_;
+    uint64_t processedTick_ = 0;
+    uint64_t armedTick_ = 0;            // 0 = timer disarmed
+    size_t timedWaits_ = 0;
+    uint64_t nextWaitId_ = 1;
+    bool stopping_ = false;
+    mutable std::mutex mutex_;
+    std::thread reactorThread_;
+    
+    // Callback executor
+    std::deque<Completion> completions_;
+    std::vector<std::thread> executors_;
+    bool executorStopping_ = false;
+    std::mutex executorMutex_;
+    std::condition_variable completionReady_;
+    
+    uint64_t currentTick() const;
+    void armTimerLocked(uint64_t tick);
+    void expireTimersLocked(std::vector<Completion>& expired);
+    Completion takeLocked(uint64_t waitId, FenceState state);
+    void dispatch(Completion&& completion);
+    void reactorLoop();
+    void executorLoop();
+};
+
+} // namespace graphics
+} // namespace android
@@ -0,0 +1,403 @@
+/**
+ * @file FenceTable.cpp
+ * @brief Implementation of NameTable and FenceTable
+ */
+
+#include "FenceTable.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace android {
+namespace graphics {
+
+namespace {
+
+enum SlotState : uint32_t {
+    kSlotFree = 0,      // On the free list (or never used)
+    kSlotClaimed,       // Being filled by insert()
+    kSlotLive,
+    kSlotRetiring       // Being emptied by the reclaimer
+};
+
+const char kDefaultName[] = "fence";
+
+uint32_t hashName(const char* name) {
+    // FNV-1a
+    uint32_t hash = 2166136261u;
+    for (; *name; ++name) {
+        hash = (hash ^ static_cast<uint8_t>(*name)) * 16777619u;
+    }
+    return hash;
+}
+
+} // anonymous namespace
+
+bool readFdInfo(int fd, const char* field, int base, uint64_t& value) {
+    char path[64];
+    std::snprintf(path, sizeof(path), "/proc/self/fdinfo/%d", fd);
+    int infoFd = open(path, O_RDONLY | O_CLOEXEC);
+    if (infoFd < 0) {
+        return false;
+    }
+    char info[512];
+    ssize_t len = read(infoFd, info, sizeof(info) - 1);
+    close(infoFd);
+    if (len <= 0) {
+        return false;
+    }
+    info[len] = '\0';
+    
+    const char* found = std::strstr(info, field);
+    if (!found) {
+        return false;
+    }
+    value = std::strtoull(found + std::strlen(field), nullptr, base);
+    return true;
+}
+
+int64_t eventFdId(int fd) {
+    uint64_t id;
+    return readFdInfo(fd, "eventfd-id:", 10, id) ? static_cast<int64_t>(id) : -1;
+}
+
+// NameTable implementation
+
+NameTable::~NameTable() {
+    for (auto& name : names_) {
+        std::free(name.load());
+    }
+}
+
+const char* NameTable::intern(const char* name) {
+    if (!name) {
+        return kDefaultName;
+    }
+    
+    char* copy = nullptr;
+    uint32_t hash = hashName(name);
+    for (size_t probe = 0; probe < kCapacity; ++probe) {
+        std::atomic<char*>& entry = names_[(hash + probe) % kCapacity];
+        char* existing = entry.load();
+        if (!existing) {
+            if (!copy) {
+                copy = strdup(name);
+                if (!copy) {
+                    return kDefaultName;
+                }
+            }
+            if (entry.compare_exchange_strong(existing, copy)) {
+                return copy;
+            }
+            // Lost the race; existing now holds the winner
+        }
+        if (std::strcmp(existing, name) == 0) {
+            std::free(copy);
+            return existing;
+        }
+    }
+    
+    std::free(copy);
+    return kDefaultName;
+}
+
+// FenceTable implementation
+
+FenceTable::FenceTable() = default;
+
+FenceTable::~FenceTable() {
+    for (auto& chunk : chunks_) {
+        delete[] chunk.load();
+    }
+    for (auto& chunk : fdChunks_) {
+        delete[] chunk.load();
+    }
+    for (auto& chunk : idChunks_) {
+        delete[] chunk.load();
+    }
+}
+
+FenceTable::Handle FenceTable::insert(int clientFd, int64_t eventId, const char* name,
+                                      uint64_t sequence, int64_t createTime) {
+    uint32_t index;
+    FenceSlot* claimed = nullptr;
+    if (popFree(index)) {
+        claimed = &slotRef(index);  // Recycled slots live in existing chunks
+    } else {
+        uint32_t highWater = highWater_.load();
+        do {
+            if (highWater >= kMaxSlots) {
+                return 0;
+            }
+        } while (!highWater_.compare_exchange_weak(highWater, highWater + 1));
+        index = highWater;
+        
+        std::atomic<FenceSlot*>& chunk = chunks_[index >> kChunkShift];
+        FenceSlot* slots = chunk.load();
+        if (!slots) {
+            FenceSlot* fresh = new FenceSlot[kChunkSize];
+            if (chunk.compare_exchange_strong(slots, fresh)) {
+                slots = fresh;
+            } else {
+                delete[] fresh;  // Lost the race; slots holds the winner's
+            }
+        }
+        claimed = &slots[index & (kChunkSize - 1)];
+    }
+    if (!claimed) {
+        return 0;
+    }
+    
+    FenceSlot& slot = *claimed;
+    slot.state.store(kSlotClaimed);
+    slot.clientFd = clientFd;
+    slot.eventId = eventId;
+    slot.name = name;
+    slot.sequence = sequence;
+    slot.createTime = createTime;
+    slot.signalTime.store(-1);
+    slot.associatedBuffer.store(nullptr);
+    Handle handle = static_cast<Handle>(slot.generation) << 32 | index;
+    slot.state.store(kSlotLive);
+    liveCount_++;
+    
+    // Newest wins: the number was free again, so the fence that had it
+    // before was closed
+    if (std::atomic<Handle>* entry = indexEntry(fdChunks_, clientFd, true)) {
+        Handle previous = entry->exchange(handle);
+        if (previous != 0) {
+            queueRetire(previous, -1);
+        }
+    }
+    // Likewise an eventfd ID is reused only once every dup is closed
+    if (std::atomic<Handle>* entry = indexEntry(idChunks_, eventId, true)) {
+        Handle previous = entry->exchange(handle);
+        if (previous != 0) {
+            queueRetire(previous, -1);
+        }
+    }
+    return handle;
+}
+
+bool FenceTable::markSignaled(Handle handle, int64_t signalTime) {
+    return queueRetire(handle, signalTime);
+}
+
+size_t FenceTable::reclaim() {
+    bool expected = false;
+    if (!reclaiming_.compare_exchange_strong(expected, true)) {
+        return 0;
+    }
+    
+    size_t freed = 0;
+    uint32_t next = retireHead_.exchange(0);
+    while (next != 0) {
+        uint32_t index = next - 1;
+        FenceSlot& slot = slotRef(index);
+        next = slot.nextFree.load();
+        if (retire(index, slot)) {
+            freed++;
+        } else {
+            pushRetire(index);  // Pinned; next batch
+        }
+    }
+    
+    reclaiming_.store(false);
+    return freed;
+}
+
+bool FenceTable::associate(int clientFd, int64_t eventId, GraphicBuffer* buffer) {
+    FenceSlot* slot = nullptr;
+    if (!lookup(clientFd, eventId, slot)) {
+        return false;
+    }
+    slot->associatedBuffer.store(buffer);
+    unpin(*slot);
+    return true;
+}
+
+FenceTable::Handle FenceTable::find(int fd, int64_t eventId, uint64_t& sequence,
+                                    const char*& name, int64_t& createTime) const {
+    FenceSlot* slot = nullptr;
+    Handle handle = lookup(fd, eventId, slot);
+    if (handle) {
+        sequence = slot->sequence;
+        name = slot->name;
+        createTime = slot->createTime;
+        unpin(*slot);
+    }
+    return handle;
+}
+
+void FenceTable::forEach(const std::function<void(const FenceSlot& slot)>& visitor) const {
+    uint32_t highWater = highWater_.load();
+    for (uint32_t index = 0; index < highWater; ++index) {
+        FenceSlot* slot = slotAt(index);
+        if (slot && pin(*slot)) {
+            visitor(*slot);
+            unpin(*slot);
+        }
+    }
+}
+
+FenceTable::Handle FenceTable::lookup(int fd, int64_t id, FenceSlot*& pinned) const {
+    // The FD number alone is not proof: the client may have closed the
+    // fence and got the number back for another file
+    auto match = [&](std::atomic<Handle>* entry, bool byFd) -> Handle {
+        Handle handle = entry ? entry->load() : 0;
+        FenceSlot* slot = handle ? slotAt(static_cast<uint32_t>(handle)) : nullptr;
+        if (!slot || !pin(*slot)) {
+            return 0;
+        }
+        if (slot->generation == static_cast<uint32_t>(handle >> 32) &&
+            slot->eventId == id && (!byFd || slot->clientFd == fd)) {
+            pinned = slot;
+            return handle;
+        }
+        unpin(*slot);
+        return 0;
+    };
+    
+    // The FD handed out, else a dup of it. Without eventfd IDs only the
+    // FD handed out can be matched.
+    Handle handle = match(indexEntry(fdChunks_, fd, false), true);
+    if (!handle && id >= 0) {
+        handle = match(indexEntry(idChunks_, id, false), false);
+    }
+    return handle;
+}
+
+FenceSlot& FenceTable::slotRef(uint32_t index) const {
+    return chunks_[index >> kChunkShift].load()[index & (kChunkSize - 1)];
+}
+
+FenceSlot* FenceTable::slotAt(uint32_t index) const {
+    if (index >= kMaxSlots) {
+        return nullptr;
+    }
+    FenceSlot* chunk = chunks_[index >> kChunkShift].load();
+    return chunk ? &chunk[index & (kChunkSize - 1)] : nullptr;
+}
+
+std::atomic<FenceTable::Handle>* FenceTable::indexEntry(IndexChunk* chunks, int64_t key,
+                                                       bool create) const {
+    if (key < 0 || key >= static_cast<int64_t>(kIndexChunkSize) * kMaxIndexChunks) {
+        return nullptr;
+    }
+    
+    IndexChunk& chunk = chunks[key >> kIndexChunkShift];
+    std::atomic<Handle>* entries = chunk.load();
+    if (!entries && create) {
+        std::atomic<Handle>* fresh = new std::atomic<Handle>[kIndexChunkSize]();
+        if (chunk.compare_exchange_strong(entries, fresh)) {
+            entries = fresh;
+        } else {
+            delete[] fresh;
+        }
+    }
+    return entries ? &entries[key & (kIndexChunkSize - 1)] : nullptr;
+}
+
+bool FenceTable::popFree(uint32_t& index) {
+    uint64_t head = freeHead_.load();
+    while (static_cast<uint32_t>(head) != 0) {
+        uint32_t top = static_cast<uint32_t>(head) - 1;
+        uint64_t next = slotRef(top).nextFree.load();
+        uint64_t replacement = ((head >> 32) + 1) << 32 | next;
+        if (freeHead_.compare_exchange_weak(head, replacement)) {
+            index = top;
+            return true;
+        }
+    }
+    return false;
+}
+
+void FenceTable::pushFree(uint32_t index) {
+    FenceSlot& slot = slotRef(index);
+    uint64_t head = freeHead_.load();
+    uint64_t replacement;
+    do {
+        slot.nextFree.store(static_cast<uint32_t>(head));
+        replacement = ((head >> 32) + 1) << 32 | (index + 1);
+    } while (!freeHead_.compare_exchange_weak(head, replacement));
+}
+
+bool FenceTable::pin(FenceSlot& slot) const {
+    // Pairs with retire(): either the reader sees the slot leave the
+    // live state or the reclaimer sees the pin
+    slot.pins.fetch_add(1);
+    if (slot.state.load() == kSlotLive) {
+        return true;
+    }
+    slot.pins.fetch_sub(1);
+    return false;
+}
+
+void FenceTable::unpin(FenceSlot& slot) const {
+    slot.pins.fetch_sub(1);
+}
+
+bool FenceTable::queueRetire(Handle handle, int64_t signalTime) {
+    uint32_t index = static_cast<uint32_t>(handle);
+    FenceSlot* slot = slotAt(index);
+    if (!slot || !pin(*slot)) {
+        return false;
+    }
+    bool queued = slot->generation == static_cast<uint32_t>(handle >> 32) &&
+                  !slot->queued.exchange(true);
+    if (queued) {
+        if (signalTime >= 0) {
+            slot->signalTime.store(signalTime);
+        }
+        queuedCount_++;
+        pushRetire(index);  // reclaim() backs off while we hold the pin
+    }
+    unpin(*slot);
+    return queued;
+}
+
+void FenceTable::pushRetire(uint32_t index) {
+    // Pushes only; reclaim() takes the whole list, so there is no ABA
+    FenceSlot& slot = slotRef(index);
+    uint32_t head = retireHead_.load();
+    do {
+        slot.nextFree.store(head);
+    } while (!retireHead_.compare_exchange_weak(head, index + 1));
+}
+
+bool FenceTable::retire(uint32_t index, FenceSlot& slot) {
+    uint32_t expected = kSlotLive;
+    if (!slot.state.compare_exchange_strong(expected, kSlotRetiring)) {
+        return false;
+    }
+    if (slot.pins.load() != 0) {
+        slot.state.store(kSlotLive);  // In use; next batch
+        return false;
+    }
+    
+    // Drop the index entries unless a newer fence took the number or ID
+    Handle handle = static_cast<Handle>(slot.generation) << 32 | index;
+    if (std::atomic<Handle>* entry = indexEntry(fdChunks_, slot.clientFd, false)) {
+        Handle expected = handle;
+        entry->compare_exchange_strong(expected, 0);
+    }
+    if (std::atomic<Handle>* entry = indexEntry(idChunks_, slot.eventId, false)) {
+        entry->compare_exchange_strong(handle, 0);
+    }
+    
+    slot.associatedBuffer.store(nullptr);
+    slot.queued.store(false);
+    if (++slot.generation == 0) {
+        slot.generation = 1;  // Keep handles nonzero
+    }
+    slot.state.store(kSlotFree);
+    queuedCount_--;
+    liveCount_--;
+    pushFree(index);
+    return true;
+}
+
+} // namespace graphics
+} // namespace android
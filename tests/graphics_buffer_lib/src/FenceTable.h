@@ -0,0 +1,199 @@
+/**
+ * @file FenceTable.h
+ * @brief Internal lock-free tracking table for FenceManager
+ * 
+ * Tracked fences live in a slot map: fixed-size chunks of slots that are
+ * allocated on demand and never freed before the table, a Treiber free
+ * list with an ABA tag, and a generation per slot so stale handles are
+ * rejected after a slot is reused. Two chunked arrays map the FD handed
+ * to the client, and the eventfd ID shared by its dups, to the handle of
+ * its slot.
+ * 
+ * The table holds no FD of its own and makes no syscalls; callers pass
+ * the eventfd ID, which Fence caches. Insertion, lookup and retirement
+ * are O(1) and lock-free: a fence is queued for retirement when it is
+ * signaled, or when createFence() hands out its FD number or eventfd ID
+ * again (so the client closed it), and queued slots are freed in
+ * batches by reclaim(), one reclaimer at a time. Readers pin a slot
+ * before touching it; a pinned slot stays queued until the next batch.
+ */
+
+#pragma once
+
+#include "FenceManager.h"
+#include <atomic>
+#include <cstdint>
+#include <functional>
+
+namespace android {
+namespace graphics {
+
+/**
+ * @brief Read a numeric field from /proc/self/fdinfo/<fd>
+ * @return False if the file or field is missing
+ */
+bool readFdInfo(int fd, const char* field, int base, uint64_t& value);
+
+/**
+ * @brief Identity of the eventfd behind fd, shared by all its dups
+ * @return eventfd ID, or -1 for other fence types and older kernels
+ */
+int64_t eventFdId(int fd);
+
+/**
+ * @brief Interned fence names
+ * 
+ * Open-addressed set of strings owned by the table. Interning a name
+ * already present does not allocate; names are never removed.
+ */
+class NameTable {
+public:
+    NameTable() = default;
+    ~NameTable();
+    
+    NameTable(const NameTable&) = delete;
+    NameTable& operator=(const NameTable&) = delete;
+    
+    /**
+     * @brief Get the stable copy of name
+     * @return Interned string, or "fence" for null or once the table is full
+     */
+    const char* intern(const char* name);
+
+private:
+    static constexpr size_t kCapacity = 256;
+    
+    std::atomic<char*> names_[kCapacity] = {};
+};
+
+/**
+ * @brief Tracked fence, as seen by FenceTable::forEach()
+ */
+struct FenceSlot {
+    int clientFd = -1;                              // FD handed out by createFence()
+    const char* name = nullptr;                     // Interned
+    uint64_t sequence = 0;                          // Creation number
+    int64_t createTime = 0;
+    std::atomic<int64_t> signalTime{-1};            // Set by markSignaled()
+    std::atomic<GraphicBuffer*> associatedBuffer{nullptr};
+    int64_t eventId = -1;                           // eventfd ID, -1 if unknown
+    
+    // Table bookkeeping
+    std::atomic<uint32_t> state{0};
+    std::atomic<uint32_t> pins{0};
+    std::atomic<uint32_t> nextFree{0};              // Free or retire list link (index + 1)
+    std::atomic<bool> queued{false};                // On the retire list
+    uint32_t generation = 1;                        // Changes only while unpinned
+};
+
+class FenceTable {
+public:
+    /// generation << 32 | slot index; 0 is never a valid handle
+    using Handle = uint64_t;
+    
+    FenceTable();
+    ~FenceTable();
+    
+    FenceTable(const FenceTable&) = delete;
+    FenceTable& operator=(const FenceTable&) = delete;
+    
+    /**
+     * @brief Track a fence
+     * 
+     * A live fence already indexed under clientFd or eventId is queued
+     * for retirement: its FD was closed, or this number could not have
+     * been handed out again.
+     * 
+     * @param eventId eventfd ID of clientFd (see eventFdId()), or -1
+     * @return Handle, or 0 when every slot is live
+     */
+    Handle insert(int clientFd, int64_t eventId, const char* name, uint64_t sequence,
+                  int64_t createTime);
+    
+    /**
+     * @brief Record the signal time of a fence and queue it for retirement
+     * @return False if handle is stale or the fence was already queued
+     */
+    bool markSignaled(Handle handle, int64_t signalTime);
+    
+    /**
+     * @brief Free the slots queued for retirement
+     * 
+     * Touches only queued slots, never the whole table. Returns
+     * immediately if another thread is already reclaiming.
+     * 
+     * @return Number of slots freed
+     */
+    size_t reclaim();
+    
+    /**
+     * @brief Number of slots waiting for reclaim()
+     */
+    size_t getQueuedCount() const { return queuedCount_.load(); }
+    
+    /**
+     * @brief Set the buffer of the live fence behind clientFd
+     * @return False if clientFd is not a tracked fence
+     */
+    bool associate(int clientFd, int64_t eventId, GraphicBuffer* buffer);
+    
+    /**
+     * @brief Look up the live fence behind fd
+     * 
+     * The FD handed out is found through the FD index, a dup through the
+     * eventfd ID index; either hit must carry the eventfd ID of fd, so a
+     * reused FD number does not match the fence that had it.
+     * 
+     * @param eventId eventfd ID of fd (see eventFdId()), or -1
+     * @return Handle, or 0 if fd is not a tracked fence
+     */
+    Handle find(int fd, int64_t eventId, uint64_t& sequence, const char*& name,
+                int64_t& createTime) const;
+    
+    /**
+     * @brief Visit every live fence while it is pinned
+     */
+    void forEach(const std::function<void(const FenceSlot& slot)>& visitor) const;
+    
+    size_t getLiveCount() const { return liveCount_.load(); }
+
+private:
+    static constexpr uint32_t kChunkShift = 8;
+    static constexpr uint32_t kChunkSize = 1u << kChunkShift;
+    static constexpr uint32_t kMaxChunks = 256;
+    static constexpr uint32_t kMaxSlots = kChunkSize * kMaxChunks;
+    
+    // FD numbers and eventfd IDs are both allocated lowest-free, so both
+    // indexes stay dense
+    static constexpr uint32_t kIndexChunkShift = 10;
+    static constexpr uint32_t kIndexChunkSize = 1u << kIndexChunkShift;
+    static constexpr uint32_t kMaxIndexChunks = 1024;
+    
+    using IndexChunk = std::atomic<std::atomic<Handle>*>;
+    
+    std::atomic<FenceSlot*> chunks_[kMaxChunks] = {};
+    mutable IndexChunk fdChunks_[kMaxIndexChunks] = {};
+    mutable IndexChunk idChunks_[kMaxIndexChunks] = {};
+    
+    std::atomic<uint64_t> freeHead_{0};             // ABA tag << 32 | (index + 1)
+    std::atomic<uint32_t> retireHead_{0};           // index + 1; taken whole by reclaim()
+    std::atomic<size_t> queuedCount_{0};
+    std::atomic<uint32_t> highWater_{0};            // Slots ever handed out
+    std::atomic<size_t> liveCount_{0};
+    std::atomic<bool> reclaiming_{false};
+    
+    Handle lookup(int fd, int64_t eventId, FenceSlot*& pinned) const;
+    FenceSlot& slotRef(uint32_t index) const;       // index already handed out
+    FenceSlot* slotAt(uint32_t index) const;
+    std::atomic<Handle>* indexEntry(IndexChunk* chunks, int64_t key, bool create) const;
+    bool popFree(uint32_t& index);
+    void pushFree(uint32_t index);
+    bool pin(FenceSlot& slot) const;
+    void unpin(FenceSlot& slot) const;
+    bool queueRetire(Handle handle, int64_t signalTime);
+    void pushRetire(uint32_t index);
+    bool retire(uint32_t index, FenceSlot& slot);
+};
+
+} // namespace graphics
+} // namespace android
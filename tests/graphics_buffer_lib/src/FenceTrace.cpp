@@ -0,0 +1,320 @@
+/**
+ * @file FenceTrace.cpp
+ * @brief Implementation of FenceTrace and LatencyHistogram
+ */
+
+#include "FenceTrace.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <deque>
+#include <sstream>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace android {
+namespace graphics {
+
+namespace {
+
+int64_t monotonicNs() {
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<int64_t>(ts.tv_sec) * 1000000000LL + ts.tv_nsec;
+}
+
+uint32_t currentThreadId() {
+    thread_local uint32_t tid = static_cast<uint32_t>(syscall(SYS_gettid));
+    return tid;
+}
+
+size_t bucketFor(int64_t latencyNs) {
+    if (latencyNs <= 1) {
+        return 0;
+    }
+    size_t bucket = 63 - __builtin_clzll(static_cast<uint64_t>(latencyNs));
+    return std::min(bucket, LatencyHistogram::kBuckets - 1);
+}
+
+std::string formatNs(int64_t ns) {
+    char text[32];
+    if (ns < 1000) {
+        std::snprintf(text, sizeof(text), "%lld ns", static_cast<long long>(ns));
+    } else if (ns < 1000000) {
+        std::snprintf(text, sizeof(text), "%.1f us", ns / 1e3);
+    } else {
+        std::snprintf(text, sizeof(text), "%.2f ms", ns / 1e6);
+    }
+    return text;
+}
+
+void appendJsonString(std::string& out, const char* text) {
+    out += '"';
+    for (const char* p = text; *p; ++p) {
+        unsigned char c = static_cast<unsigned char>(*p);
+        if (c == '"' || c == '\\') {
+            out += '\\';
+            out += static_cast<char>(c);
+        } else if (c < 0x20) {
+            char escaped[8];
+            std::snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+            out += escaped;
+        } else {
+            out += static_cast<char>(c);
+        }
+    }
+    out += '"';
+}
+
+/**
+ * Append one Chrome trace event; id may be null for non-async events
+ */
+void appendTraceEvent(std::string& out, const std::string& name, const char* category,
+                      char phase, const char* id, const FenceTraceEvent& event,
+                      const char* argName = nullptr, int64_t argNs = -1) {
+    char buffer[160];
+    out += out.back() == '[' ? "\n" : ",\n";
+    out += "{\"name\":";
+    appendJsonString(out, name.c_str());
+    std::snprintf(buffer, sizeof(buffer),
+                  ",\"cat\":\"%s\",\"ph\":\"%c\",\"ts\":%.3f,\"pid\":%d,\"tid\":%u",
+                  category, phase, event.timeNs / 1e3, static_cast<int>(getpid()),
+                  event.threadId);
+    out += buffer;
+    if (phase == 'i') {
+        out += ",\"s\":\"t\"";
+    }
+    if (id) {
+        out += ",\"id\":\"";
+        out += id;
+        out += '"';
+    }
+    if (argName && argNs >= 0) {
+        std::snprintf(buffer, sizeof(buffer), ",\"args\":{\"%s\":%.3f}", argName, argNs / 1e3);
+        out += buffer;
+    }
+    out += '}';
+}
+
+} // anonymous namespace
+
+// LatencyHistogram implementation
+
+void LatencyHistogram::record(int64_t latencyNs) {
+    latencyNs = std::max<int64_t>(latencyNs, 0);
+    counts_[bucketFor(latencyNs)].fetch_add(1, std::memory_order_relaxed);
+    count_.fetch_add(1, std::memory_order_relaxed);
+    totalNs_.fetch_add(latencyNs, std::memory_order_relaxed);
+    
+    int64_t max = maxNs_.load(std::memory_order_relaxed);
+    while (latencyNs > max &&
+           !maxNs_.compare_exchange_weak(max, latencyNs, std::memory_order_relaxed)) {
+    }
+}
+
+LatencyHistogram::Snapshot LatencyHistogram::snapshot() const {
+    Snapshot snapshot;
+    for (size_t i = 0; i < kBuckets; ++i) {
+        snapshot.counts[i] = counts_[i].load(std::memory_order_relaxed);
+    }
+    snapshot.count = count_.load(std::memory_order_relaxed);
+    snapshot.totalNs = totalNs_.load(std::memory_order_relaxed);
+    snapshot.maxNs = maxNs_.load(std::memory_order_relaxed);
+    return snapshot;
+}
+
+void LatencyHistogram::reset() {
+    for (auto& count : counts_) {
+        count.store(0, std::memory_order_relaxed);
+    }
+    count_.store(0, std::memory_order_relaxed);
+    totalNs_.store(0, std::memory_order_relaxed);
+    maxNs_.store(0, std::memory_order_relaxed);
+}
+
+int64_t LatencyHistogram::Snapshot::getPercentileNs(double percentile) const {
+    uint64_t total = 0;
+    for (uint64_t bucketCount : counts) {
+        total += bucketCount;
+    }
+    if (total == 0) {
+        return 0;
+    }
+    
+    double clamped = std::min(100.0, std::max(0.0, percentile));
+    uint64_t target = std::max<uint64_t>(1, static_cast<uint64_t>(std::ceil(total * clamped / 100.0)));
+    uint64_t seen = 0;
+    for (size_t i = 0; i < kBuckets; ++i) {
+        seen += counts[i];
+        if (seen >= target) {
+            return std::min<int64_t>(int64_t(2) << i, maxNs);
+        }
+    }
+    return maxNs;
+}
+
+std::string LatencyHistogram::Snapshot::toString() const {
+    std::ostringstream ss;
+    ss << "count " << count << ", mean " << formatNs(getMeanNs())
+       << ", p50 " << formatNs(getPercentileNs(50))
+       << ", p99 " << formatNs(getPercentileNs(99))
+       << ", max " << formatNs(maxNs) << "\n";
+    for (size_t i = 0; i < kBuckets; ++i) {
+        if (counts[i] != 0) {
+            int64_t low = i == 0 ? 0 : int64_t(1) << i;
+            ss << "    [" << formatNs(low) << ", " << formatNs(int64_t(2) << i) << "): "
+               << counts[i] << "\n";
+        }
+    }
+    return ss.str();
+}
+
+// FenceTrace implementation
+
+/**
+ * Ring slot published seqlock-style: sequence is 2 * ticket + 1 while
+ * the writer fills it and 2 * ticket + 2 once it is complete. Fields are
+ * relaxed atomics so torn reads are detected, not undefined.
+ */
+struct FenceTrace::Slot {
+    std::atomic<uint64_t> sequence{0};
+    std::atomic<int64_t> timeNs{0};
+    std::atomic<uint64_t> fenceId{0};
+    std::atomic<const char*> name{nullptr};
+    std::atomic<uint64_t> typeAndThread{0};     // type << 32 | thread ID
+    std::atomic<int64_t> latencyNs{-1};
+};
+
+FenceTrace::FenceTrace(size_t capacity) {
+    size_t size = 1;
+    while (size < std::max<size_t>(capacity, 2)) {
+        size <<= 1;
+    }
+    slots_.reset(new Slot[size]);
+    mask_ = size - 1;
+}
+
+FenceTrace::~FenceTrace() = default;
+
+void FenceTrace::record(FenceTraceEventType type, uint64_t fenceId, const char* name,
+                        int64_t latencyNs, int64_t timeNs) {
+    FenceTraceEvent event;
+    event.timeNs = timeNs >= 0 ? timeNs : monotonicNs();
+    event.fenceId = fenceId;
+    event.name = name;
+    event.type = type;
+    event.threadId = currentThreadId();
+    event.latencyNs = latencyNs;
+    record(event);
+}
+
+void FenceTrace::record(const FenceTraceEvent& event) {
+    uint64_t ticket = head_.fetch_add(1, std::memory_order_relaxed);
+    Slot& slot = slots_[ticket & mask_];
+    
+    slot.sequence.store(2 * ticket + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    slot.timeNs.store(event.timeNs, std::memory_order_relaxed);
+    slot.fenceId.store(event.fenceId, std::memory_order_relaxed);
+    slot.name.store(event.name, std::memory_order_relaxed);
+    slot.typeAndThread.store(static_cast<uint64_t>(event.type) << 32 | event.threadId,
+                             std::memory_order_relaxed);
+    slot.latencyNs.store(event.latencyNs, std::memory_order_relaxed);
+    slot.sequence.store(2 * ticket + 2, std::memory_order_release);
+}
+
+std::vector<FenceTraceEvent> FenceTrace::snapshot() const {
+    uint64_t head = head_.load(std::memory_order_acquire);
+    uint64_t capacity = mask_ + 1;
+    uint64_t first = head > capacity ? head - capacity : 0;
+    
+    std::vector<FenceTraceEvent> events;
+    events.reserve(head - first);
+    for (uint64_t ticket = first; ticket < head; ++ticket) {
+        const Slot& slot = slots_[ticket & mask_];
+        uint64_t before = slot.sequence.load(std::memory_order_acquire);
+        if (before != 2 * ticket + 2) {
+            continue;  // Still being written, or already overwritten
+        }
+        
+        FenceTraceEvent event;
+        event.timeNs = slot.timeNs.load(std::memory_order_relaxed);
+        event.fenceId = slot.fenceId.load(std::memory_order_relaxed);
+        event.name = slot.name.load(std::memory_order_relaxed);
+        uint64_t typeAndThread = slot.typeAndThread.load(std::memory_order_relaxed);
+        event.type = static_cast<FenceTraceEventType>(typeAndThread >> 32);
+        event.threadId = static_cast<uint32_t>(typeAndThread);
+        event.latencyNs = slot.latencyNs.load(std::memory_order_relaxed);
+        
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (slot.sequence.load(std::memory_order_relaxed) == before) {
+            events.push_back(event);
+        }
+    }
+    
+    // Tickets are taken before timestamps; order by time for readers
+    std::stable_sort(events.begin(), events.end(),
+        [](const FenceTraceEvent& a, const FenceTraceEvent& b) {
+            return a.timeNs < b.timeNs;
+        });
+    return events;
+}
+
+std::string FenceTrace::exportChromeJson() const {
+    std::vector<FenceTraceEvent> events = snapshot();
+    
+    std::string out = "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+    std::unordered_set<uint64_t> open;                          // Fences with a 'b' emitted
+    std::unordered_map<uint64_t, std::deque<std::string>> waits; // Open wait IDs per fence
+    uint64_t nextWaitId = 0;
+    char id[32];
+    
+    for (const FenceTraceEvent& event : events) {
+        std::string name = event.name ? event.name : "fence";
+        if (event.fenceId != 0) {
+            name += "#" + std::to_string(event.fenceId);
+        }
+        std::snprintf(id, sizeof(id), "f%llu", static_cast<unsigned long long>(event.fenceId));
+        
+        switch (event.type) {
+            case FenceTraceEventType::CREATE:
+                if (event.fenceId != 0) {
+                    appendTraceEvent(out, name, "fence", 'b', id, event);
+                    open.insert(event.fenceId);
+                }
+                break;
+            case FenceTraceEventType::SIGNAL:
+                if (open.erase(event.fenceId)) {
+                    appendTraceEvent(out, name, "fence", 'e', id, event,
+                                     "create_to_signal_us", event.latencyNs);
+                }
+                appendTraceEvent(out, "signal " + name, "fence", 'i', nullptr, event);
+                break;
+            case FenceTraceEventType::WAIT:
+                std::snprintf(id, sizeof(id), "w%llu", static_cast<unsigned long long>(++nextWaitId));
+                waits[event.fenceId].push_back(id);
+                appendTraceEvent(out, "wait " + name, "wait", 'b', id, event);
+                break;
+            case FenceTraceEventType::WAKE: {
+                auto it = waits.find(event.fenceId);
+                if (it != waits.end() && !it->second.empty()) {
+                    appendTraceEvent(out, "wait " + name, "wait", 'e', it->second.front().c_str(),
+                                     event, "signal_to_wake_us", event.latencyNs);
+                    it->second.pop_front();
+                } else {
+                    appendTraceEvent(out, "wake " + name, "wait", 'i', nullptr, event,
+                                     "signal_to_wake_us", event.latencyNs);
+                }
+                break;
+            }
+        }
+    }
+    out += "\n]}\n";
+    return out;
+}
+
+} // namespace graphics
+} // namespace android
@@ -0,0 +1,299 @@
+/**
+ * @file FormatConverter.cpp
+ * @brief Implementation of FormatConverter and its scalar kernels
+ */
+
+#include "FormatConverter.h"
+#include "FormatConverterKernels.h"
+#include "BufferMapper.h"
+#include "FormatTraits.h"
+#include <algorithm>
+#include <cstring>
+
+namespace android {
+namespace graphics {
+
+namespace kernels {
+
+namespace {
+
+inline uint8_t clampToByte(int value) {
+    return static_cast<uint8_t>(std::min(std::max(value, 0), 255));
+}
+
+} // namespace
+
+template <bool CrFirst, bool Bgr>
+void yuvToRgbRowScalar(
+    const YuvToRgbArgs& args,
+    const uint8_t* yRow, const uint8_t* uvRow, uint8_t* dstRow,
+    uint32_t startX
+) {
+    constexpr int cbIndex = CrFirst ? 1 : 0;
+    constexpr int crIndex = CrFirst ? 0 : 1;
+    constexpr int redIndex = Bgr ? 2 : 0;
+    constexpr int blueIndex = Bgr ? 0 : 2;
+    
+    for (uint32_t x = startX; x < args.width; ++x) {
+        const uint8_t* chroma = uvRow + (x / 2) * 2;
+        
+        // BT.601 limited range, 8-bit fixed point
+        int c = 298 * (yRow[x] - 16) + 128;
+        int d = chroma[cbIndex] - 128;
+        int e = chroma[crIndex] - 128;
+        
+        uint8_t* out = dstRow + x * 4;
+        out[redIndex] = clampToByte((c + 409 * e) >> 8);
+        out[1] = clampToByte((c - 100 * d - 208 * e) >> 8);
+        out[blueIndex] = clampToByte((c + 516 * d) >> 8);
+        out[3] = 0xFF;
+    }
+}
+
+template void yuvToRgbRowScalar<false, false>(
+    const YuvToRgbArgs&, const uint8_t*, const uint8_t*, uint8_t*, uint32_t);
+template void yuvToRgbRowScalar<false, true>(
+    const YuvToRgbArgs&, const uint8_t*, const uint8_t*, uint8_t*, uint32_t);
+template void yuvToRgbRowScalar<true, false>(
+    const YuvToRgbArgs&, const uint8_t*, const uint8_t*, uint8_t*, uint32_t);
+template void yuvToRgbRowScalar<true, true>(
+    const YuvToRgbArgs&, const uint8_t*, const uint8_t*, uint8_t*, uint32_t);
+
+namespace {
+
+template <bool CrFirst, bool Bgr>
+void yuvToRgbScalarImpl(const YuvToRgbArgs& args) {
+    for (uint32_t row = 0; row < args.height; ++row) {
+        yuvToRgbRowScalar<CrFirst, Bgr>(args,
+            args.y + static_cast<size_t>(row) * args.yStride,
+            args.uv + static_cast<size_t>(row / 2) * args.uvStride,
+            args.dst + static_cast<size_t>(row) * args.dstStride,
+            0);
+    }
+}
+
+} // namespace
+
+void yuvToRgbScalar(const YuvToRgbArgs& args) {
+    static constexpr YuvToRgbFn kLayouts[2][2] = {
+        {yuvToRgbScalarImpl<false, false>, yuvToRgbScalarImpl<false, true>},
+        {yuvToRgbScalarImpl<true, false>, yuvToRgbScalarImpl<true, true>}
+    };
+    kLayouts[args.crFirst][args.bgr](args);
+}
+
+void deinterleaveScalar(const DeinterleaveArgs& args) {
+    for (uint32_t row = 0; row < args.height; ++row) {
+        const uint8_t* src = args.src + static_cast<size_t>(row) * args.srcStride;
+        uint8_t* first = args.first + static_cast<size_t>(row) * args.firstStride;
+        uint8_t* second = args.second + static_cast<size_t>(row) * args.secondStride;
+        
+        for (uint32_t x = 0; x < args.width; ++x) {
+            first[x] = src[2 * x];
+            second[x] = src[2 * x + 1];
+        }
+    }
+}
+
+void swapRedBlueScalar(const SwizzleArgs& args) {
+    for (uint32_t row = 0; row < args.height; ++row) {
+        const uint8_t* src = args.src + static_cast<size_t>(row) * args.srcStride;
+        uint8_t* dst = args.dst + static_cast<size_t>(row) * args.dstStride;
+        
+        for (uint32_t x = 0; x < args.width; ++x) {
+            uint8_t r = src[4 * x];
+            dst[4 * x] = src[4 * x + 2];
+            dst[4 * x + 1] = src[4 * x + 1];
+            dst[4 * x + 2] = r;
+            dst[4 * x + 3] = src[4 * x + 3];
+        }
+    }
+}
+
+const ConverterKernels& getScalarKernels() {
+    static const ConverterKernels scalar = {
+        yuvToRgbScalar,
+        deinterleaveScalar,
+        swapRedBlueScalar
+    };
+    return scalar;
+}
+
+} // namespace kernels
+
+namespace {
+
+const kernels::ConverterKernels& selectKernels() {
+#if defined(__x86_64__) || defined(__i386__)
+    switch (CpuFeatures::getSimdLevel()) {
+        case SimdLevel::AVX2:
+            return kernels::getAvx2Kernels();
+        case SimdLevel::SSE4_1:
+            return kernels::getSse41Kernels();
+        default:
+            break;
+    }
+#endif
+    return kernels::getScalarKernels();
+}
+
+bool isSemiPlanar(PixelFormat format) {
+    const FormatInfo& info = getFormatInfo(format);
+    return info.yuv && info.planeCount == 2;
+}
+
+bool isRgb32(PixelFormat format) {
+    return format == PixelFormat::RGBA_8888 || format == PixelFormat::RGBX_8888;
+}
+
+// Odd YUV strides leave chroma rows narrower than the plane
+bool fitsStrides(const PlaneLayout* planes, uint32_t count) {
+    for (uint32_t i = 1; i < count; ++i) {
+        if (planes[i].rowStride < static_cast<size_t>(planes[i].width) * planes[i].sampleStride) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Start of the interleaved chroma block of a semi-planar layout
+size_t chromaBlockOffset(const PlaneLayout* planes) {
+    return std::min(planes[1].offset, planes[2].offset);
+}
+
+} // namespace
+
+bool FormatConverter::isSupported(PixelFormat src, PixelFormat dst) {
+    if (src == dst) {
+        return src != PixelFormat::UNKNOWN;
+    }
+    
+    if (isSemiPlanar(src)) {
+        return isRgb32(dst) || dst == PixelFormat::BGRA_8888 ||
+               dst == PixelFormat::YV12;
+    }
+    
+    return (isRgb32(src) && dst == PixelFormat::BGRA_8888) ||
+           (src == PixelFormat::BGRA_8888 && isRgb32(dst));
+}
+
+bool FormatConverter::convert(GraphicBuffer* src, GraphicBuffer* dst) {
+    if (!src || !dst || src == dst) {
+        return false;
+    }
+    
+    if (!isSupported(src->getFormat(), dst->getFormat())) {
+        return false;
+    }
+    
+    BufferLockGuard srcGuard(src, BufferLockGuard::LockMode::Read);
+    BufferLockGuard dstGuard(dst, BufferLockGuard::LockMode::Write);
+    
+    if (!srcGuard || !dstGuard || !srcGuard.getRawData() || !dstGuard.getRawData()) {
+        return false;
+    }
+    
+    return convert(srcGuard.getRawData(), src->getDescriptor(),
+                   dstGuard.getRawData(), dst->getDescriptor());
+}
+
+bool FormatConverter::convert(
+    const void* src,
+    const BufferDescriptor& srcDesc,
+    void* dst,
+    const BufferDescriptor& dstDesc
+) {
+    if (!src || !dst ||
+        srcDesc.width != dstDesc.width || srcDesc.height != dstDesc.height ||
+        !isSupported(srcDesc.format, dstDesc.format)) {
+        return false;
+    }
+    
+    PlaneLayout srcPlanes[BufferMapper::kMaxPlanes];
+    PlaneLayout dstPlanes[BufferMapper::kMaxPlanes];
+    uint32_t srcCount = BufferMapper::getPlaneLayouts(srcDesc, srcPlanes);
+    uint32_t dstCount = BufferMapper::getPlaneLayouts(dstDesc, dstPlanes);
+    if (srcCount == 0 || dstCount == 0 ||
+        !fitsStrides(srcPlanes, srcCount) || !fitsStrides(dstPlanes, dstCount)) {
+        return false;
+    }
+    
+    const uint8_t* in = static_cast<const uint8_t*>(src);
+    uint8_t* out = static_cast<uint8_t*>(dst);
+    const kernels::ConverterKernels& k = selectKernels();
+    
+    // Same format: stride-aware copy of each distinct plane
+    if (srcDesc.format == dstDesc.format) {
+        if (isSemiPlanar(srcDesc.format)) {
+            BufferMapper::copyRows(in, srcPlanes[0].rowStride, out, dstPlanes[0].rowStride,
+                                   srcPlanes[0].width, srcPlanes[0].height);
+            BufferMapper::copyRows(in + chromaBlockOffset(srcPlanes), srcPlanes[1].rowStride,
+                                   out + chromaBlockOffset(dstPlanes), dstPlanes[1].rowStride,
+                                   static_cast<size_t>(srcPlanes[1].width) * 2, srcPlanes[1].height);
+            return true;
+        }
+        
+        for (uint32_t i = 0; i < srcCount; ++i) {
+            size_t rowBytes = srcCount == 1
+                ? BufferMapper::getRowBytes(srcDesc.format, srcDesc.width)
+                : static_cast<size_t>(srcPlanes[i].width) * srcPlanes[i].sampleStride;
+            BufferMapper::copyRows(in + srcPlanes[i].offset, srcPlanes[i].rowStride,
+                                   out + dstPlanes[i].offset, dstPlanes[i].rowStride,
+                                   rowBytes, srcPlanes[i].height);
+        }
+        return true;
+    }
+    
+    // NV21/NV12 -> 32-bit RGB
+    if (isSemiPlanar(srcDesc.format) && dstCount == 1) {
+        kernels::YuvToRgbArgs args;
+        args.y = in + srcPlanes[0].offset;
+        args.yStride = srcPlanes[0].rowStride;
+        args.uv = in + chromaBlockOffset(srcPlanes);
+        args.uvStride = srcPlanes[1].rowStride;
+        args.crFirst = getFormatInfo(srcDesc.format).crFirst;
+        args.dst = out + dstPlanes[0].offset;
+        args.dstStride = dstPlanes[0].rowStride;
+        args.bgr = getFormatInfo(dstDesc.format).blueFirst;
+        args.width = srcDesc.width;
+        args.height = srcDesc.height;
+        k.yuvToRgb(args);
+        return true;
+    }
+    
+    // NV21/NV12 -> YV12
+    if (isSemiPlanar(srcDesc.format) && dstDesc.format == PixelFormat::YV12) {
+        BufferMapper::copyRows(in, srcPlanes[0].rowStride, out, dstPlanes[0].rowStride,
+                               srcPlanes[0].width, srcPlanes[0].height);
+        
+        bool crFirst = getFormatInfo(srcDesc.format).crFirst;
+        const PlaneLayout& firstPlane = dstPlanes[crFirst ? 2 : 1];
+        const PlaneLayout& secondPlane = dstPlanes[crFirst ? 1 : 2];
+        
+        kernels::DeinterleaveArgs args;
+        args.src = in + chromaBlockOffset(srcPlanes);
+        args.srcStride = srcPlanes[1].rowStride;
+        args.first = out + firstPlane.offset;
+        args.firstStride = firstPlane.rowStride;
+        args.second = out + secondPlane.offset;
+        args.secondStride = secondPlane.rowStride;
+        args.width = srcPlanes[1].width;
+        args.height = srcPlanes[1].height;
+        k.deinterleave(args);
+        return true;
+    }
+    
+    // RGBA/RGBX <-> BGRA
+    kernels::SwizzleArgs args;
+    args.src = in + srcPlanes[0].offset;
+    args.srcStride = srcPlanes[0].rowStride;
+    args.dst = out + dstPlanes[0].offset;
+    args.dstStride = dstPlanes[0].rowStride;
+    args.width = srcDesc.width;
+    args.height = srcDesc.height;
+    k.swapRedBlue(args);
+    return true;
+}
+
+} // namespace graphics
+} // namespace android
@@ -0,0 +1,91 @@
+/**
+ * @file FormatConverterKernels.h
+ * @brief Internal kernel tables for FormatConverter
+ * 
+ * Each SIMD level provides the same set of row-loop kernels. Kernels
+ * handle any width; SIMD variants finish ragged tails in scalar code.
+ */
+
+#pragma once
+
+#include <cstdint>
+
+namespace android {
+namespace graphics {
+namespace kernels {
+
+/**
+ * @brief Semi-planar YUV 4:2:0 to 32-bit RGB arguments
+ */
+struct YuvToRgbArgs {
+    const uint8_t* y = nullptr;
+    uint32_t yStride = 0;
+    const uint8_t* uv = nullptr;    ///< Interleaved chroma plane
+    uint32_t uvStride = 0;
+    bool crFirst = false;           ///< NV21 (CrCb) vs NV12 (CbCr)
+    uint8_t* dst = nullptr;
+    uint32_t dstStride = 0;
+    bool bgr = false;               ///< Write BGRA instead of RGBA
+    uint32_t width = 0;
+    uint32_t height = 0;
+};
+
+/**
+ * @brief Interleaved chroma to two planar chroma planes arguments
+ */
+struct DeinterleaveArgs {
+    const uint8_t* src = nullptr;
+    uint32_t srcStride = 0;
+    uint8_t* first = nullptr;       ///< Receives even bytes
+    uint32_t firstStride = 0;
+    uint8_t* second = nullptr;      ///< Receives odd bytes
+    uint32_t secondStride = 0;
+    uint32_t width = 0;             ///< Byte pairs per row
+    uint32_t height = 0;
+};
+
+/**
+ * @brief 32-bit pixel red/blue swap arguments
+ */
+struct SwizzleArgs {
+    const uint8_t* src = nullptr;
+    uint32_t srcStride = 0;
+    uint8_t* dst = nullptr;
+    uint32_t dstStride = 0;
+    uint32_t width = 0;
+    uint32_t height = 0;
+};
+
+using YuvToRgbFn = void (*)(const YuvToRgbArgs&);
+using DeinterleaveFn = void (*)(const DeinterleaveArgs&);
+using SwizzleFn = void (*)(const SwizzleArgs&);
+
+struct ConverterKernels {
+    YuvToRgbFn yuvToRgb;
+    DeinterleaveFn deinterleave;
+    SwizzleFn swapRedBlue;
+};
+
+// Scalar reference kernels (also used for SIMD tails)
+void yuvToRgbScalar(const YuvToRgbArgs& args);
+
+/// Convert one row from startX; instantiated for all four layouts
+template <bool CrFirst, bool Bgr>
+void yuvToRgbRowScalar(
+    const YuvToRgbArgs& args,
+    const uint8_t* yRow, const uint8_t* uvRow, uint8_t* dstRow,
+    uint32_t startX
+);
+void deinterleaveScalar(const DeinterleaveArgs& args);
+void swapRedBlueScalar(const SwizzleArgs& args);
+
+const ConverterKernels& getScalarKernels();
+
+#if defined(__x86_64__) || defined(__i386__)
+const ConverterKernels& getSse41Kernels();
+const ConverterKernels& getAvx2Kernels();
+#endif
+
+} // namespace kernels
+} // namespace graphics
+} // namespace android
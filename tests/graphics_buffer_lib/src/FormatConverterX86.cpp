@@ -0,0 +1,308 @@
+/**
+ * @file FormatConverterX86.cpp
+ * @brief SSE4.1 and AVX2 kernels for FormatConverter
+ * 
+ * Kernels are compiled with per-function target attributes so the rest
+ * of the library keeps the baseline ISA; they are only reached after
+ * CpuFeatures has confirmed support.
+ */
+
+#if defined(__x86_64__) || defined(__i386__)
+
+#include "FormatConverterKernels.h"
+#include <immintrin.h>
+#include <cstring>
+
+namespace android {
+namespace graphics {
+namespace kernels {
+
+namespace {
+
+inline int32_t loadU32(const uint8_t* p) {
+    int32_t value;
+    std::memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+// ============================================================================
+// SSE4.1
+// ============================================================================
+
+template <bool CrFirst, bool Bgr>
+__attribute__((target("sse4.1")))
+void yuvToRgbSse41Impl(const YuvToRgbArgs& args) {
+    const __m128i lumaOffset = _mm_set1_epi32(16);
+    const __m128i chromaOffset = _mm_set1_epi32(128);
+    const __m128i rounding = _mm_set1_epi32(128);
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i maxValue = _mm_set1_epi32(255);
+    const __m128i alpha = _mm_set1_epi32(static_cast<int32_t>(0xFF000000u));
+    const uint32_t vectorWidth = args.width & ~3u;
+    
+    for (uint32_t row = 0; row < args.height; ++row) {
+        const uint8_t* yRow = args.y + static_cast<size_t>(row) * args.yStride;
+        const uint8_t* uvRow = args.uv + static_cast<size_t>(row / 2) * args.uvStride;
+        uint8_t* dstRow = args.dst + static_cast<size_t>(row) * args.dstStride;
+        
+        for (uint32_t x = 0; x < vectorWidth; x += 4) {
+            __m128i y = _mm_cvtepu8_epi32(_mm_cvtsi32_si128(loadU32(yRow + x)));
+            __m128i uv = _mm_cvtepu8_epi32(_mm_cvtsi32_si128(loadU32(uvRow + x)));
+            
+            // Duplicate each chroma sample across its two pixels
+            __m128i evenChroma = _mm_shuffle_epi32(uv, _MM_SHUFFLE(2, 2, 0, 0));
+            __m128i oddChroma = _mm_shuffle_epi32(uv, _MM_SHUFFLE(3, 3, 1, 1));
+            __m128i cb = CrFirst ? oddChroma : evenChroma;
+            __m128i cr = CrFirst ? evenChroma : oddChroma;
+            
+            __m128i c = _mm_add_epi32(
+                _mm_mullo_epi32(_mm_sub_epi32(y, lumaOffset), _mm_set1_epi32(298)),
+                rounding);
+            __m128i d = _mm_sub_epi32(cb, chromaOffset);
+            __m128i e = _mm_sub_epi32(cr, chromaOffset);
+            
+            __m128i r = _mm_srai_epi32(
+                _mm_add_epi32(c, _mm_mullo_epi32(e, _mm_set1_epi32(409))), 8);
+            __m128i g = _mm_srai_epi32(
+                _mm_sub_epi32(_mm_sub_epi32(c, _mm_mullo_epi32(d, _mm_set1_epi32(100))),
+                              _mm_mullo_epi32(e, _mm_set1_epi32(208))), 8);
+            __m128i b = _mm_srai_epi32(
+                _mm_add_epi32(c, _mm_mullo_epi32(d, _mm_set1_epi32(516))), 8);
+            
+            r = _mm_min_epi32(_mm_max_epi32(r, zero), maxValue);
+            g = _mm_min_epi32(_mm_max_epi32(g, zero), maxValue);
+            b = _mm_min_epi32(_mm_max_epi32(b, zero), maxValue);
+            if constexpr (Bgr) {
+                __m128i t = r;
+                r = b;
+                b = t;
+            }
+            
+            __m128i pixels = _mm_or_si128(
+                _mm_or_si128(r, _mm_slli_epi32(g, 8)),
+                _mm_or_si128(_mm_slli_epi32(b, 16), alpha));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dstRow + x * 4), pixels);
+        }
+        
+        yuvToRgbRowScalar<CrFirst, Bgr>(args, yRow, uvRow, dstRow, vectorWidth);
+    }
+}
+
+void yuvToRgbSse41(const YuvToRgbArgs& args) {
+    static constexpr YuvToRgbFn kLayouts[2][2] = {
+        {yuvToRgbSse41Impl<false, false>, yuvToRgbSse41Impl<false, true>},
+        {yuvToRgbSse41Impl<true, false>, yuvToRgbSse41Impl<true, true>}
+    };
+    kLayouts[args.crFirst][args.bgr](args);
+}
+
+__attribute__((target("sse4.1")))
+void deinterleaveSse41(const DeinterleaveArgs& args) {
+    const __m128i split = _mm_setr_epi8(
+        0, 2, 4, 6, 8, 10, 12, 14, 1, 3, 5, 7, 9, 11, 13, 15);
+    const uint32_t vectorWidth = args.width & ~7u;
+    
+    for (uint32_t row = 0; row < args.height; ++row) {
+        const uint8_t* src = args.src + static_cast<size_t>(row) * args.srcStride;
+        uint8_t* first = args.first + static_cast<size_t>(row) * args.firstStride;
+        uint8_t* second = args.second + static_cast<size_t>(row) * args.secondStride;
+        
+        uint32_t x = 0;
+        for (; x < vectorWidth; x += 8) {
+            __m128i pairs = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 2 * x));
+            __m128i planar = _mm_shuffle_epi8(pairs, split);
+            _mm_storel_epi64(reinterpret_cast<__m128i*>(first + x), planar);
+            _mm_storel_epi64(reinterpret_cast<__m128i*>(second + x),
+                             _mm_srli_si128(planar, 8));
+        }
+        for (; x < args.width; ++x) {
+            first[x] = src[2 * x];
+            second[x] = src[2 * x + 1];
+        }
+    }
+}
+
+__attribute__((target("sse4.1")))
+void swapRedBlueSse41(const SwizzleArgs& args) {
+    const __m128i swap = _mm_setr_epi8(
+        2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15);
+    const uint32_t vectorWidth = args.width & ~3u;
+    
+    for (uint32_t row = 0; row < args.height; ++row) {
+        const uint8_t* src = args.src + static_cast<size_t>(row) * args.srcStride;
+        uint8_t* dst = args.dst + static_cast<size_t>(row) * args.dstStride;
+        
+        uint32_t x = 0;
+        for (; x < vectorWidth; x += 4) {
+            __m128i pixels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 4 * x));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + 4 * x),
+                             _mm_shuffle_epi8(pixels, swap));
+        }
+        for (; x < args.width; ++x) {
+            uint8_t r = src[4 * x];
+            dst[4 * x] = src[4 * x + 2];
+            dst[4 * x + 1] = src[4 * x + 1];
+            dst[4 * x + 2] = r;
+            dst[4 * x + 3] = src[4 * x + 3];
+        }
+    }
+}
+
+// ============================================================================
+// AVX2
+// ============================================================================
+
+template <bool CrFirst, bool Bgr>
+__attribute__((target("avx2")))
+void yuvToRgbAvx2Impl(const YuvToRgbArgs& args) {
+    const __m256i lumaOffset = _mm256_set1_epi32(16);
+    const __m256i chromaOffset = _mm256_set1_epi32(128);
+    const __m256i rounding = _mm256_set1_epi32(128);
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i maxValue = _mm256_set1_epi32(255);
+    const __m256i alpha = _mm256_set1_epi32(static_cast<int32_t>(0xFF000000u));
+    const __m256i evenIndex = _mm256_setr_epi32(0, 0, 2, 2, 4, 4, 6, 6);
+    const __m256i oddIndex = _mm256_setr_epi32(1, 1, 3, 3, 5, 5, 7, 7);
+    const uint32_t vectorWidth = args.width & ~7u;
+    
+    for (uint32_t row = 0; row < args.height; ++row) {
+        const uint8_t* yRow = args.y + static_cast<size_t>(row) * args.yStride;
+        const uint8_t* uvRow = args.uv + static_cast<size_t>(row / 2) * args.uvStride;
+        uint8_t* dstRow = args.dst + static_cast<size_t>(row) * args.dstStride;
+        
+        for (uint32_t x = 0; x < vectorWidth; x += 8) {
+            __m256i y = _mm256_cvtepu8_epi32(
+                _mm_loadl_epi64(reinterpret_cast<const __m128i*>(yRow + x)));
+            __m256i uv = _mm256_cvtepu8_epi32(
+                _mm_loadl_epi64(reinterpret_cast<const __m128i*>(uvRow + x)));
+            
+            // Duplicate each chroma sample across its two pixels
+            __m256i evenChroma = _mm256_permutevar8x32_epi32(uv, evenIndex);
+            __m256i oddChroma = _mm256_permutevar8x32_epi32(uv, oddIndex);
+            __m256i cb = CrFirst ? oddChroma : evenChroma;
+            __m256i cr = CrFirst ? evenChroma : oddChroma;
+            
+            __m256i c = _mm256_add_epi32(
+                _mm256_mullo_epi32(_mm256_sub_epi32(y, lumaOffset), _mm256_set1_epi32(298)),
+                rounding);
+            __m256i d = _mm256_sub_epi32(cb, chromaOffset);
+            __m256i e = _mm256_sub_epi32(cr, chromaOffset);
+            
+            __m256i r = _mm256_srai_epi32(
+                _mm256_add_epi32(c, _mm256_mullo_epi32(e, _mm256_set1_epi32(409))), 8);
+            __m256i g = _mm256_srai_epi32(
+                _mm256_sub_epi32(
+                    _mm256_sub_epi32(c, _mm256_mullo_epi32(d, _mm256_set1_epi32(100))),
+                    _mm256_mullo_epi32(e, _mm256_set1_epi32(208))), 8);
+            __m256i b = _mm256_srai_epi32(
+                _mm256_add_epi32(c, _mm256_mullo_epi32(d, _mm256_set1_epi32(516))), 8);
+            
+            r = _mm256_min_epi32(_mm256_max_epi32(r, zero), maxValue);
+            g = _mm256_min_epi32(_mm256_max_epi32(g, zero), maxValue);
+            b = _mm256_min_epi32(_mm256_max_epi32(b, zero), maxValue);
+            if constexpr (Bgr) {
+                __m256i t = r;
+                r = b;
+                b = t;
+            }
+            
+            __m256i pixels = _mm256_or_si256(
+                _mm256_or_si256(r, _mm256_slli_epi32(g, 8)),
+                _mm256_or_si256(_mm256_slli_epi32(b, 16), alpha));
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(dstRow + x * 4), pixels);
+        }
+        
+        yuvToRgbRowScalar<CrFirst, Bgr>(args, yRow, uvRow, dstRow, vectorWidth);
+    }
+}
+
+void yuvToRgbAvx2(const YuvToRgbArgs& args) {
+    static constexpr YuvToRgbFn kLayouts[2][2] = {
+        {yuvToRgbAvx2Impl<false, false>, yuvToRgbAvx2Impl<false, true>},
+        {yuvToRgbAvx2Impl<true, false>, yuvToRgbAvx2Impl<true, true>}
+    };
+    kLayouts[args.crFirst][args.bgr](args);
+}
+
+__attribute__((target("avx2")))
+void deinterleaveAvx2(const DeinterleaveArgs& args) {
+    const __m256i split = _mm256_setr_epi8(
+        0, 2, 4, 6, 8, 10, 12, 14, 1, 3, 5, 7, 9, 11, 13, 15,
+        0, 2, 4, 6, 8, 10, 12, 14, 1, 3, 5, 7, 9, 11, 13, 15);
+    const uint32_t vectorWidth = args.width & ~15u;
+    
+    for (uint32_t row = 0; row < args.height; ++row) {
+        const uint8_t* src = args.src + static_cast<size_t>(row) * args.srcStride;
+        uint8_t* first = args.first + static_cast<size_t>(row) * args.firstStride;
+        uint8_t* second = args.second + static_cast<size_t>(row) * args.secondStride;
+        
+        uint32_t x = 0;
+        for (; x < vectorWidth; x += 16) {
+            __m256i pairs = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + 2 * x));
+            // Per-lane split, then gather even halves low and odd halves high
+            __m256i planar = _mm256_permute4x64_epi64(
+                _mm256_shuffle_epi8(pairs, split), _MM_SHUFFLE(3, 1, 2, 0));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(first + x),
+                             _mm256_castsi256_si128(planar));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(second + x),
+                             _mm256_extracti128_si256(planar, 1));
+        }
+        for (; x < args.width; ++x) {
+            first[x] = src[2 * x];
+            second[x] = src[2 * x + 1];
+        }
+    }
+}
+
+__attribute__((target("avx2")))
+void swapRedBlueAvx2(const SwizzleArgs& args) {
+    const __m256i swap = _mm256_setr_epi8(
+        2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15,
+        2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15);
+    const uint32_t vectorWidth = args.width & ~7u;
+    
+    for (uint32_t row = 0; row < args.height; ++row) {
+        const uint8_t* src = args.src + static_cast<size_t>(row) * args.srcStride;
+        uint8_t* dst = args.dst + static_cast<size_t>(row) * args.dstStride;
+        
+        uint32_t x = 0;
+        for (; x < vectorWidth; x += 8) {
+            __m256i pixels = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + 4 * x));
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + 4 * x),
+                                _mm256_shuffle_epi8(pixels, swap));
+        }
+        for (; x < args.width; ++x) {
+            uint8_t r = src[4 * x];
+            dst[4 * x] = src[4 * x + 2];
+            dst[4 * x + 1] = src[4 * x + 1];
+            dst[4 * x + 2] = r;
+            dst[4 * x + 3] = src[4 * x + 3];
+        }
+    }
+}
+
+} // namespace
+
+const ConverterKernels& getSse41Kernels() {
+    static const ConverterKernels sse41 = {
+        yuvToRgbSse41,
+        deinterleaveSse41,
+        swapRedBlueSse41
+    };
+    return sse41;
+}
+
+const ConverterKernels& getAvx2Kernels() {
+    static const ConverterKernels avx2 = {
+        yuvToRgbAvx2,
+        deinterleaveAvx2,
+        swapRedBlueAvx2
+    };
+    return avx2;
+}
+
+} // namespace kernels
+} // namespace graphics
+} // namespace android
+
+#endif // __x86_64__ || __i386__
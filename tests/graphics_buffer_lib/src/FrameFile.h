@@ -0,0 +1,71 @@
+/**
+ * @file FrameFile.h
+ * @brief On-disk layout shared by FrameRecorder and FrameReplaySource
+ * 
+ * A recording is one kIoAlignment-byte file header followed by
+ * fixed-size frame records, so frame i lives at
+ * headerBytes + i * recordBytes and every write is block aligned:
+ * 
+ *   [FileHeader | pad][RecordHeader | payload | pad][RecordHeader | ...
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace android {
+namespace graphics {
+namespace framefile {
+
+constexpr uint32_t kFileMagic = 0x52464247;     // "GBFR"
+constexpr uint32_t kRecordMagic = 0x46464247;   // "GBFF"
+constexpr uint32_t kVersion = 1;
+
+/// Alignment of records, buffers and offsets for O_DIRECT
+constexpr size_t kIoAlignment = 4096;
+
+/// Bytes reserved in front of each payload
+constexpr size_t kRecordHeaderBytes = 64;
+
+enum RecordFlags : uint32_t {
+    RECORD_HAS_CRC = 1u << 0,
+};
+
+struct FileHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t headerBytes;       ///< Offset of the first record
+    uint32_t recordBytes;       ///< Size of every record
+    uint32_t width;
+    uint32_t height;
+    uint32_t stride;
+    uint32_t format;
+    uint32_t layerCount;
+    uint32_t reserved;
+    uint64_t usage;
+    uint64_t frameBytes;        ///< Payload bytes per record
+    uint64_t frameCount;        ///< 0 if the recording was not closed
+};
+
+struct RecordHeader {
+    uint32_t magic;
+    uint32_t flags;
+    uint64_t index;
+    int64_t timestampNs;
+    uint64_t payloadBytes;
+    uint32_t crc;               ///< CRC32C of the payload (RECORD_HAS_CRC)
+    uint32_t reserved;
+};
+
+static_assert(sizeof(FileHeader) <= kIoAlignment, "file header fits its block");
+static_assert(sizeof(RecordHeader) <= kRecordHeaderBytes, "record header fits its slot");
+
+/// Bytes of one record holding a payload of frameBytes
+constexpr size_t recordBytes(size_t frameBytes) {
+    return (kRecordHeaderBytes + frameBytes + kIoAlignment - 1) / kIoAlignment * kIoAlignment;
+}
+
+} // namespace framefile
+} // namespace graphics
+} // namespace android
@@ -0,0 +1,260 @@
+/**
+ * @file FrameRecorder.cpp
+ * @brief Implementation of FrameRecorder class
+ */
+
+#include "FrameRecorder.h"
+#include "AsyncFileWriter.h"
+#include "BufferMapper.h"
+#include "FrameFile.h"
+#include <cerrno>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace android {
+namespace graphics {
+
+namespace {
+
+bool sameLayout(const BufferDescriptor& a, const BufferDescriptor& b) {
+    return a.width == b.width && a.height == b.height && a.stride == b.stride &&
+           a.format == b.format && a.layerCount == b.layerCount;
+}
+
+int64_t nowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+} // anonymous namespace
+
+FrameRecorder::FrameRecorder(const FrameRecorderConfig& config)
+    : config_(config)
+{
+    if (config_.ringDepth == 0) {
+        config_.ringDepth = 1;
+    }
+}
+
+FrameRecorder::~FrameRecorder() {
+    close();
+}
+
+bool FrameRecorder::open(const std::string& path, const BufferDescriptor& descriptor) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    
+    if (fd_ >= 0 || !descriptor.isValid() || descriptor.stride == 0) {
+        return false;
+    }
+    
+    int flags = O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC;
+    bool direct = false;
+#ifdef O_DIRECT
+    if (config_.directIo) {
+        fd_ = ::open(path.c_str(), flags | O_DIRECT, 0644);
+        direct = fd_ >= 0;
+    }
+#endif
+    if (fd_ < 0) {
+        // tmpfs and some FUSE filesystems refuse O_DIRECT
+        fd_ = ::open(path.c_str(), flags, 0644);
+    }
+    if (fd_ < 0) {
+        return false;
+    }
+    
+    descriptor_ = descriptor;
+    frameBytes_ = descriptor.calculateSize();
+    recordBytes_ = framefile::recordBytes(frameBytes_);
+    frameCount_ = 0;
+    failed_ = false;
+    stats_ = FrameRecorderStatistics();
+    stats_.directIo = direct;
+    
+    // Slot 0 of the ring doubles as the staging block for the file header
+    for (uint32_t i = 0; i < config_.ringDepth; ++i) {
+        void* slot = nullptr;
+        if (posix_memalign(&slot, framefile::kIoAlignment, recordBytes_) != 0) {
+            releaseLocked();
+            return false;
+        }
+        std::memset(slot, 0, recordBytes_);
+        slots_.push_back(static_cast<uint8_t*>(slot));
+        freeSlots_.push_back(config_.ringDepth - 1 - i);
+    }
+    
+    // A header with frameCount 0 keeps an interrupted recording readable
+    if (!writeHeaderLocked()) {
+        releaseLocked();
+        return false;
+    }
+    
+    writer_ = AsyncFileWriter::create(fd_, config_.ringDepth, config_.useIoUring);
+    if (!writer_) {
+        releaseLocked();
+        return false;
+    }
+    stats_.backend = writer_->getName();
+    return true;
+}
+
+bool FrameRecorder::recordFrame(GraphicBuffer* buffer, int64_t timestampNs) {
+    if (!buffer) return false;
+    if (timestampNs < 0) {
+        timestampNs = nowNs();
+    }
+    
+    std::lock_guard<std::mutex> lock(mutex_);
+    
+    if (!writer_ || failed_ || !sameLayout(buffer->getDescriptor(), descriptor_)) {
+        return false;
+    }
+    
+    reapLocked(false);
+    if (freeSlots_.empty()) {
+        if (config_.dropWhenFull) {
+            stats_.framesDropped++;
+            return false;
+        }
+        stats_.ringStalls++;
+        while (freeSlots_.empty() && !failed_) {
+            reapLocked(true);
+        }
+        if (failed_) {
+            return false;
+        }
+    }
+    
+    uint32_t slot = freeSlots_.back();
+    uint8_t* record = slots_[slot];
+    uint8_t* payload = record + framefile::kRecordHeaderBytes;
+    
+    {
+        BufferLockGuard guard(buffer, BufferLockGuard::LockMode::Read);
+        if (!guard || !guard.getRawData() || guard.getSize() < frameBytes_) {
+            return false;
+        }
+        std::memcpy(payload, guard.getRawData(), frameBytes_);
+    }
+    
+    framefile::RecordHeader header;
+    std::memset(&header, 0, sizeof(header));
+    header.magic = framefile::kRecordMagic;
+    header.index = frameCount_;
+    header.timestampNs = timestampNs;
+    header.payloadBytes = frameBytes_;
+    if (config_.checksum) {
+        header.flags |= framefile::RECORD_HAS_CRC;
+        header.crc = BufferMapper::crc32c(payload, frameBytes_);
+    }
+    std::memcpy(record, &header, sizeof(header));
+    
+    uint64_t offset = framefile::kIoAlignment + frameCount_ * recordBytes_;
+    if (!writer_->submit(slot, record, recordBytes_, offset)) {
+        return false;
+    }
+    freeSlots_.pop_back();
+    frameCount_++;
+    
+    uint32_t inFlight = config_.ringDepth - static_cast<uint32_t>(freeSlots_.size());
+    if (inFlight > stats_.maxInFlight) {
+        stats_.maxInFlight = inFlight;
+    }
+    return true;
+}
+
+bool FrameRecorder::close() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    
+    if (fd_ < 0) {
+        return false;
+    }
+    
+    while (writer_ && writer_->getInFlight() > 0 && !failed_) {
+        reapLocked(true);
+    }
+    // Join the writer before reusing slot 0 for the header
+    writer_.reset();
+    
+    bool ok = !failed_ && stats_.writeErrors == 0 && writeHeaderLocked() && fdatasync(fd_) == 0;
+    releaseLocked();
+    return ok;
+}
+
+bool FrameRecorder::isOpen() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return fd_ >= 0;
+}
+
+uint64_t FrameRecorder::getFrameCount() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return frameCount_;
+}
+
+FrameRecorderStatistics FrameRecorder::getStatistics() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_;
+}
+
+void FrameRecorder::reapLocked(bool wait) {
+    uint32_t reaped = writer_->reap(wait, [this](uint32_t slot, int64_t result) {
+        if (result == static_cast<int64_t>(recordBytes_)) {
+            stats_.framesRecorded++;
+            stats_.bytesWritten += recordBytes_;
+        } else {
+            stats_.writeErrors++;
+        }
+        freeSlots_.push_back(slot);
+    });
+    
+    if (wait && reaped == 0 && writer_->getInFlight() > 0) {
+        // The backend can no longer make progress; stop accepting frames
+        failed_ = true;
+    }
+}
+
+bool FrameRecorder::writeHeaderLocked() {
+    uint8_t* block = slots_[0];
+    std::memset(block, 0, framefile::kIoAlignment);
+    
+    framefile::FileHeader header;
+    std::memset(&header, 0, sizeof(header));
+    header.magic = framefile::kFileMagic;
+    header.version = framefile::kVersion;
+    header.headerBytes = static_cast<uint32_t>(framefile::kIoAlignment);
+    header.recordBytes = static_cast<uint32_t>(recordBytes_);
+    header.width = descriptor_.width;
+    header.height = descriptor_.height;
+    header.stride = descriptor_.stride;
+    header.format = static_cast<uint32_t>(descriptor_.format);
+    header.layerCount = descriptor_.layerCount;
+    header.usage = static_cast<uint64_t>(descriptor_.usage);
+    header.frameBytes = frameBytes_;
+    header.frameCount = frameCount_;
+    std::memcpy(block, &header, sizeof(header));
+    
+    ssize_t written;
+    do {
+        written = pwrite(fd_, block, framefile::kIoAlignment, 0);
+    } while (written < 0 && errno == EINTR);
+    return written == static_cast<ssize_t>(framefile::kIoAlignment);
+}
+
+void FrameRecorder::releaseLocked() {
+    writer_.reset();
+    for (uint8_t* slot : slots_) {
+        std::free(slot);
+    }
+    slots_.clear();
+    freeSlots_.clear();
+    if (fd_ >= 0) {
+        ::close(fd_);
+        fd_ = -1;
+    }
+}
+
+} // namespace graphics
+} // namespace android
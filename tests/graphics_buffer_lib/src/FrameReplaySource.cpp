@@ -0,0 +1,313 @@
+/**
+ * @file FrameReplaySource.cpp
+ * @brief Implementation of FrameReplaySource class
+ */
+
+#include "FrameRecorder.h"
+#include "BufferMapper.h"
+#include "BufferPool.h"
+#include "FrameFile.h"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace android {
+namespace graphics {
+
+namespace {
+
+// Frames ready later than this after their due time count as late
+constexpr int64_t kLateToleranceNs = 1000000;
+
+bool sameImage(const BufferDescriptor& a, const BufferDescriptor& b) {
+    return a.width == b.width && a.height == b.height && a.format == b.format &&
+           a.layerCount == b.layerCount;
+}
+
+bool readFully(int fd, void* dest, size_t size, uint64_t offset) {
+    uint8_t* bytes = static_cast<uint8_t*>(dest);
+    size_t done = 0;
+    while (done < size) {
+        ssize_t ret = pread(fd, bytes + done, size - done, static_cast<off_t>(offset + done));
+        if (ret < 0 && errno == EINTR) {
+            continue;
+        }
+        if (ret <= 0) {
+            return false;
+        }
+        done += static_cast<size_t>(ret);
+    }
+    return true;
+}
+
+// Copy every plane row by row between images that differ only in stride
+void copyPlanes(const ConstImageView& src, const ImageView& dst) {
+    const FormatInfo& info = getFormatInfo(src.getFormat());
+    uint32_t count = std::min(src.getPlaneCount(), dst.getPlaneCount());
+    for (uint32_t i = 0; i < count; ++i) {
+        const PlaneView<const uint8_t>& from = src.plane(i);
+        const PlaneView<uint8_t>& to = dst.plane(i);
+        if (from.empty()) {
+            continue;
+        }
+        
+        // Chroma samples are single bytes; interleaved planes overlap harmlessly
+        uint32_t sampleBytes = i == 0 ? info.bytesPerPixel() : 1;
+        size_t rowBytes = from.getSampleStride() != 0
+            ? static_cast<size_t>(from.getWidth() - 1) * from.getSampleStride() + sampleBytes
+            : info.rowBytes(from.getWidth());
+        for (uint32_t y = 0; y < from.getHeight(); ++y) {
+            std::memcpy(to.row(y), from.row(y), rowBytes);
+        }
+    }
+}
+
+} // anonymous namespace
+
+FrameReplaySource::FrameReplaySource(const FrameReplayConfig& config)
+    : config_(config)
+{
+}
+
+FrameReplaySource::~FrameReplaySource() {
+    close();
+}
+
+bool FrameReplaySource::open(const std::string& path) {
+    if (fd_ >= 0 || isRunning()) {
+        return false;
+    }
+    
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+    
+    framefile::FileHeader header;
+    struct stat st;
+    if (!readFully(fd, &header, sizeof(header), 0) || fstat(fd, &st) != 0 ||
+        header.magic != framefile::kFileMagic || header.version != framefile::kVersion) {
+        ::close(fd);
+        return false;
+    }
+    
+    BufferDescriptor descriptor;
+    descriptor.width = header.width;
+    descriptor.height = header.height;
+    descriptor.stride = header.stride;
+    descriptor.format = static_cast<PixelFormat>(header.format);
+    descriptor.layerCount = header.layerCount;
+    descriptor.usage = static_cast<BufferUsage>(header.usage);
+    
+    if (!descriptor.isValid() || header.frameBytes != descriptor.calculateSize() ||
+        header.recordBytes != framefile::recordBytes(header.frameBytes) ||
+        header.headerBytes < sizeof(header)) {
+        ::close(fd);
+        return false;
+    }
+    
+    // An unfinished recording has no count; trust only complete records
+    uint64_t fileBytes = static_cast<uint64_t>(st.st_size);
+    uint64_t available = fileBytes > header.headerBytes
+        ? (fileBytes - header.headerBytes) / header.recordBytes
+        : 0;
+    frameCount_ = header.frameCount != 0 ? std::min(header.frameCount, available) : available;
+    
+    fd_ = fd;
+    descriptor_ = descriptor;
+    frameBytes_ = header.frameBytes;
+    recordBytes_ = header.recordBytes;
+    headerBytes_ = header.headerBytes;
+    staging_.resize(frameBytes_);
+    {
+        std::lock_guard<std::mutex> lock(statsMutex_);
+        stats_ = FrameReplayStatistics();
+    }
+    
+    posix_fadvise(fd_, 0, 0, POSIX_FADV_SEQUENTIAL);
+    return true;
+}
+
+void FrameReplaySource::close() {
+    stop();
+    wait();
+    if (fd_ >= 0) {
+        ::close(fd_);
+        fd_ = -1;
+    }
+    frameCount_ = 0;
+    staging_.clear();
+    staging_.shrink_to_fit();
+}
+
+bool FrameReplaySource::readFrame(uint64_t index, GraphicBuffer* buffer, RecordedFrame* outFrame) {
+    if (fd_ < 0 || !buffer || index >= frameCount_ ||
+        !sameImage(buffer->getDescriptor(), descriptor_)) {
+        return false;
+    }
+    
+    uint64_t offset = headerBytes_ + index * recordBytes_;
+    framefile::RecordHeader header;
+    if (!readFully(fd_, &header, sizeof(header), offset) ||
+        header.magic != framefile::kRecordMagic || header.index != index ||
+        header.payloadBytes != frameBytes_) {
+        std::lock_guard<std::mutex> lock(statsMutex_);
+        stats_.readErrors++;
+        return false;
+    }
+    
+    BufferLockGuard guard(buffer, BufferLockGuard::LockMode::Write);
+    if (!guard || !guard.getRawData()) {
+        return false;
+    }
+    
+    // Matching layouts read straight into the buffer
+    const BufferDescriptor& layout = buffer->getDescriptor();
+    bool direct = layout.stride == descriptor_.stride && guard.getSize() >= frameBytes_;
+    if (!direct && layout.layerCount != 1) {
+        return false;
+    }
+    uint8_t* payload = direct ? guard.getData<uint8_t>() : staging_.data();
+    
+    if (!readFully(fd_, payload, frameBytes_, offset + framefile::kRecordHeaderBytes)) {
+        std::lock_guard<std::mutex> lock(statsMutex_);
+        stats_.readErrors++;
+        return false;
+    }
+    
+    if (config_.verifyChecksum && (header.flags & framefile::RECORD_HAS_CRC) &&
+        BufferMapper::crc32c(payload, frameBytes_) != header.crc) {
+        std::lock_guard<std::mutex> lock(statsMutex_);
+        stats_.checksumErrors++;
+        return false;
+    }
+    
+    if (!direct) {
+        copyPlanes(BufferMapper::getImageView(static_cast<const void*>(payload), descriptor_),
+                   guard.getImageView());
+    }
+    
+    if (outFrame) {
+        outFrame->index = index;
+        outFrame->timestampNs = header.timestampNs;
+    }
+    return true;
+}
+
+bool FrameReplaySource::start(BufferPool& pool, FrameCallback callback) {
+    if (fd_ < 0 || !callback || isRunning() ||
+        !sameImage(pool.getDescriptor(), descriptor_)) {
+        return false;
+    }
+    
+    // Reap a previous replay that ran to completion
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+    {
+        std::lock_guard<std::mutex> lock(stopMutex_);
+        stopRequested_ = false;
+    }
+    
+    running_.store(true, std::memory_order_release);
+    thread_ = std::thread(&FrameReplaySource::replayLoop, this, &pool, std::move(callback));
+    return true;
+}
+
+void FrameReplaySource::stop() {
+    {
+        std::lock_guard<std::mutex> lock(stopMutex_);
+        stopRequested_ = true;
+    }
+    stopSignal_.notify_all();
+}
+
+void FrameReplaySource::wait() {
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+}
+
+FrameReplayStatistics FrameReplaySource::getStatistics() const {
+    std::lock_guard<std::mutex> lock(statsMutex_);
+    return stats_;
+}
+
+bool FrameReplaySource::stopRequested() {
+    std::lock_guard<std::mutex> lock(stopMutex_);
+    return stopRequested_;
+}
+
+void FrameReplaySource::replayLoop(BufferPool* pool, FrameCallback callback) {
+    using Clock = std::chrono::steady_clock;
+    
+    Clock::time_point epoch;
+    int64_t firstTimestampNs = 0;
+    bool haveEpoch = false;
+    uint64_t index = 0;
+    
+    while (!stopRequested()) {
+        if (index >= frameCount_) {
+            if (!config_.loop || frameCount_ == 0) {
+                break;
+            }
+            // Each pass restarts the clock at its first frame
+            index = 0;
+            haveEpoch = false;
+        }
+        
+        GraphicBuffer* buffer = pool->acquireBuffer(config_.acquireTimeoutMs);
+        if (!buffer) {
+            std::lock_guard<std::mutex> lock(statsMutex_);
+            stats_.poolTimeouts++;
+            index++;
+            continue;
+        }
+        
+        RecordedFrame frame;
+        if (!readFrame(index++, buffer, &frame)) {
+            pool->releaseBuffer(buffer);
+            continue;
+        }
+        
+        if (config_.speed > 0.0f) {
+            if (!haveEpoch) {
+                epoch = Clock::now();
+                firstTimestampNs = frame.timestampNs;
+                haveEpoch = true;
+            }
+            auto offset = std::chrono::nanoseconds(static_cast<int64_t>(
+                static_cast<double>(frame.timestampNs - firstTimestampNs) / config_.speed));
+            Clock::time_point due = epoch + offset;
+            
+            int64_t latenessNs = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                Clock::now() - due).count();
+            if (latenessNs > kLateToleranceNs) {
+                std::lock_guard<std::mutex> lock(statsMutex_);
+                stats_.lateFrames++;
+                stats_.maxLatenessNs = std::max(stats_.maxLatenessNs, latenessNs);
+            } else if (latenessNs < 0) {
+                std::unique_lock<std::mutex> lock(stopMutex_);
+                if (stopSignal_.wait_until(lock, due, [this] { return stopRequested_; })) {
+                    lock.unlock();
+                    pool->releaseBuffer(buffer);
+                    break;
+                }
+            }
+        }
+        
+        callback(buffer, frame);
+        
+        std::lock_guard<std::mutex> lock(statsMutex_);
+        stats_.framesDelivered++;
+    }
+    
+    running_.store(false, std::memory_order_release);
+}
+
+} // namespace graphics
+} // namespace android
@@ -6,12 +6,86 @@
 #include "GrallocAllocator.h"
 #include "GraphicBuffer.h"
 #include "BufferCache.h"
+#include "FormatTraits.h"
 #include <thread>
 #include <sstream>
+#include <algorithm>
+#include <cstring>
+
+#if defined(__linux__)
+#include <sys/mman.h>
+#include <linux/memfd.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
 
 namespace android {
 namespace graphics {
 
+namespace {
+
+// Layout of NativeHandle::data for buffers allocated here
+enum HandleInt {
+    kHandleWidth = 0,
+    kHandleHeight,
+    kHandleFormat,
+    kHandleStride,
+    kHandleSizeLow,
+    kHandleSizeHigh,
+    kHandleBacking,     // BackingFlags actually applied
+    kHandleHugeTlb,     // Non-zero if backed by hugetlbfs
+    kHandleOffsetLow,   // Offset within a shared (batch) backing
+    kHandleOffsetHigh,
+    kHandleIntCount
+};
+
+size_t alignUp(size_t value, size_t alignment) {
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+size_t getHandleSize(const NativeHandle& handle) {
+    return static_cast<size_t>(static_cast<uint32_t>(handle.data[kHandleSizeLow])) |
+           (static_cast<size_t>(static_cast<uint32_t>(handle.data[kHandleSizeHigh])) << 32);
+}
+
+size_t getHandleOffset(const NativeHandle& handle) {
+    return static_cast<size_t>(static_cast<uint32_t>(handle.data[kHandleOffsetLow])) |
+           (static_cast<size_t>(static_cast<uint32_t>(handle.data[kHandleOffsetHigh])) << 32);
+}
+
+#if defined(__linux__)
+size_t getPageSize() {
+    static const size_t pageSize = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    return pageSize;
+}
+
+int createMemfd(size_t size, bool wantHuge, bool& outHugeTlb) {
+    outHugeTlb = false;
+    
+    if (wantHuge) {
+        // hugetlbfs first; fall back to THP on shmem if no pages are reserved
+        int fd = memfd_create("gralloc-buffer", MFD_CLOEXEC | MFD_HUGETLB | MFD_HUGE_2MB);
+        if (fd >= 0) {
+            if (ftruncate(fd, static_cast<off_t>(size)) == 0 &&
+                fallocate(fd, 0, 0, static_cast<off_t>(size)) == 0) {
+                outHugeTlb = true;
+                return fd;
+            }
+            ::close(fd);
+        }
+    }
+    
+    int fd = memfd_create("gralloc-buffer", MFD_CLOEXEC);
+    if (fd >= 0 && ftruncate(fd, static_cast<off_t>(size)) != 0) {
+        ::close(fd);
+        fd = -1;
+    }
+    return fd;
+}
+#endif
+
+} // namespace
+
 GrallocAllocator::GrallocAllocator()
     : GrallocAllocator(GrallocVersion::GRALLOC_4_0)  // Auto-detect would go here
 {
@@ -21,11 +95,15 @@ GrallocAllocator::GrallocAllocator(GrallocVersion version)
     : version_(version)
     , mapper_(std::make_unique<GrallocMapper>(version))
     , cache_(std::make_unique<BufferCache>(128))
+    , reserve_(std::make_unique<BufferReserve>())
 {
     initializeHal();
+    startAsyncWorkers();
 }
 
 GrallocAllocator::~GrallocAllocator() {
+    stopAsyncWorkers();
+    trimReserve();
     shutdownHal();
 }
 
@@ -41,38 +119,201 @@ AllocationStatus GrallocAllocator::allocate(
         return AllocationStatus::ERROR_UNSUPPORTED_FORMAT;
     }
     
+    BufferDescriptor resolved = resolveLayout(descriptor);
+    
     std::lock_guard<std::mutex> lock(allocMutex_);
     
+    // Serve from the warm reserve before going to the HAL
     NativeHandle handle;
-    AllocationStatus status = allocateInternal(descriptor, handle);
+    if (reserve_->take(resolved, handle)) {
+        clearHandle(handle);
+    } else {
+        AllocationStatus status = allocateInternal(resolved, handle);
+        
+        if (status != AllocationStatus::SUCCESS) {
+            return status;
+        }
+    }
     
-    if (status != AllocationStatus::SUCCESS) {
-        return status;
+    std::vector<NativeHandle> evicted;
+    reserve_->recordAllocation(resolved, evicted, getAllocationSize(resolved));
+    for (auto& cold : evicted) {
+        releaseHandle(cold);
     }
     
-    outBuffer = std::make_unique<GraphicBuffer>(descriptor, handle, this);
-    activeBuffers_[outBuffer->getBufferId()] = outBuffer.get();
+    outBuffer = createBuffer(resolved, handle);
+    return AllocationStatus::SUCCESS;
+}
+
+AllocationStatus GrallocAllocator::allocateBatch(
+    const BufferDescriptor& descriptor,
+    uint32_t count,
+    std::vector<std::unique_ptr<GraphicBuffer>>& outBuffers
+) {
+    if (!descriptor.isValid()) {
+        return AllocationStatus::ERROR_INVALID_DIMENSIONS;
+    }
     
-    // Cache the entry
-    BufferCacheEntry entry;
-    entry.bufferId = outBuffer->getBufferId();
-    entry.descriptor = descriptor;
-    entry.handle = handle;
-    cache_->insert(entry);
+    if (!isFormatSupported(descriptor.format, descriptor.usage)) {
+        return AllocationStatus::ERROR_UNSUPPORTED_FORMAT;
+    }
     
-    return AllocationStatus::SUCCESS;
+    BufferDescriptor resolved = resolveLayout(descriptor);
+    
+    // One lock and one HAL call for the whole batch
+    std::lock_guard<std::mutex> lock(allocMutex_);
+    
+    std::vector<NativeHandle> handles;
+    handles.reserve(count);
+    
+    NativeHandle warm;
+    while (handles.size() < count && reserve_->take(resolved, warm)) {
+        clearHandle(warm);
+        handles.push_back(warm);
+    }
+    
+    AllocationStatus status = AllocationStatus::SUCCESS;
+    if (handles.size() < count) {
+        status = allocateBatchInternal(
+            resolved, count - static_cast<uint32_t>(handles.size()), handles);
+    }
+    
+    if (!handles.empty()) {
+        std::vector<NativeHandle> evicted;
+        reserve_->recordAllocation(resolved, evicted, getAllocationSize(resolved));
+        for (auto& cold : evicted) {
+            releaseHandle(cold);
+        }
+    }
+    
+    outBuffers.reserve(outBuffers.size() + handles.size());
+    for (const auto& handle : handles) {
+        outBuffers.push_back(createBuffer(resolved, handle));
+    }
+    
+    return status;
 }
 
 void GrallocAllocator::allocateAsync(
     const BufferDescriptor& descriptor,
     AllocationCallback callback
 ) {
-    // Launch async allocation on worker thread
-    std::thread([this, descriptor, callback]() {
-        std::unique_ptr<GraphicBuffer> buffer;
-        AllocationStatus status = allocate(descriptor, buffer);
-        callback(status, buffer.release());
-    }).detach();
+    submitAsync(descriptor, std::move(callback), AllocationPriority::NORMAL);
+}
+
+uint64_t GrallocAllocator::submitAsync(
+    const BufferDescriptor& descriptor,
+    AllocationCallback callback,
+    AllocationPriority priority
+) {
+    AsyncRequest request;
+    request.callback = std::move(callback);
+    request.submitTime = Clock::now();
+    
+    {
+        std::lock_guard<std::mutex> lock(asyncMutex_);
+        
+        // The bound counts requests, so coalescing cannot grow a job forever
+        if (!asyncStopping_ && asyncPendingRequests_ < kMaxAsyncQueueDepth) {
+            request.requestId = nextAsyncRequestId_++;
+            
+            // Coalesce with a queued job for the same descriptor
+            auto it = std::find_if(asyncQueue_.begin(), asyncQueue_.end(),
+                [&descriptor](const AsyncJob& job) {
+                    return job.descriptor == descriptor;
+                });
+            
+            if (it != asyncQueue_.end()) {
+                uint64_t requestId = request.requestId;
+                it->requests.push_back(std::move(request));
+                
+                // Promote the whole job if the new request is more urgent
+                if (priority > it->priority) {
+                    AsyncJob job = std::move(*it);
+                    asyncQueue_.erase(it);
+                    job.priority = priority;
+                    enqueueAsyncJob(std::move(job));
+                }
+                
+                asyncPendingRequests_++;
+                asyncMetrics_.submitted++;
+                asyncMetrics_.coalesced++;
+                asyncMetrics_.peakQueueDepth = std::max(
+                    asyncMetrics_.peakQueueDepth, asyncPendingRequests_);
+                asyncCondition_.notify_one();
+                return requestId;
+            }
+            
+            uint64_t requestId = request.requestId;
+            
+            AsyncJob job;
+            job.descriptor = descriptor;
+            job.priority = priority;
+            job.requests.push_back(std::move(request));
+            enqueueAsyncJob(std::move(job));
+            
+            asyncPendingRequests_++;
+            asyncMetrics_.submitted++;
+            asyncMetrics_.peakQueueDepth = std::max(
+                asyncMetrics_.peakQueueDepth, asyncPendingRequests_);
+            asyncCondition_.notify_one();
+            return requestId;
+        }
+        
+        asyncMetrics_.rejected++;
+    }
+    
+    // Rejected: report outside the lock
+    if (request.callback) {
+        request.callback(AllocationStatus::ERROR_QUEUE_FULL, nullptr);
+    }
+    return 0;
+}
+
+bool GrallocAllocator::cancelAsync(uint64_t requestId) {
+    AllocationCallback callback;
+    
+    {
+        std::lock_guard<std::mutex> lock(asyncMutex_);
+        
+        bool found = false;
+        for (auto jobIt = asyncQueue_.begin(); jobIt != asyncQueue_.end(); ++jobIt) {
+            auto& requests = jobIt->requests;
+            auto it = std::find_if(requests.begin(), requests.end(),
+                [requestId](const AsyncRequest& r) {
+                    return r.requestId == requestId;
+                });
+            
+            if (it == requests.end()) {
+                continue;
+            }
+            
+            callback = std::move(it->callback);
+            requests.erase(it);
+            if (requests.empty()) {
+                asyncQueue_.erase(jobIt);
+            }
+            found = true;
+            break;  // jobIt may be invalid now
+        }
+        
+        if (!found) {
+            return false;  // Unknown or already running
+        }
+        
+        asyncPendingRequests_--;
+        asyncMetrics_.cancelled++;
+    }
+    
+    if (callback) {
+        callback(AllocationStatus::ERROR_CANCELLED, nullptr);
+    }
+    return true;
+}
+
+size_t GrallocAllocator::getAsyncQueueDepth() const {
+    std::lock_guard<std::mutex> lock(asyncMutex_);
+    return asyncPendingRequests_;
 }
 
 void GrallocAllocator::free(GraphicBuffer* buffer) {
@@ -84,12 +325,18 @@ void GrallocAllocator::free(GraphicBuffer* buffer) {
     
     // Remove from active buffers
     activeBuffers_.erase(id);
+    bool imported = importedBuffers_.erase(id) > 0;
     
     // Invalidate cache
     cache_->invalidate(id);
     
-    // Platform-specific free would happen here
-    // gralloc->freeBuffer(buffer->getNativeHandle());
+    // Keep the handle warm if its shape is likely to come back
+    if (!imported && reserve_->offer(buffer->getDescriptor(), buffer->getNativeHandle())) {
+        return;
+    }
+    
+    NativeHandle handle = buffer->getNativeHandle();
+    releaseHandle(handle);
 }
 
 AllocationStatus GrallocAllocator::importBuffer(
@@ -105,9 +352,22 @@ AllocationStatus GrallocAllocator::importBuffer(
     
     // Create buffer from imported handle
     NativeHandle importedHandle = handle;  // Would be registerBuffer
+#if defined(__linux__)
+    // Own the fd so the import's mapping is keyed apart from the exporter's
+    // and freeing it cannot unmap or close memory the exporter still uses
+    importedHandle.fd = ::fcntl(handle.fd, F_DUPFD_CLOEXEC, 0);
+    if (importedHandle.fd < 0) {
+        return AllocationStatus::ERROR_GRALLOC_FAILURE;
+    }
+    
+    // The dup is a backing of its own with a single user, so releaseHandle
+    // closes it without touching the exporter's refcount or pages
+    backingRefs_[importedHandle.fd] = 1;
+#endif
     
-    outBuffer = std::make_unique<GraphicBuffer>(descriptor, importedHandle, this);
+    outBuffer = std::make_unique<GraphicBuffer>(descriptor, importedHandle, getBufferOwner());
     activeBuffers_[outBuffer->getBufferId()] = outBuffer.get();
+    importedBuffers_.insert(outBuffer->getBufferId());
     
     return AllocationStatus::SUCCESS;
 }
@@ -125,21 +385,27 @@ bool GrallocAllocator::isFormatSupported(
     BufferUsage usage
 ) const {
     // Simplified - real implementation would query gralloc
-    switch (format) {
-        case PixelFormat::RGBA_8888:
-        case PixelFormat::RGBX_8888:
-        case PixelFormat::RGB_888:
-        case PixelFormat::RGB_565:
-        case PixelFormat::NV21:
-        case PixelFormat::NV12:
-        case PixelFormat::YV12:
-        case PixelFormat::RAW10:
-        case PixelFormat::RAW16:
-        case PixelFormat::BLOB:
-            return true;
-        default:
-            return false;
-    }
+    return getFormatInfo(format).allocatable;
+}
+
+BackingFlags GrallocAllocator::getSupportedBackingFlags() const {
+#if defined(__linux__)
+    return BackingFlags::HUGE_PAGES | BackingFlags::GUARD_PAGES;
+#else
+    return BackingFlags::NONE;
+#endif
+}
+
+bool GrallocAllocator::lockHandle(
+    const NativeHandle& handle,
+    BufferUsage usage,
+    void** outData
+) {
+    return mapper_->lock(handle, usage, nullptr, outData);
+}
+
+bool GrallocAllocator::unlockHandle(const NativeHandle& handle) {
+    return mapper_->unlock(handle);
 }
 
 bool GrallocAllocator::queryFormatInfo(
@@ -147,17 +413,108 @@ bool GrallocAllocator::queryFormatInfo(
     BufferUsage usage,
     uint32_t& outStride
 ) const {
-    // Would query gralloc for actual stride
-    outStride = 0;  // Let gralloc decide
+    outStride = BufferMapper::calculateStride(format, 1);
     return isFormatSupported(format, usage);
 }
 
+uint32_t GrallocAllocator::prewarm(const BufferDescriptor& requested, uint32_t count) {
+    if (!requested.isValid() ||
+        !isFormatSupported(requested.format, requested.usage)) {
+        return 0;
+    }
+    
+    BufferDescriptor descriptor = resolveLayout(requested);
+    
+    std::lock_guard<std::mutex> lock(allocMutex_);
+    
+    std::vector<NativeHandle> evicted;
+    reserve_->recordAllocation(descriptor, evicted, getAllocationSize(descriptor));
+    for (auto& cold : evicted) {
+        releaseHandle(cold);
+    }
+    
+    uint32_t added = 0;
+    for (uint32_t i = 0; i < count; ++i) {
+        NativeHandle handle;
+        if (allocateInternal(descriptor, handle) != AllocationStatus::SUCCESS) {
+            break;
+        }
+        
+        if (!reserve_->offer(descriptor, handle)) {
+            releaseHandle(handle);  // Reserve is full
+            break;
+        }
+        added++;
+    }
+    
+    return added;
+}
+
+size_t GrallocAllocator::trimReserve() {
+    std::lock_guard<std::mutex> lock(allocMutex_);
+    
+    std::vector<NativeHandle> released;
+    size_t bytes = reserve_->trim(released);
+    for (auto& handle : released) {
+        releaseHandle(handle);
+    }
+    
+    return bytes;
+}
+
+size_t GrallocAllocator::releaseCachedMemory() {
+    return trimReserve();
+}
+
+size_t GrallocAllocator::getCachedBytes() const {
+    return reserve_->getStatistics().reservedBytes;
+}
+
+size_t GrallocAllocator::getAllocationSize(const BufferDescriptor& descriptor) const {
+    size_t size = resolveLayout(descriptor).calculateSize();
+#if defined(__linux__)
+    // Each buffer gets whole pages (or huge pages) of its backing memfd
+    BackingFlags applied = descriptor.backing & getSupportedBackingFlags();
+    bool wantHuge = (applied & BackingFlags::HUGE_PAGES) != BackingFlags::NONE;
+    size = alignUp(size, wantHuge ? kHugePageSize : getPageSize());
+#endif
+    return size;
+}
+
+BufferReserveStatistics GrallocAllocator::getReserveStatistics() const {
+    return reserve_->getStatistics();
+}
+
 std::string GrallocAllocator::dumpState() const {
     std::ostringstream ss;
     ss << "GrallocAllocator State:\n";
     ss << "  Version: " << static_cast<int>(version_) << "\n";
     ss << "  Active buffers: " << activeBuffers_.size() << "\n";
     ss << "  Cache hit rate: " << (cache_->getHitRate() * 100) << "%\n";
+    
+    BufferReserveStatistics reserve = reserve_->getStatistics();
+    ss << "  Reserve: " << reserve.reservedBuffers << " buffers, "
+       << reserve.reservedBytes << " bytes across "
+       << reserve.trackedShapes << " shapes (hits=" << reserve.hits
+       << " misses=" << reserve.misses << ")\n";
+    
+    std::lock_guard<std::mutex> lock(asyncMutex_);
+    const AsyncMetrics& m = asyncMetrics_;
+    ss << "  Async workers: " << asyncWorkers_.size() << "\n";
+    ss << "  Async queue: " << asyncQueue_.size() << " jobs, "
+       << asyncPendingRequests_ << " requests (peak " << m.peakQueueDepth
+       << "/" << kMaxAsyncQueueDepth << ")\n";
+    ss << "  Async requests: submitted=" << m.submitted
+       << " completed=" << m.completed
+       << " coalesced=" << m.coalesced
+       << " rejected=" << m.rejected
+       << " cancelled=" << m.cancelled << "\n";
+    if (m.completed > 0) {
+        ss << "  Async queue wait: avg=" << (m.totalWaitUs / m.completed)
+           << "us max=" << m.maxWaitUs << "us\n";
+        ss << "  Async latency: avg=" << (m.totalLatencyUs / m.completed)
+           << "us max=" << m.maxLatencyUs << "us\n";
+    }
     return ss.str();
 }
 
@@ -172,26 +529,254 @@ void GrallocAllocator::shutdownHal() {
     halHandle_ = nullptr;
 }
 
+void GrallocAllocator::startAsyncWorkers() {
+    asyncWorkers_.reserve(kAsyncWorkerCount);
+    for (size_t i = 0; i < kAsyncWorkerCount; ++i) {
+        asyncWorkers_.emplace_back(&GrallocAllocator::asyncWorkerLoop, this);
+    }
+}
+
+void GrallocAllocator::stopAsyncWorkers() {
+    std::deque<AsyncJob> abandoned;
+    
+    {
+        std::lock_guard<std::mutex> lock(asyncMutex_);
+        asyncStopping_ = true;
+        abandoned.swap(asyncQueue_);
+        asyncPendingRequests_ = 0;
+    }
+    asyncCondition_.notify_all();
+    
+    for (auto& worker : asyncWorkers_) {
+        if (worker.joinable()) {
+            worker.join();
+        }
+    }
+    asyncWorkers_.clear();
+    
+    // Requests that never reached a worker are reported as cancelled
+    for (auto& job : abandoned) {
+        for (auto& request : job.requests) {
+            if (request.callback) {
+                request.callback(AllocationStatus::ERROR_CANCELLED, nullptr);
+            }
+        }
+    }
+}
+
+void GrallocAllocator::asyncWorkerLoop() {
+    for (;;) {
+        AsyncJob job;
+        
+        {
+            std::unique_lock<std::mutex> lock(asyncMutex_);
+            asyncCondition_.wait(lock, [this]() {
+                return asyncStopping_ || !asyncQueue_.empty();
+            });
+            
+            if (asyncStopping_) {
+                return;
+            }
+            
+            job = std::move(asyncQueue_.front());
+            asyncQueue_.pop_front();
+            asyncPendingRequests_ -= job.requests.size();
+        }
+        
+        Clock::time_point pickup = Clock::now();
+        
+        // One batch for every coalesced request; on a partial batch the
+        // requests past the last buffer get the failure status
+        std::vector<std::unique_ptr<GraphicBuffer>> buffers;
+        AllocationStatus batchStatus = allocateBatch(
+            job.descriptor, static_cast<uint32_t>(job.requests.size()), buffers);
+        
+        for (size_t i = 0; i < job.requests.size(); ++i) {
+            auto& request = job.requests[i];
+            std::unique_ptr<GraphicBuffer> buffer;
+            AllocationStatus status = batchStatus;
+            if (i < buffers.size()) {
+                buffer = std::move(buffers[i]);
+                status = AllocationStatus::SUCCESS;
+            }
+            
+            if (request.callback) {
+                request.callback(status, buffer.release());
+            }
+            
+            auto waitUs = static_cast<uint64_t>(
+                std::chrono::duration_cast<std::chrono::microseconds>(
+                    pickup - request.submitTime).count());
+            auto latencyUs = static_cast<uint64_t>(
+                std::chrono::duration_cast<std::chrono::microseconds>(
+                    Clock::now() - request.submitTime).count());
+            
+            std::lock_guard<std::mutex> lock(asyncMutex_);
+            asyncMetrics_.completed++;
+            asyncMetrics_.totalWaitUs += waitUs;
+            asyncMetrics_.maxWaitUs = std::max(asyncMetrics_.maxWaitUs, waitUs);
+            asyncMetrics_.totalLatencyUs += latencyUs;
+            asyncMetrics_.maxLatencyUs = std::max(asyncMetrics_.maxLatencyUs, latencyUs);
+        }
+    }
+}
+
+void GrallocAllocator::enqueueAsyncJob(AsyncJob&& job) {
+    // Caller holds asyncMutex_. Insert after all jobs of equal or
+    // higher priority to keep FIFO order within a priority level.
+    auto it = std::find_if(asyncQueue_.begin(), asyncQueue_.end(),
+        [&job](const AsyncJob& queued) {
+            return queued.priority < job.priority;
+        });
+    asyncQueue_.insert(it, std::move(job));
+}
+
 AllocationStatus GrallocAllocator::allocateInternal(
     const BufferDescriptor& descriptor,
     NativeHandle& outHandle
+) {
+    std::vector<NativeHandle> handles;
+    AllocationStatus status = allocateBatchInternal(descriptor, 1, handles);
+    
+    if (status == AllocationStatus::SUCCESS) {
+        outHandle = handles.front();
+    }
+    return status;
+}
+
+AllocationStatus GrallocAllocator::allocateBatchInternal(
+    const BufferDescriptor& descriptor,
+    uint32_t count,
+    std::vector<NativeHandle>& outHandles
 ) {
     // Real implementation would call:
-    // gralloc->allocate(mapper::V4_0::IMapper::BufferDescriptorInfo{...}, ...)
+    // gralloc->allocate(mapper::V4_0::IMapper::BufferDescriptorInfo{...}, count, ...)
     
     // Simulate allocation
-    outHandle.fd = 42;  // Would be real FD from gralloc
-    outHandle.numFds = 1;
-    outHandle.numInts = 8;
+    BackingFlags applied = descriptor.backing & getSupportedBackingFlags();
     
-    // Store dimensions in handle data
-    outHandle.data[0] = descriptor.width;
-    outHandle.data[1] = descriptor.height;
-    outHandle.data[2] = static_cast<int>(descriptor.format);
+    NativeHandle handle;
+    handle.numFds = 1;
+    handle.numInts = kHandleIntCount;
+    
+    // Store dimensions and backing layout in handle data
+    handle.data[kHandleWidth] = descriptor.width;
+    handle.data[kHandleHeight] = descriptor.height;
+    handle.data[kHandleFormat] = static_cast<int>(descriptor.format);
+    handle.data[kHandleStride] = descriptor.stride;
+    handle.data[kHandleBacking] = static_cast<int>(applied);
+
+#if defined(__linux__)
+    // Back the simulated buffers with memfds so CPU locks see real memory
+    bool wantHuge = (applied & BackingFlags::HUGE_PAGES) != BackingFlags::NONE;
+    bool guarded = (applied & BackingFlags::GUARD_PAGES) != BackingFlags::NONE;
+    size_t slot = getAllocationSize(descriptor);
+    
+    // Carve the batch from one backing; guarded buffers each need their own
+    uint32_t perBacking = guarded ? 1 : count;
+    
+    for (uint32_t done = 0; done < count; ) {
+        uint32_t carve = std::min(perBacking, count - done);
+        
+        bool hugeTlb = false;
+        int fd = createMemfd(slot * carve, wantHuge, hugeTlb);
+        if (fd < 0) {
+            return AllocationStatus::ERROR_NO_MEMORY;
+        }
+        backingRefs_[fd] = carve;
+        
+        handle.fd = fd;
+        handle.data[kHandleSizeLow] = static_cast<int>(slot & 0xffffffffu);
+        handle.data[kHandleSizeHigh] = static_cast<int>(static_cast<uint64_t>(slot) >> 32);
+        handle.data[kHandleHugeTlb] = hugeTlb ? 1 : 0;
+        
+        for (uint32_t i = 0; i < carve; ++i) {
+            uint64_t offset = static_cast<uint64_t>(slot) * i;
+            handle.data[kHandleOffsetLow] = static_cast<int>(offset & 0xffffffffu);
+            handle.data[kHandleOffsetHigh] = static_cast<int>(offset >> 32);
+            outHandles.push_back(handle);
+        }
+        done += carve;
+    }
+#else
+    size_t size = descriptor.calculateSize();
+    handle.fd = 42;  // Would be real FD from gralloc
+    handle.data[kHandleSizeLow] = static_cast<int>(size & 0xffffffffu);
+    handle.data[kHandleSizeHigh] = static_cast<int>(static_cast<uint64_t>(size) >> 32);
+    outHandles.insert(outHandles.end(), count, handle);
+#endif
     
     return AllocationStatus::SUCCESS;
 }
 
+std::unique_ptr<GraphicBuffer> GrallocAllocator::createBuffer(
+    const BufferDescriptor& descriptor,
+    const NativeHandle& handle
+) {
+    auto buffer = std::make_unique<GraphicBuffer>(descriptor, handle, getBufferOwner());
+    activeBuffers_[buffer->getBufferId()] = buffer.get();
+    
+    // Cache the entry
+    BufferCacheEntry entry;
+    entry.bufferId = buffer->getBufferId();
+    entry.descriptor = descriptor;
+    entry.handle = handle;
+    cache_->insert(entry);
+    
+    return buffer;
+}
+
+void GrallocAllocator::releaseHandle(NativeHandle& handle) {
+    mapper_->release(handle);
+    
+    // Platform-specific free would happen here
+    // gralloc->freeBuffer(handle);
+#if defined(__linux__)
+    // Batch buffers share a backing fd; close it with the last handle.
+    // Until then punch out this slot so freeing one sibling returns its
+    // pages instead of pinning them for the life of the backing.
+    auto it = backingRefs_.find(handle.fd);
+    if (it != backingRefs_.end()) {
+        if (--it->second == 0) {
+            ::close(handle.fd);
+            backingRefs_.erase(it);
+        } else {
+            ::fallocate(handle.fd, FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE,
+                        static_cast<off_t>(getHandleOffset(handle)),
+                        static_cast<off_t>(getHandleSize(handle)));
+        }
+    }
+#endif
+    handle.close();
+}
+
+void GrallocAllocator::clearHandle(const NativeHandle& handle) {
+    // Zero through the CPU mapping so the pages stay resident; handles
+    // that cannot be mapped get their slot punched out instead, which
+    // reads back as zeros just like a fresh memfd
+    void* data = nullptr;
+    if (mapper_->lock(handle, BufferUsage::CPU_WRITE_OFTEN, nullptr, &data) && data) {
+        std::memset(data, 0, getHandleSize(handle));
+        mapper_->unlock(handle);
+        return;
+    }
+#if defined(__linux__)
+    ::fallocate(handle.fd, FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE,
+                static_cast<off_t>(getHandleOffset(handle)),
+                static_cast<off_t>(getHandleSize(handle)));
+#endif
+}
+
+BufferDescriptor GrallocAllocator::resolveLayout(const BufferDescriptor& descriptor) const {
+    BufferDescriptor resolved = descriptor;
+    resolved.stride = BufferMapper::calculateAlignedStride(
+        descriptor.format,
+        std::max(descriptor.stride, descriptor.width),
+        descriptor.rowAlignment
+    );
+    return resolved;
+}
+
 // GrallocMapper implementation
 
 GrallocMapper::GrallocMapper(GrallocVersion version)
@@ -202,6 +787,11 @@ GrallocMapper::GrallocMapper(GrallocVersion version)
 }
 
 GrallocMapper::~GrallocMapper() {
+    std::lock_guard<std::mutex> lock(mappingMutex_);
+    for (auto& [fd, mapping] : mappings_) {
+        unmap(mapping);
+    }
+    mappings_.clear();
     mapperHandle_ = nullptr;
 }
 
@@ -216,7 +806,21 @@ bool GrallocMapper::lock(
     }
     
     // Real implementation would call mapper->lock()
-    *outData = nullptr;  // Would be actual mapped pointer
+    *outData = nullptr;
+    
+    std::lock_guard<std::mutex> lock(mappingMutex_);
+    
+    auto key = std::make_pair(handle.fd, getHandleOffset(handle));
+    auto it = mappings_.find(key);
+    if (it == mappings_.end()) {
+        Mapping mapping;
+        if (!mapHandle(handle, mapping)) {
+            return true;  // Not CPU-mappable (simulated handle)
+        }
+        it = mappings_.emplace(key, mapping).first;
+    }
+    
+    *outData = it->second.data;
     return true;
 }
 
@@ -225,13 +829,79 @@ bool GrallocMapper::unlock(const NativeHandle& handle, int* outFence) {
         return false;
     }
     
-    // Real implementation would call mapper->unlock()
+    // Real implementation would call mapper->unlock(). The mapping stays
+    // cached until release() since memfd contents are always coherent.
     if (outFence) {
         *outFence = -1;  // No fence on CPU unlock
     }
     return true;
 }
 
+void GrallocMapper::release(const NativeHandle& handle) {
+    std::lock_guard<std::mutex> lock(mappingMutex_);
+    
+    auto it = mappings_.find(std::make_pair(handle.fd, getHandleOffset(handle)));
+    if (it != mappings_.end()) {
+        unmap(it->second);
+        mappings_.erase(it);
+    }
+}
+
+bool GrallocMapper::mapHandle(const NativeHandle& handle, Mapping& outMapping) {
+    size_t size = getHandleSize(handle);
+    if (size == 0) {
+        return false;
+    }
+
+#if defined(__linux__)
+    BackingFlags backing = static_cast<BackingFlags>(handle.data[kHandleBacking]);
+    bool huge = (backing & BackingFlags::HUGE_PAGES) != BackingFlags::NONE;
+    bool guarded = (backing & BackingFlags::GUARD_PAGES) != BackingFlags::NONE;
+    
+    size_t page = getPageSize();
+    size_t alignment = huge ? GrallocAllocator::kHugePageSize : page;
+    size_t guard = guarded ? page : 0;
+    
+    // Reserve an inaccessible range, then map the buffer into it at an
+    // aligned address. Whatever stays PROT_NONE on either side is a guard.
+    size_t span = guard + size + guard + (alignment > page ? alignment : 0);
+    void* base = mmap(nullptr, span, PROT_NONE,
+                      MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (base == MAP_FAILED) {
+        return false;
+    }
+    
+    uintptr_t start = alignUp(reinterpret_cast<uintptr_t>(base) + guard, alignment);
+    void* data = mmap(reinterpret_cast<void*>(start), size,
+                      PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED,
+                      handle.fd, static_cast<off_t>(getHandleOffset(handle)));
+    if (data == MAP_FAILED) {
+        munmap(base, span);
+        return false;
+    }
+    
+    if (huge && handle.data[kHandleHugeTlb] == 0) {
+        madvise(data, size, MADV_HUGEPAGE);  // Best effort THP on shmem
+    }
+    
+    outMapping.base = base;
+    outMapping.span = span;
+    outMapping.data = data;
+    return true;
+#else
+    return false;
+#endif
+}
+
+void GrallocMapper::unmap(Mapping& mapping) {
+#if defined(__linux__)
+    if (mapping.base) {
+        munmap(mapping.base, mapping.span);
+    }
+#endif
+    mapping = Mapping();
+}
+
 bool GrallocMapper::getMetadata(
     const NativeHandle& handle,
     uint32_t metadataType,
@@ -246,6 +916,26 @@ bool GrallocMapper::getMetadata(
     return false;  // Not implemented for simulation
 }
 
+// IBufferAllocator default implementation
+
+AllocationStatus IBufferAllocator::allocateBatch(
+    const BufferDescriptor& descriptor,
+    uint32_t count,
+    std::vector<std::unique_ptr<GraphicBuffer>>& outBuffers
+) {
+    for (uint32_t i = 0; i < count; ++i) {
+        std::unique_ptr<GraphicBuffer> buffer;
+        AllocationStatus status = allocate(descriptor, buffer);
+        
+        if (status != AllocationStatus::SUCCESS) {
+            return status;
+        }
+        outBuffers.push_back(std::move(buffer));
+    }
+    
+    return AllocationStatus::SUCCESS;
+}
+
 // AllocatorFactory implementation
 
 std::unique_ptr<IBufferAllocator> AllocatorFactory::createDefault() {
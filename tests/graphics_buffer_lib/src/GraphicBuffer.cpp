@@ -6,6 +6,8 @@
 #include "GraphicBuffer.h"
 #include "IBufferAllocator.h"
 #include "FenceManager.h"
+#include "BufferMapper.h"
+#include "FormatTraits.h"
 #include <cstring>
 
 namespace android {
@@ -45,6 +47,9 @@ GraphicBuffer::~GraphicBuffer() {
         unlock();
     }
     
+    // Close an acquire fence nobody waited for
+    Fence pending(acquireFenceFd_);
+    
     if (allocator_ && handle_.isValid()) {
         allocator_->free(this);
     }
@@ -63,7 +68,13 @@ bool GraphicBuffer::lockForRead(MappedRegion& outRegion) {
     }
     
     // Perform the lock (platform-specific)
-    mappedRegion_.data = nullptr;  // Would be set by platform mapper
+    void* data = nullptr;
+    if (allocator_ && 
+        !allocator_->lockHandle(handle_, BufferUsage::CPU_READ_OFTEN, &data)) {
+        return false;
+    }
+    
+    mappedRegion_.data = data;
     mappedRegion_.size = descriptor_.calculateSize();
     mappedRegion_.lockMode = 1;  // Read
     
@@ -82,7 +93,13 @@ bool GraphicBuffer::lockForWrite(MappedRegion& outRegion) {
         waitAcquireFence(1000);
     }
     
-    mappedRegion_.data = nullptr;
+    void* data = nullptr;
+    if (allocator_ && 
+        !allocator_->lockHandle(handle_, BufferUsage::CPU_WRITE_OFTEN, &data)) {
+        return false;
+    }
+    
+    mappedRegion_.data = data;
     mappedRegion_.size = descriptor_.calculateSize();
     mappedRegion_.lockMode = 2;  // Write
     
@@ -106,7 +123,17 @@ bool GraphicBuffer::lockRegion(
         return false;
     }
     
-    mappedRegion_.data = nullptr;
+    void* data = nullptr;
+    if (allocator_ && 
+        !allocator_->lockHandle(handle_, BufferUsage::CPU_WRITE_OFTEN, &data)) {
+        return false;
+    }
+    
+    // Point at the region origin within the (first) plane
+    size_t offset = y * BufferMapper::getRowBytes(descriptor_.format, descriptor_.stride) +
+                    BufferMapper::getRowBytes(descriptor_.format, x);
+    
+    mappedRegion_.data = data ? static_cast<uint8_t*>(data) + offset : nullptr;
     mappedRegion_.size = width * height * 4;  // Simplified
     mappedRegion_.lockMode = 3;  // Region lock
     
@@ -122,6 +149,10 @@ bool GraphicBuffer::unlock() {
     }
     
     // Platform-specific unlock
+    if (allocator_) {
+        allocator_->unlockHandle(handle_);
+    }
+    
     mappedRegion_.data = nullptr;
     mappedRegion_.size = 0;
     mappedRegion_.lockMode = 0;
@@ -152,6 +183,8 @@ int32_t GraphicBuffer::getRefCount() const {
 }
 
 void GraphicBuffer::setAcquireFence(FenceManager* fenceManager, int fenceFd) {
+    // A fence still held from an earlier producer is superseded
+    Fence previous(acquireFenceFd_);
     fenceManager_ = fenceManager;
     acquireFenceFd_ = fenceFd;
 }
@@ -161,8 +194,12 @@ bool GraphicBuffer::waitAcquireFence(uint32_t timeoutMs) {
         return true;  // No fence to wait
     }
     
-    // Platform-specific fence wait
-    // In reality, would use sync_wait()
+    Fence fence(acquireFenceFd_);
+    if (!fence.wait(timeoutMs)) {
+        // Keep the fence so a later wait can still honor it
+        acquireFenceFd_ = fence.release();
+        return false;
+    }
     acquireFenceFd_ = -1;
     return true;
 }
@@ -171,41 +208,31 @@ bool GraphicBuffer::waitAcquireFence(uint32_t timeoutMs) {
 size_t BufferDescriptor::calculateSize() const {
     if (!isValid()) return 0;
     
-    size_t bpp = 4;  // Default RGBA
-    switch (format) {
-        case PixelFormat::RGBA_8888:
-        case PixelFormat::RGBX_8888:
-        case PixelFormat::BGRA_8888:
-            bpp = 4;
-            break;
-        case PixelFormat::RGB_888:
-            bpp = 3;
-            break;
-        case PixelFormat::RGB_565:
-            bpp = 2;
-            break;
-        case PixelFormat::NV21:
-        case PixelFormat::NV12:
-        case PixelFormat::YV12:
-            // Y plane + UV plane (1.5 bytes per pixel)
-            return stride * height * 3 / 2;
-        default:
-            bpp = 4;
-    }
-    
-    return stride * height * bpp * layerCount;
+    return getFormatInfo(format).imageSize(stride, height) * layerCount;
 }
 
 bool BufferDescriptor::isValid() const {
     return width > 0 && height > 0 && format != PixelFormat::UNKNOWN;
 }
 
+bool BufferDescriptor::operator==(const BufferDescriptor& other) const {
+    return width == other.width &&
+           height == other.height &&
+           stride == other.stride &&
+           format == other.format &&
+           usage == other.usage &&
+           layerCount == other.layerCount &&
+           rowAlignment == other.rowAlignment &&
+           backing == other.backing;
+}
+
 std::string BufferDescriptor::toString() const {
     char buf[256];
     snprintf(buf, sizeof(buf), 
-        "BufferDescriptor{%ux%u stride=%u format=%d usage=0x%llx layers=%u}",
+        "BufferDescriptor{%ux%u stride=%u format=%d usage=0x%llx layers=%u align=%u backing=0x%x}",
         width, height, stride, static_cast<int>(format),
-        static_cast<unsigned long long>(usage), layerCount);
+        static_cast<unsigned long long>(usage), layerCount,
+        rowAlignment, static_cast<unsigned>(backing));
     return buf;
 }
 
@@ -0,0 +1,212 @@
+/**
+ * @file RawPacking.cpp
+ * @brief Implementation of RawPacking and its scalar kernels
+ */
+
+#include "RawPacking.h"
+#include "RawPackingKernels.h"
+#include "BufferMapper.h"
+#include <cstring>
+
+namespace android {
+namespace graphics {
+
+namespace kernels {
+
+void unpackRaw10Scalar(const uint8_t* packed, uint16_t* samples, uint32_t width) {
+    for (uint32_t x = 0; x < width; x += 4, packed += 5) {
+        uint8_t low = packed[4];
+        for (uint32_t j = 0; j < 4 && x + j < width; ++j) {
+            samples[x + j] = static_cast<uint16_t>(packed[j] << 2 | ((low >> (2 * j)) & 3));
+        }
+    }
+}
+
+void unpackRaw12Scalar(const uint8_t* packed, uint16_t* samples, uint32_t width) {
+    for (uint32_t x = 0; x < width; x += 2, packed += 3) {
+        samples[x] = static_cast<uint16_t>(packed[0] << 4 | (packed[2] & 0xF));
+        if (x + 1 < width) {
+            samples[x + 1] = static_cast<uint16_t>(packed[1] << 4 | packed[2] >> 4);
+        }
+    }
+}
+
+void packRaw10Scalar(const uint16_t* samples, uint8_t* packed, uint32_t width) {
+    for (uint32_t x = 0; x < width; x += 4, packed += 5) {
+        uint16_t s[4] = {0, 0, 0, 0};
+        for (uint32_t j = 0; j < 4 && x + j < width; ++j) {
+            s[j] = samples[x + j] & 0x3FF;
+        }
+        
+        packed[0] = static_cast<uint8_t>(s[0] >> 2);
+        packed[1] = static_cast<uint8_t>(s[1] >> 2);
+        packed[2] = static_cast<uint8_t>(s[2] >> 2);
+        packed[3] = static_cast<uint8_t>(s[3] >> 2);
+        packed[4] = static_cast<uint8_t>((s[0] & 3) | (s[1] & 3) << 2 |
+                                         (s[2] & 3) << 4 | (s[3] & 3) << 6);
+    }
+}
+
+void packRaw12Scalar(const uint16_t* samples, uint8_t* packed, uint32_t width) {
+    for (uint32_t x = 0; x < width; x += 2, packed += 3) {
+        uint16_t s0 = samples[x] & 0xFFF;
+        uint16_t s1 = x + 1 < width ? samples[x + 1] & 0xFFF : 0;
+        
+        packed[0] = static_cast<uint8_t>(s0 >> 4);
+        packed[1] = static_cast<uint8_t>(s1 >> 4);
+        packed[2] = static_cast<uint8_t>((s0 & 0xF) | (s1 & 0xF) << 4);
+    }
+}
+
+const RawKernels& getScalarRawKernels() {
+    static const RawKernels scalar = {
+        unpackRaw10Scalar,
+        unpackRaw12Scalar,
+        packRaw10Scalar,
+        packRaw12Scalar
+    };
+    return scalar;
+}
+
+} // namespace kernels
+
+namespace {
+
+const kernels::RawKernels& selectKernels() {
+#if defined(__x86_64__) || defined(__i386__)
+    switch (CpuFeatures::getSimdLevel()) {
+        case SimdLevel::AVX2:
+            return kernels::getAvx2RawKernels();
+        case SimdLevel::SSE4_1:
+            return kernels::getSse41RawKernels();
+        default:
+            break;
+    }
+#endif
+    return kernels::getScalarRawKernels();
+}
+
+} // namespace
+
+bool RawPacking::isSupported(PixelFormat format) {
+    return format == PixelFormat::RAW10 ||
+           format == PixelFormat::RAW12 ||
+           format == PixelFormat::RAW16;
+}
+
+bool RawPacking::unpack(GraphicBuffer* buffer, uint16_t* dst, uint32_t dstStride) {
+    if (!buffer || !dst || !isSupported(buffer->getFormat())) {
+        return false;
+    }
+    
+    BufferLockGuard guard(buffer, BufferLockGuard::LockMode::Read);
+    if (!guard || !guard.getRawData()) {
+        return false;
+    }
+    
+    return unpack(guard.getRawData(), buffer->getDescriptor(), dst, dstStride);
+}
+
+bool RawPacking::pack(const uint16_t* src, uint32_t srcStride, GraphicBuffer* buffer) {
+    if (!buffer || !src || !isSupported(buffer->getFormat())) {
+        return false;
+    }
+    
+    BufferLockGuard guard(buffer, BufferLockGuard::LockMode::Write);
+    if (!guard || !guard.getRawData()) {
+        return false;
+    }
+    
+    return pack(src, srcStride, guard.getRawData(), buffer->getDescriptor());
+}
+
+bool RawPacking::unpack(
+    const void* src,
+    const BufferDescriptor& descriptor,
+    uint16_t* dst,
+    uint32_t dstStride
+) {
+    if (!src || !dst || !descriptor.isValid() || !isSupported(descriptor.format)) {
+        return false;
+    }
+    
+    PlaneLayout planes[BufferMapper::kMaxPlanes];
+    BufferMapper::getPlaneLayouts(descriptor, planes);
+    
+    const uint8_t* in = static_cast<const uint8_t*>(src) + planes[0].offset;
+    size_t stride = dstStride ? dstStride : descriptor.width;
+    
+    for (uint32_t row = 0; row < descriptor.height; ++row) {
+        unpackRow(descriptor.format, in + row * planes[0].rowStride,
+                  dst + row * stride, descriptor.width);
+    }
+    return true;
+}
+
+bool RawPacking::pack(
+    const uint16_t* src,
+    uint32_t srcStride,
+    void* dst,
+    const BufferDescriptor& descriptor
+) {
+    if (!src || !dst || !descriptor.isValid() || !isSupported(descriptor.format)) {
+        return false;
+    }
+    
+    PlaneLayout planes[BufferMapper::kMaxPlanes];
+    BufferMapper::getPlaneLayouts(descriptor, planes);
+    
+    uint8_t* out = static_cast<uint8_t*>(dst) + planes[0].offset;
+    size_t stride = srcStride ? srcStride : descriptor.width;
+    
+    for (uint32_t row = 0; row < descriptor.height; ++row) {
+        packRow(descriptor.format, src + row * stride,
+                out + row * planes[0].rowStride, descriptor.width);
+    }
+    return true;
+}
+
+void RawPacking::unpackRow(
+    PixelFormat format,
+    const uint8_t* packed,
+    uint16_t* samples,
+    uint32_t width
+) {
+    switch (format) {
+        case PixelFormat::RAW10:
+            selectKernels().unpackRaw10(packed, samples, width);
+            break;
+        case PixelFormat::RAW12:
+            selectKernels().unpackRaw12(packed, samples, width);
+            break;
+        case PixelFormat::RAW16:
+            std::memcpy(samples, packed, static_cast<size_t>(width) * 2);
+            break;
+        default:
+            break;
+    }
+}
+
+void RawPacking::packRow(
+    PixelFormat format,
+    const uint16_t* samples,
+    uint8_t* packed,
+    uint32_t width
+) {
+    switch (format) {
+        case PixelFormat::RAW10:
+            selectKernels().packRaw10(samples, packed, width);
+            break;
+        case PixelFormat::RAW12:
+            selectKernels().packRaw12(samples, packed, width);
+            break;
+        case PixelFormat::RAW16:
+            std::memcpy(packed, samples, static_cast<size_t>(width) * 2);
+            break;
+        default:
+            break;
+    }
+}
+
+} // namespace graphics
+} // namespace android
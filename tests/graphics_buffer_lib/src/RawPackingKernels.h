@@ -0,0 +1,42 @@
+/**
+ * @file RawPackingKernels.h
+ * @brief Internal row kernel tables for RawPacking
+ * 
+ * Kernels take any width; SIMD variants never read or write past the
+ * packed row and finish the remaining groups in scalar code.
+ */
+
+#pragma once
+
+#include <cstdint>
+
+namespace android {
+namespace graphics {
+namespace kernels {
+
+using UnpackRowFn = void (*)(const uint8_t* packed, uint16_t* samples, uint32_t width);
+using PackRowFn = void (*)(const uint16_t* samples, uint8_t* packed, uint32_t width);
+
+struct RawKernels {
+    UnpackRowFn unpackRaw10;
+    UnpackRowFn unpackRaw12;
+    PackRowFn packRaw10;
+    PackRowFn packRaw12;
+};
+
+// Scalar reference kernels (also used for SIMD tails)
+void unpackRaw10Scalar(const uint8_t* packed, uint16_t* samples, uint32_t width);
+void unpackRaw12Scalar(const uint8_t* packed, uint16_t* samples, uint32_t width);
+void packRaw10Scalar(const uint16_t* samples, uint8_t* packed, uint32_t width);
+void packRaw12Scalar(const uint16_t* samples, uint8_t* packed, uint32_t width);
+
+const RawKernels& getScalarRawKernels();
+
+#if defined(__x86_64__) || defined(__i386__)
+const RawKernels& getSse41RawKernels();
+const RawKernels& getAvx2RawKernels();
+#endif
+
+} // namespace kernels
+} // namespace graphics
+} // namespace android
@@ -0,0 +1,293 @@
+/**
+ * @file RawPackingX86.cpp
+ * @brief SSE4.1 and AVX2 kernels for RawPacking
+ * 
+ * Unpacking gathers each pixel's MSB byte and shared LSB byte into a
+ * 16-bit lane with pshufb, then isolates the LSB bits with a per-lane
+ * multiply standing in for a variable shift. Packing reverses this,
+ * summing the disjoint LSB fields of a group with pmaddwd/phaddd.
+ */
+
+#if defined(__x86_64__) || defined(__i386__)
+
+#include "RawPackingKernels.h"
+#include <immintrin.h>
+#include <cstring>
+
+namespace android {
+namespace graphics {
+namespace kernels {
+
+namespace {
+
+constexpr size_t raw10RowBytes(uint32_t width) { return (static_cast<size_t>(width) + 3) / 4 * 5; }
+constexpr size_t raw12RowBytes(uint32_t width) { return (static_cast<size_t>(width) + 1) / 2 * 3; }
+
+// ============================================================================
+// SSE4.1
+// ============================================================================
+
+// 8 pixels (two 5-byte groups) per step; reads 16 bytes
+__attribute__((target("sse4.1")))
+void unpackRaw10Sse41(const uint8_t* packed, uint16_t* samples, uint32_t width) {
+    const __m128i msbShuffle = _mm_setr_epi8(
+        0, -1, 1, -1, 2, -1, 3, -1, 5, -1, 6, -1, 7, -1, 8, -1);
+    const __m128i lsbShuffle = _mm_setr_epi8(
+        4, -1, 4, -1, 4, -1, 4, -1, 9, -1, 9, -1, 9, -1, 9, -1);
+    const __m128i lsbShift = _mm_setr_epi16(64, 16, 4, 1, 64, 16, 4, 1);
+    const __m128i lsbMask = _mm_set1_epi16(3);
+    const size_t rowBytes = raw10RowBytes(width);
+    
+    uint32_t x = 0;
+    size_t offset = 0;
+    for (; x + 8 <= width && offset + 16 <= rowBytes; x += 8, offset += 10) {
+        __m128i in = _mm_loadu_si128(reinterpret_cast<const __m128i*>(packed + offset));
+        __m128i msb = _mm_slli_epi16(_mm_shuffle_epi8(in, msbShuffle), 2);
+        __m128i lsb = _mm_and_si128(
+            _mm_srli_epi16(_mm_mullo_epi16(_mm_shuffle_epi8(in, lsbShuffle), lsbShift), 6),
+            lsbMask);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(samples + x), _mm_or_si128(msb, lsb));
+    }
+    unpackRaw10Scalar(packed + offset, samples + x, width - x);
+}
+
+// 8 pixels (four 3-byte groups) per step; reads 16 bytes
+__attribute__((target("sse4.1")))
+void unpackRaw12Sse41(const uint8_t* packed, uint16_t* samples, uint32_t width) {
+    const __m128i msbShuffle = _mm_setr_epi8(
+        0, -1, 1, -1, 3, -1, 4, -1, 6, -1, 7, -1, 9, -1, 10, -1);
+    const __m128i lsbShuffle = _mm_setr_epi8(
+        2, -1, 2, -1, 5, -1, 5, -1, 8, -1, 8, -1, 11, -1, 11, -1);
+    const __m128i lsbShift = _mm_setr_epi16(16, 1, 16, 1, 16, 1, 16, 1);
+    const __m128i lsbMask = _mm_set1_epi16(0xF);
+    const size_t rowBytes = raw12RowBytes(width);
+    
+    uint32_t x = 0;
+    size_t offset = 0;
+    for (; x + 8 <= width && offset + 16 <= rowBytes; x += 8, offset += 12) {
+        __m128i in = _mm_loadu_si128(reinterpret_cast<const __m128i*>(packed + offset));
+        __m128i msb = _mm_slli_epi16(_mm_shuffle_epi8(in, msbShuffle), 4);
+        __m128i lsb = _mm_and_si128(
+            _mm_srli_epi16(_mm_mullo_epi16(_mm_shuffle_epi8(in, lsbShuffle), lsbShift), 4),
+            lsbMask);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(samples + x), _mm_or_si128(msb, lsb));
+    }
+    unpackRaw12Scalar(packed + offset, samples + x, width - x);
+}
+
+// 8 pixels to 10 bytes per step; writes exactly 10 bytes
+__attribute__((target("sse4.1")))
+void packRaw10Sse41(const uint16_t* samples, uint8_t* packed, uint32_t width) {
+    const __m128i sampleMask = _mm_set1_epi16(0x3FF);
+    const __m128i lsbMask = _mm_set1_epi16(3);
+    const __m128i lsbWeight = _mm_setr_epi16(1, 4, 16, 64, 1, 4, 16, 64);
+    const __m128i ones = _mm_set1_epi16(1);
+    const __m128i order = _mm_setr_epi8(
+        0, 1, 2, 3, 8, 4, 5, 6, 7, 9, -1, -1, -1, -1, -1, -1);
+    
+    uint32_t x = 0;
+    uint8_t* out = packed;
+    for (; x + 8 <= width; x += 8, out += 10) {
+        __m128i v = _mm_and_si128(
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(samples + x)), sampleMask);
+        __m128i msb = _mm_srli_epi16(v, 2);
+        
+        // LSB fields are disjoint, so summing a group ORs them together
+        __m128i lsb = _mm_madd_epi16(_mm_mullo_epi16(_mm_and_si128(v, lsbMask), lsbWeight), ones);
+        lsb = _mm_hadd_epi32(lsb, lsb);
+        
+        __m128i bytes = _mm_shuffle_epi8(
+            _mm_packus_epi16(msb, _mm_packus_epi32(lsb, lsb)), order);
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(out), bytes);
+        uint16_t tail = static_cast<uint16_t>(_mm_extract_epi16(bytes, 4));
+        std::memcpy(out + 8, &tail, sizeof(tail));
+    }
+    packRaw10Scalar(samples + x, out, width - x);
+}
+
+// 8 pixels to 12 bytes per step; writes exactly 12 bytes
+__attribute__((target("sse4.1")))
+void packRaw12Sse41(const uint16_t* samples, uint8_t* packed, uint32_t width) {
+    const __m128i sampleMask = _mm_set1_epi16(0xFFF);
+    const __m128i lsbMask = _mm_set1_epi16(0xF);
+    const __m128i lsbWeight = _mm_setr_epi16(1, 16, 1, 16, 1, 16, 1, 16);
+    const __m128i ones = _mm_set1_epi16(1);
+    const __m128i order = _mm_setr_epi8(
+        0, 1, 8, 2, 3, 9, 4, 5, 10, 6, 7, 11, -1, -1, -1, -1);
+    
+    uint32_t x = 0;
+    uint8_t* out = packed;
+    for (; x + 8 <= width; x += 8, out += 12) {
+        __m128i v = _mm_and_si128(
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(samples + x)), sampleMask);
+        __m128i msb = _mm_srli_epi16(v, 4);
+        __m128i lsb = _mm_madd_epi16(_mm_mullo_epi16(_mm_and_si128(v, lsbMask), lsbWeight), ones);
+        
+        __m128i bytes = _mm_shuffle_epi8(
+            _mm_packus_epi16(msb, _mm_packus_epi32(lsb, lsb)), order);
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(out), bytes);
+        int32_t tail = _mm_cvtsi128_si32(_mm_srli_si128(bytes, 8));
+        std::memcpy(out + 8, &tail, sizeof(tail));
+    }
+    packRaw12Scalar(samples + x, out, width - x);
+}
+
+// ============================================================================
+// AVX2 (each 128-bit lane runs the SSE4.1 step on its own groups)
+// ============================================================================
+
+__attribute__((target("avx2")))
+inline __m256i loadLanes(const uint8_t* low, const uint8_t* high) {
+    return _mm256_inserti128_si256(
+        _mm256_castsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(low))),
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(high)), 1);
+}
+
+// 16 pixels (four groups) per step; reads 26 bytes
+__attribute__((target("avx2")))
+void unpackRaw10Avx2(const uint8_t* packed, uint16_t* samples, uint32_t width) {
+    const __m256i msbShuffle = _mm256_setr_epi8(
+        0, -1, 1, -1, 2, -1, 3, -1, 5, -1, 6, -1, 7, -1, 8, -1,
+        0, -1, 1, -1, 2, -1, 3, -1, 5, -1, 6, -1, 7, -1, 8, -1);
+    const __m256i lsbShuffle = _mm256_setr_epi8(
+        4, -1, 4, -1, 4, -1, 4, -1, 9, -1, 9, -1, 9, -1, 9, -1,
+        4, -1, 4, -1, 4, -1, 4, -1, 9, -1, 9, -1, 9, -1, 9, -1);
+    const __m256i lsbShift = _mm256_setr_epi16(
+        64, 16, 4, 1, 64, 16, 4, 1, 64, 16, 4, 1, 64, 16, 4, 1);
+    const __m256i lsbMask = _mm256_set1_epi16(3);
+    const size_t rowBytes = raw10RowBytes(width);
+    
+    uint32_t x = 0;
+    size_t offset = 0;
+    for (; x + 16 <= width && offset + 26 <= rowBytes; x += 16, offset += 20) {
+        __m256i in = loadLanes(packed + offset, packed + offset + 10);
+        __m256i msb = _mm256_slli_epi16(_mm256_shuffle_epi8(in, msbShuffle), 2);
+        __m256i lsb = _mm256_and_si256(
+            _mm256_srli_epi16(
+                _mm256_mullo_epi16(_mm256_shuffle_epi8(in, lsbShuffle), lsbShift), 6),
+            lsbMask);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(samples + x), _mm256_or_si256(msb, lsb));
+    }
+    unpackRaw10Scalar(packed + offset, samples + x, width - x);
+}
+
+// 16 pixels (eight groups) per step; reads 28 bytes
+__attribute__((target("avx2")))
+void unpackRaw12Avx2(const uint8_t* packed, uint16_t* samples, uint32_t width) {
+    const __m256i msbShuffle = _mm256_setr_epi8(
+        0, -1, 1, -1, 3, -1, 4, -1, 6, -1, 7, -1, 9, -1, 10, -1,
+        0, -1, 1, -1, 3, -1, 4, -1, 6, -1, 7, -1, 9, -1, 10, -1);
+    const __m256i lsbShuffle = _mm256_setr_epi8(
+        2, -1, 2, -1, 5, -1, 5, -1, 8, -1, 8, -1, 11, -1, 11, -1,
+        2, -1, 2, -1, 5, -1, 5, -1, 8, -1, 8, -1, 11, -1, 11, -1);
+    const __m256i lsbShift = _mm256_setr_epi16(
+        16, 1, 16, 1, 16, 1, 16, 1, 16, 1, 16, 1, 16, 1, 16, 1);
+    const __m256i lsbMask = _mm256_set1_epi16(0xF);
+    const size_t rowBytes = raw12RowBytes(width);
+    
+    uint32_t x = 0;
+    size_t offset = 0;
+    for (; x + 16 <= width && offset + 28 <= rowBytes; x += 16, offset += 24) {
+        __m256i in = loadLanes(packed + offset, packed + offset + 12);
+        __m256i msb = _mm256_slli_epi16(_mm256_shuffle_epi8(in, msbShuffle), 4);
+        __m256i lsb = _mm256_and_si256(
+            _mm256_srli_epi16(
+                _mm256_mullo_epi16(_mm256_shuffle_epi8(in, lsbShuffle), lsbShift), 4),
+            lsbMask);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(samples + x), _mm256_or_si256(msb, lsb));
+    }
+    unpackRaw12Scalar(packed + offset, samples + x, width - x);
+}
+
+// 16 pixels to 20 bytes per step
+__attribute__((target("avx2")))
+void packRaw10Avx2(const uint16_t* samples, uint8_t* packed, uint32_t width) {
+    const __m256i sampleMask = _mm256_set1_epi16(0x3FF);
+    const __m256i lsbMask = _mm256_set1_epi16(3);
+    const __m256i lsbWeight = _mm256_setr_epi16(
+        1, 4, 16, 64, 1, 4, 16, 64, 1, 4, 16, 64, 1, 4, 16, 64);
+    const __m256i ones = _mm256_set1_epi16(1);
+    const __m256i order = _mm256_setr_epi8(
+        0, 1, 2, 3, 8, 4, 5, 6, 7, 9, -1, -1, -1, -1, -1, -1,
+        0, 1, 2, 3, 8, 4, 5, 6, 7, 9, -1, -1, -1, -1, -1, -1);
+    
+    uint32_t x = 0;
+    uint8_t* out = packed;
+    for (; x + 16 <= width; x += 16, out += 20) {
+        __m256i v = _mm256_and_si256(
+            _mm256_loadu_si256(reinterpret_cast<const __m256i*>(samples + x)), sampleMask);
+        __m256i msb = _mm256_srli_epi16(v, 2);
+        __m256i lsb = _mm256_madd_epi16(
+            _mm256_mullo_epi16(_mm256_and_si256(v, lsbMask), lsbWeight), ones);
+        lsb = _mm256_hadd_epi32(lsb, lsb);
+        
+        __m256i bytes = _mm256_shuffle_epi8(
+            _mm256_packus_epi16(msb, _mm256_packus_epi32(lsb, lsb)), order);
+        
+        alignas(32) uint8_t lanes[32];
+        _mm256_store_si256(reinterpret_cast<__m256i*>(lanes), bytes);
+        std::memcpy(out, lanes, 10);
+        std::memcpy(out + 10, lanes + 16, 10);
+    }
+    packRaw10Scalar(samples + x, out, width - x);
+}
+
+// 16 pixels to 24 bytes per step
+__attribute__((target("avx2")))
+void packRaw12Avx2(const uint16_t* samples, uint8_t* packed, uint32_t width) {
+    const __m256i sampleMask = _mm256_set1_epi16(0xFFF);
+    const __m256i lsbMask = _mm256_set1_epi16(0xF);
+    const __m256i lsbWeight = _mm256_setr_epi16(
+        1, 16, 1, 16, 1, 16, 1, 16, 1, 16, 1, 16, 1, 16, 1, 16);
+    const __m256i ones = _mm256_set1_epi16(1);
+    const __m256i order = _mm256_setr_epi8(
+        0, 1, 8, 2, 3, 9, 4, 5, 10, 6, 7, 11, -1, -1, -1, -1,
+        0, 1, 8, 2, 3, 9, 4, 5, 10, 6, 7, 11, -1, -1, -1, -1);
+    
+    uint32_t x = 0;
+    uint8_t* out = packed;
+    for (; x + 16 <= width; x += 16, out += 24) {
+        __m256i v = _mm256_and_si256(
+            _mm256_loadu_si256(reinterpret_cast<const __m256i*>(samples + x)), sampleMask);
+        __m256i msb = _mm256_srli_epi16(v, 4);
+        __m256i lsb = _mm256_madd_epi16(
+            _mm256_mullo_epi16(_mm256_and_si256(v, lsbMask), lsbWeight), ones);
+        
+        __m256i bytes = _mm256_shuffle_epi8(
+            _mm256_packus_epi16(msb, _mm256_packus_epi32(lsb, lsb)), order);
+        
+        alignas(32) uint8_t lanes[32];
+        _mm256_store_si256(reinterpret_cast<__m256i*>(lanes), bytes);
+        std::memcpy(out, lanes, 12);
+        std::memcpy(out + 12, lanes + 16, 12);
+    }
+    packRaw12Scalar(samples + x, out, width - x);
+}
+
+} // namespace
+
+const RawKernels& getSse41RawKernels() {
+    static const RawKernels sse41 = {
+        unpackRaw10Sse41,
+        unpackRaw12Sse41,
+        packRaw10Sse41,
+        packRaw12Sse41
+    };
+    return sse41;
+}
+
+const RawKernels& getAvx2RawKernels() {
+    static const RawKernels avx2 = {
+        unpackRaw10Avx2,
+        unpackRaw12Avx2,
+        packRaw10Avx2,
+        packRaw12Avx2
+    };
+    return avx2;
+}
+
+} // namespace kernels
+} // namespace graphics
+} // namespace android
+
+#endif // __x86_64__ || __i386__
@@ -0,0 +1,59 @@
+/**
+ * @file ResizeKernels.h
+ * @brief Internal row kernel tables for BufferMapper::resize()
+ * 
+ * Rows are runs of 8-bit samples with 1, 2 or 4 interleaved channels.
+ * Vertical passes are channel-agnostic; the exact 2x/4x box kernels
+ * pair up whole pixels. SIMD variants finish ragged tails in scalar.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace android {
+namespace graphics {
+namespace kernels {
+
+/// out = (r0 * (256 - weight) + r1 * weight + 128) >> 8, weight in [0, 256]
+using BlendRowsFn = void (*)(
+    const uint8_t* r0, const uint8_t* r1, uint8_t* out, size_t bytes, uint32_t weight);
+
+/// acc[i] += row[i]
+using AccumulateRowFn = void (*)(const uint8_t* row, uint32_t* acc, size_t bytes);
+
+/// Exact 2x2 box average: out = (sum of 4 + 2) >> 2
+using Downscale2xFn = void (*)(
+    const uint8_t* r0, const uint8_t* r1, uint8_t* out, uint32_t dstWidth, uint32_t channels);
+
+/// Exact 4x4 box average: out = (sum of 16 + 8) >> 4
+using Downscale4xFn = void (*)(
+    const uint8_t* const* rows, uint8_t* out, uint32_t dstWidth, uint32_t channels);
+
+struct ResizeKernels {
+    BlendRowsFn blendRows;
+    AccumulateRowFn accumulateRow;
+    Downscale2xFn downscale2x;
+    Downscale4xFn downscale4x;
+};
+
+// Scalar reference kernels (also used for SIMD tails)
+void blendRowsScalar(
+    const uint8_t* r0, const uint8_t* r1, uint8_t* out, size_t bytes, uint32_t weight);
+void accumulateRowScalar(const uint8_t* row, uint32_t* acc, size_t bytes);
+void downscale2xScalar(
+    const uint8_t* r0, const uint8_t* r1, uint8_t* out, uint32_t dstWidth, uint32_t channels);
+void downscale4xScalar(
+    const uint8_t* const* rows, uint8_t* out, uint32_t dstWidth, uint32_t channels);
+
+const ResizeKernels& getScalarResizeKernels();
+
+#if defined(__x86_64__) || defined(__i386__)
+const ResizeKernels& getSse41ResizeKernels();
+const ResizeKernels& getAvx2ResizeKernels();
+#endif
+
+} // namespace kernels
+} // namespace graphics
+} // namespace android
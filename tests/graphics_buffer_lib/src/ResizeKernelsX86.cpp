@@ -0,0 +1,332 @@
+/**
+ * @file ResizeKernelsX86.cpp
+ * @brief SSE4.1 and AVX2 kernels for BufferMapper::resize()
+ * 
+ * The exact box kernels widen to 16 bits, sum rows vertically, then add
+ * horizontally adjacent pixels by splitting lanes on pixel parity
+ * (phaddw for 1 channel, 32-bit shuffles for 2, 64-bit unpacks for 4).
+ */
+
+#if defined(__x86_64__) || defined(__i386__)
+
+#include "ResizeKernels.h"
+#include <immintrin.h>
+
+namespace android {
+namespace graphics {
+namespace kernels {
+
+namespace {
+
+// ============================================================================
+// SSE4.1
+// ============================================================================
+
+// Sum horizontally adjacent pixels of lo followed by hi
+template <uint32_t C>
+__attribute__((target("sse4.1")))
+inline __m128i pairSum(__m128i lo, __m128i hi) {
+    if (C == 1) {
+        return _mm_hadd_epi16(lo, hi);
+    } else if (C == 2) {
+        __m128 even = _mm_shuffle_ps(_mm_castsi128_ps(lo), _mm_castsi128_ps(hi),
+                                     _MM_SHUFFLE(2, 0, 2, 0));
+        __m128 odd = _mm_shuffle_ps(_mm_castsi128_ps(lo), _mm_castsi128_ps(hi),
+                                    _MM_SHUFFLE(3, 1, 3, 1));
+        return _mm_add_epi16(_mm_castps_si128(even), _mm_castps_si128(odd));
+    } else {
+        return _mm_add_epi16(_mm_unpacklo_epi64(lo, hi), _mm_unpackhi_epi64(lo, hi));
+    }
+}
+
+__attribute__((target("sse4.1")))
+void blendRowsSse41(
+    const uint8_t* r0, const uint8_t* r1, uint8_t* out, size_t bytes, uint32_t weight
+) {
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i w0 = _mm_set1_epi16(static_cast<int16_t>(256 - weight));
+    const __m128i w1 = _mm_set1_epi16(static_cast<int16_t>(weight));
+    const __m128i rounding = _mm_set1_epi16(128);
+    
+    size_t i = 0;
+    for (; i + 16 <= bytes; i += 16) {
+        __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(r0 + i));
+        __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(r1 + i));
+        
+        __m128i lo = _mm_add_epi16(
+            _mm_add_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(a, zero), w0),
+                          _mm_mullo_epi16(_mm_unpacklo_epi8(b, zero), w1)),
+            rounding);
+        __m128i hi = _mm_add_epi16(
+            _mm_add_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(a, zero), w0),
+                          _mm_mullo_epi16(_mm_unpackhi_epi8(b, zero), w1)),
+            rounding);
+        
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i),
+                         _mm_packus_epi16(_mm_srli_epi16(lo, 8), _mm_srli_epi16(hi, 8)));
+    }
+    blendRowsScalar(r0 + i, r1 + i, out + i, bytes - i, weight);
+}
+
+__attribute__((target("sse4.1")))
+void accumulateRowSse41(const uint8_t* row, uint32_t* acc, size_t bytes) {
+    size_t i = 0;
+    for (; i + 4 <= bytes; i += 4) {
+        int32_t packed;
+        __builtin_memcpy(&packed, row + i, sizeof(packed));
+        __m128i sum = _mm_add_epi32(
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(acc + i)),
+            _mm_cvtepu8_epi32(_mm_cvtsi32_si128(packed)));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(acc + i), sum);
+    }
+    accumulateRowScalar(row + i, acc + i, bytes - i);
+}
+
+// 16 source bytes per row to 8 output bytes per step
+template <uint32_t C>
+__attribute__((target("sse4.1")))
+void downscale2xSse41Impl(const uint8_t* r0, const uint8_t* r1, uint8_t* out, uint32_t dstWidth) {
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i rounding = _mm_set1_epi16(2);
+    const size_t dstBytes = static_cast<size_t>(dstWidth) * C;
+    
+    size_t i = 0;
+    for (; i + 8 <= dstBytes; i += 8) {
+        __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(r0 + 2 * i));
+        __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(r1 + 2 * i));
+        __m128i lo = _mm_add_epi16(_mm_unpacklo_epi8(a, zero), _mm_unpacklo_epi8(b, zero));
+        __m128i hi = _mm_add_epi16(_mm_unpackhi_epi8(a, zero), _mm_unpackhi_epi8(b, zero));
+        
+        __m128i avg = _mm_srli_epi16(_mm_add_epi16(pairSum<C>(lo, hi), rounding), 2);
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(out + i), _mm_packus_epi16(avg, avg));
+    }
+    downscale2xScalar(r0 + 2 * i, r1 + 2 * i, out + i, static_cast<uint32_t>((dstBytes - i) / C), C);
+}
+
+// 32 source bytes per row to 8 output bytes per step
+template <uint32_t C>
+__attribute__((target("sse4.1")))
+void downscale4xSse41Impl(const uint8_t* const* rows, uint8_t* out, uint32_t dstWidth) {
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i rounding = _mm_set1_epi16(8);
+    const size_t dstBytes = static_cast<size_t>(dstWidth) * C;
+    
+    size_t i = 0;
+    for (; i + 8 <= dstBytes; i += 8) {
+        __m128i pairs[2];
+        for (int half = 0; half < 2; ++half) {
+            __m128i lo = zero;
+            __m128i hi = zero;
+            for (int r = 0; r < 4; ++r) {
+                __m128i v = _mm_loadu_si128(
+                    reinterpret_cast<const __m128i*>(rows[r] + 4 * i + 16 * half));
+                lo = _mm_add_epi16(lo, _mm_unpacklo_epi8(v, zero));
+                hi = _mm_add_epi16(hi, _mm_unpackhi_epi8(v, zero));
+            }
+            pairs[half] = pairSum<C>(lo, hi);
+        }
+        
+        __m128i avg = _mm_srli_epi16(
+            _mm_add_epi16(pairSum<C>(pairs[0], pairs[1]), rounding), 4);
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(out + i), _mm_packus_epi16(avg, avg));
+    }
+    
+    const uint8_t* tail[4] = {rows[0] + 4 * i, rows[1] + 4 * i, rows[2] + 4 * i, rows[3] + 4 * i};
+    downscale4xScalar(tail, out + i, static_cast<uint32_t>((dstBytes - i) / C), C);
+}
+
+void downscale2xSse41(
+    const uint8_t* r0, const uint8_t* r1, uint8_t* out, uint32_t dstWidth, uint32_t channels
+) {
+    switch (channels) {
+        case 1: downscale2xSse41Impl<1>(r0, r1, out, dstWidth); break;
+        case 2: downscale2xSse41Impl<2>(r0, r1, out, dstWidth); break;
+        case 4: downscale2xSse41Impl<4>(r0, r1, out, dstWidth); break;
+        default: downscale2xScalar(r0, r1, out, dstWidth, channels); break;
+    }
+}
+
+void downscale4xSse41(
+    const uint8_t* const* rows, uint8_t* out, uint32_t dstWidth, uint32_t channels
+) {
+    switch (channels) {
+        case 1: downscale4xSse41Impl<1>(rows, out, dstWidth); break;
+        case 2: downscale4xSse41Impl<2>(rows, out, dstWidth); break;
+        case 4: downscale4xSse41Impl<4>(rows, out, dstWidth); break;
+        default: downscale4xScalar(rows, out, dstWidth, channels); break;
+    }
+}
+
+// ============================================================================
+// AVX2 (per-lane versions of the SSE4.1 steps, reordered on store)
+// ============================================================================
+
+template <uint32_t C>
+__attribute__((target("avx2")))
+inline __m256i pairSum256(__m256i lo, __m256i hi) {
+    if (C == 1) {
+        return _mm256_hadd_epi16(lo, hi);
+    } else if (C == 2) {
+        __m256 even = _mm256_shuffle_ps(_mm256_castsi256_ps(lo), _mm256_castsi256_ps(hi),
+                                        _MM_SHUFFLE(2, 0, 2, 0));
+        __m256 odd = _mm256_shuffle_ps(_mm256_castsi256_ps(lo), _mm256_castsi256_ps(hi),
+                                       _MM_SHUFFLE(3, 1, 3, 1));
+        return _mm256_add_epi16(_mm256_castps_si256(even), _mm256_castps_si256(odd));
+    } else {
+        return _mm256_add_epi16(_mm256_unpacklo_epi64(lo, hi), _mm256_unpackhi_epi64(lo, hi));
+    }
+}
+
+__attribute__((target("avx2")))
+void blendRowsAvx2(
+    const uint8_t* r0, const uint8_t* r1, uint8_t* out, size_t bytes, uint32_t weight
+) {
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i w0 = _mm256_set1_epi16(static_cast<int16_t>(256 - weight));
+    const __m256i w1 = _mm256_set1_epi16(static_cast<int16_t>(weight));
+    const __m256i rounding = _mm256_set1_epi16(128);
+    
+    size_t i = 0;
+    for (; i + 32 <= bytes; i += 32) {
+        __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(r0 + i));
+        __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(r1 + i));
+        
+        __m256i lo = _mm256_add_epi16(
+            _mm256_add_epi16(_mm256_mullo_epi16(_mm256_unpacklo_epi8(a, zero), w0),
+                             _mm256_mullo_epi16(_mm256_unpacklo_epi8(b, zero), w1)),
+            rounding);
+        __m256i hi = _mm256_add_epi16(
+            _mm256_add_epi16(_mm256_mullo_epi16(_mm256_unpackhi_epi8(a, zero), w0),
+                             _mm256_mullo_epi16(_mm256_unpackhi_epi8(b, zero), w1)),
+            rounding);
+        
+        // Per-lane unpack and pack cancel out, so bytes stay in order
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i),
+                            _mm256_packus_epi16(_mm256_srli_epi16(lo, 8),
+                                                _mm256_srli_epi16(hi, 8)));
+    }
+    blendRowsScalar(r0 + i, r1 + i, out + i, bytes - i, weight);
+}
+
+__attribute__((target("avx2")))
+void accumulateRowAvx2(const uint8_t* row, uint32_t* acc, size_t bytes) {
+    size_t i = 0;
+    for (; i + 8 <= bytes; i += 8) {
+        __m256i sum = _mm256_add_epi32(
+            _mm256_loadu_si256(reinterpret_cast<const __m256i*>(acc + i)),
+            _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(row + i))));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(acc + i), sum);
+    }
+    accumulateRowScalar(row + i, acc + i, bytes - i);
+}
+
+// 32 source bytes per row to 16 output bytes per step
+template <uint32_t C>
+__attribute__((target("avx2")))
+void downscale2xAvx2Impl(const uint8_t* r0, const uint8_t* r1, uint8_t* out, uint32_t dstWidth) {
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i rounding = _mm256_set1_epi16(2);
+    const size_t dstBytes = static_cast<size_t>(dstWidth) * C;
+    
+    size_t i = 0;
+    for (; i + 16 <= dstBytes; i += 16) {
+        __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(r0 + 2 * i));
+        __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(r1 + 2 * i));
+        __m256i lo = _mm256_add_epi16(_mm256_unpacklo_epi8(a, zero), _mm256_unpacklo_epi8(b, zero));
+        __m256i hi = _mm256_add_epi16(_mm256_unpackhi_epi8(a, zero), _mm256_unpackhi_epi8(b, zero));
+        
+        __m256i avg = _mm256_srli_epi16(_mm256_add_epi16(pairSum256<C>(lo, hi), rounding), 2);
+        
+        // Each lane produced 8 bytes in its low quadword
+        __m256i packed = _mm256_permute4x64_epi64(
+            _mm256_packus_epi16(avg, avg), _MM_SHUFFLE(3, 1, 2, 0));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm256_castsi256_si128(packed));
+    }
+    downscale2xScalar(r0 + 2 * i, r1 + 2 * i, out + i, static_cast<uint32_t>((dstBytes - i) / C), C);
+}
+
+// 64 source bytes per row to 16 output bytes per step
+template <uint32_t C>
+__attribute__((target("avx2")))
+void downscale4xAvx2Impl(const uint8_t* const* rows, uint8_t* out, uint32_t dstWidth) {
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i rounding = _mm256_set1_epi16(8);
+    const __m256i order = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+    const size_t dstBytes = static_cast<size_t>(dstWidth) * C;
+    
+    size_t i = 0;
+    for (; i + 16 <= dstBytes; i += 16) {
+        __m256i pairs[2];
+        for (int half = 0; half < 2; ++half) {
+            __m256i lo = zero;
+            __m256i hi = zero;
+            for (int r = 0; r < 4; ++r) {
+                __m256i v = _mm256_loadu_si256(
+                    reinterpret_cast<const __m256i*>(rows[r] + 4 * i + 32 * half));
+                lo = _mm256_add_epi16(lo, _mm256_unpacklo_epi8(v, zero));
+                hi = _mm256_add_epi16(hi, _mm256_unpackhi_epi8(v, zero));
+            }
+            pairs[half] = pairSum256<C>(lo, hi);
+        }
+        
+        __m256i avg = _mm256_srli_epi16(
+            _mm256_add_epi16(pairSum256<C>(pairs[0], pairs[1]), rounding), 4);
+        
+        // Lanes hold source quarters {0, 2} and {1, 3}; interleave dwords back
+        __m256i packed = _mm256_permutevar8x32_epi32(_mm256_packus_epi16(avg, avg), order);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm256_castsi256_si128(packed));
+    }
+    
+    const uint8_t* tail[4] = {rows[0] + 4 * i, rows[1] + 4 * i, rows[2] + 4 * i, rows[3] + 4 * i};
+    downscale4xScalar(tail, out + i, static_cast<uint32_t>((dstBytes - i) / C), C);
+}
+
+void downscale2xAvx2(
+    const uint8_t* r0, const uint8_t* r1, uint8_t* out, uint32_t dstWidth, uint32_t channels
+) {
+    switch (channels) {
+        case 1: downscale2xAvx2Impl<1>(r0, r1, out, dstWidth); break;
+        case 2: downscale2xAvx2Impl<2>(r0, r1, out, dstWidth); break;
+        case 4: downscale2xAvx2Impl<4>(r0, r1, out, dstWidth); break;
+        default: downscale2xScalar(r0, r1, out, dstWidth, channels); break;
+    }
+}
+
+void downscale4xAvx2(
+    const uint8_t* const* rows, uint8_t* out, uint32_t dstWidth, uint32_t channels
+) {
+    switch (channels) {
+        case 1: downscale4xAvx2Impl<1>(rows, out, dstWidth); break;
+        case 2: downscale4xAvx2Impl<2>(rows, out, dstWidth); break;
+        case 4: downscale4xAvx2Impl<4>(rows, out, dstWidth); break;
+        default: downscale4xScalar(rows, out, dstWidth, channels); break;
+    }
+}
+
+} // namespace
+
+const ResizeKernels& getSse41ResizeKernels() {
+    static const ResizeKernels sse41 = {
+        blendRowsSse41,
+        accumulateRowSse41,
+        downscale2xSse41,
+        downscale4xSse41
+    };
+    return sse41;
+}
+
+const ResizeKernels& getAvx2ResizeKernels() {
+    static const ResizeKernels avx2 = {
+        blendRowsAvx2,
+        accumulateRowAvx2,
+        downscale2xAvx2,
+        downscale4xAvx2
+    };
+    return avx2;
+}
+
+} // namespace kernels
+} // namespace graphics
+} // namespace android
+
+#endif // __x86_64__ || __i386__
@@ -0,0 +1,60 @@
+/**
+ * @file ValidateKernels.h
+ * @brief Internal kernel tables for BufferMapper::checksum() and diff()
+ * 
+ * CRC kernels update the raw (non-inverted) CRC32C register so rows can
+ * be chained; the public entry points apply the usual pre/post inversion.
+ * Diff kernels accumulate into DiffSums across calls.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace android {
+namespace graphics {
+namespace kernels {
+
+/// Castagnoli polynomial, bit-reflected
+constexpr uint32_t kCrc32cPolynomial = 0x82F63B78;
+
+/// Advance the raw CRC32C register over size bytes
+using Crc32cFn = uint32_t (*)(uint32_t crc, const uint8_t* data, size_t size);
+
+/**
+ * @brief Running totals for a diff
+ */
+struct DiffSums {
+    uint64_t sad = 0;
+    uint64_t sse = 0;
+    uint32_t maxDiff = 0;
+};
+
+/// Compare bytes 8-bit samples
+using DiffRow8Fn = void (*)(const uint8_t* a, const uint8_t* b, size_t bytes, DiffSums& sums);
+
+/// Compare count 16-bit samples
+using DiffRow16Fn = void (*)(const uint16_t* a, const uint16_t* b, size_t count, DiffSums& sums);
+
+struct DiffKernels {
+    DiffRow8Fn diffRow8;
+    DiffRow16Fn diffRow16;
+};
+
+// Scalar reference kernels (also used for SIMD tails)
+uint32_t crc32cScalar(uint32_t crc, const uint8_t* data, size_t size);
+void diffRow8Scalar(const uint8_t* a, const uint8_t* b, size_t bytes, DiffSums& sums);
+void diffRow16Scalar(const uint16_t* a, const uint16_t* b, size_t count, DiffSums& sums);
+
+const DiffKernels& getScalarDiffKernels();
+
+#if defined(__x86_64__) || defined(__i386__)
+uint32_t crc32cSse42(uint32_t crc, const uint8_t* data, size_t size);
+const DiffKernels& getSse41DiffKernels();
+const DiffKernels& getAvx2DiffKernels();
+#endif
+
+} // namespace kernels
+} // namespace graphics
+} // namespace android
@@ -0,0 +1,354 @@
+/**
+ * @file ValidateKernelsX86.cpp
+ * @brief SSE4.2 CRC32C and SSE4.1/AVX2 diff kernels
+ * 
+ * The crc32 instruction has a latency of three cycles but a throughput
+ * of one, so long runs are split into three interleaved streams whose
+ * registers are merged with a precomputed zero-extension operator.
+ */
+
+#if defined(__x86_64__) || defined(__i386__)
+
+#include "ValidateKernels.h"
+#include <immintrin.h>
+#include <algorithm>
+#include <cstring>
+
+namespace android {
+namespace graphics {
+namespace kernels {
+
+namespace {
+
+// ============================================================================
+// CRC32C
+// ============================================================================
+
+/// Bytes per stream in the three-way interleaved loop
+constexpr size_t kCrcBlock = 512;
+
+/**
+ * Lookup tables for the linear map "append kCrcBlock zero bytes" on the
+ * raw register, one table per register byte.
+ */
+struct CrcShiftTables {
+    uint32_t table[4][256];
+    
+    CrcShiftTables() {
+        uint32_t basis[32];
+        for (uint32_t bit = 0; bit < 32; ++bit) {
+            uint32_t crc = 1u << bit;
+            for (size_t i = 0; i < kCrcBlock; ++i) {
+                for (int k = 0; k < 8; ++k) {
+                    crc = (crc >> 1) ^ (kCrc32cPolynomial & (0u - (crc & 1)));
+                }
+            }
+            basis[bit] = crc;
+        }
+        
+        for (uint32_t k = 0; k < 4; ++k) {
+            for (uint32_t value = 0; value < 256; ++value) {
+                uint32_t shifted = 0;
+                for (uint32_t bit = 0; bit < 8; ++bit) {
+                    if (value & (1u << bit)) {
+                        shifted ^= basis[8 * k + bit];
+                    }
+                }
+                table[k][value] = shifted;
+            }
+        }
+    }
+    
+    uint32_t shift(uint32_t crc) const {
+        return table[0][crc & 0xFF] ^ table[1][(crc >> 8) & 0xFF] ^
+               table[2][(crc >> 16) & 0xFF] ^ table[3][crc >> 24];
+    }
+};
+
+const CrcShiftTables& getShiftTables() {
+    static const CrcShiftTables tables;
+    return tables;
+}
+
+#if defined(__x86_64__)
+using CrcWord = uint64_t;
+
+__attribute__((target("sse4.2")))
+inline uint64_t crcWord(uint64_t crc, const uint8_t* p) {
+    uint64_t word;
+    std::memcpy(&word, p, sizeof(word));
+    return _mm_crc32_u64(crc, word);
+}
+#else
+using CrcWord = uint32_t;
+
+__attribute__((target("sse4.2")))
+inline uint32_t crcWord(uint32_t crc, const uint8_t* p) {
+    uint32_t word;
+    std::memcpy(&word, p, sizeof(word));
+    return _mm_crc32_u32(crc, word);
+}
+#endif
+
+// ============================================================================
+// Horizontal reductions
+// ============================================================================
+
+__attribute__((target("sse4.1")))
+inline uint64_t sumEpi64(__m128i v) {
+    alignas(16) uint64_t lanes[2];
+    _mm_store_si128(reinterpret_cast<__m128i*>(lanes), v);
+    return lanes[0] + lanes[1];
+}
+
+__attribute__((target("sse4.1")))
+inline uint32_t maxEpu8(__m128i v) {
+    v = _mm_max_epu8(v, _mm_srli_si128(v, 8));
+    v = _mm_max_epu8(v, _mm_srli_si128(v, 4));
+    v = _mm_max_epu8(v, _mm_srli_si128(v, 2));
+    v = _mm_max_epu8(v, _mm_srli_si128(v, 1));
+    return static_cast<uint32_t>(_mm_extract_epi8(v, 0));
+}
+
+__attribute__((target("sse4.1")))
+inline uint32_t maxEpu16(__m128i v) {
+    v = _mm_max_epu16(v, _mm_srli_si128(v, 8));
+    v = _mm_max_epu16(v, _mm_srli_si128(v, 4));
+    v = _mm_max_epu16(v, _mm_srli_si128(v, 2));
+    return static_cast<uint32_t>(_mm_extract_epi16(v, 0));
+}
+
+// Widen 32-bit lanes and add them to two 64-bit lanes
+__attribute__((target("sse4.1")))
+inline __m128i addEpu32ToEpi64(__m128i acc, __m128i v) {
+    const __m128i zero = _mm_setzero_si128();
+    acc = _mm_add_epi64(acc, _mm_unpacklo_epi32(v, zero));
+    return _mm_add_epi64(acc, _mm_unpackhi_epi32(v, zero));
+}
+
+/// Iterations before 32-bit partial sums are widened (no overflow)
+constexpr size_t kFlushInterval = 4096;
+
+// ============================================================================
+// SSE4.1 diff
+// ============================================================================
+
+__attribute__((target("sse4.1")))
+void diffRow8Sse41(const uint8_t* a, const uint8_t* b, size_t bytes, DiffSums& sums) {
+    const __m128i zero = _mm_setzero_si128();
+    __m128i sad = zero;
+    __m128i sse = zero;
+    __m128i maxDiff = zero;
+    
+    size_t i = 0;
+    while (i + 16 <= bytes) {
+        // Each 32-bit lane gains at most 4 * 255^2 per iteration
+        __m128i squares = zero;
+        size_t end = std::min(bytes - 15, i + kFlushInterval * 16);
+        for (; i < end; i += 16) {
+            __m128i va = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i));
+            __m128i vb = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + i));
+            
+            sad = _mm_add_epi64(sad, _mm_sad_epu8(va, vb));
+            __m128i d = _mm_or_si128(_mm_subs_epu8(va, vb), _mm_subs_epu8(vb, va));
+            maxDiff = _mm_max_epu8(maxDiff, d);
+            
+            __m128i lo = _mm_unpacklo_epi8(d, zero);
+            __m128i hi = _mm_unpackhi_epi8(d, zero);
+            squares = _mm_add_epi32(squares, _mm_add_epi32(_mm_madd_epi16(lo, lo),
+                                                           _mm_madd_epi16(hi, hi)));
+        }
+        sse = addEpu32ToEpi64(sse, squares);
+    }
+    
+    sums.sad += sumEpi64(sad);
+    sums.sse += sumEpi64(sse);
+    sums.maxDiff = std::max(sums.maxDiff, maxEpu8(maxDiff));
+    diffRow8Scalar(a + i, b + i, bytes - i, sums);
+}
+
+__attribute__((target("sse4.1")))
+void diffRow16Sse41(const uint16_t* a, const uint16_t* b, size_t count, DiffSums& sums) {
+    const __m128i zero = _mm_setzero_si128();
+    __m128i sad = zero;
+    __m128i sse = zero;
+    __m128i maxDiff = zero;
+    
+    size_t i = 0;
+    while (i + 8 <= count) {
+        // Each 32-bit lane gains at most 2 * 65535 per iteration
+        __m128i partial = zero;
+        size_t end = std::min(count - 7, i + kFlushInterval * 8);
+        for (; i < end; i += 8) {
+            __m128i va = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i));
+            __m128i vb = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + i));
+            
+            __m128i d = _mm_sub_epi16(_mm_max_epu16(va, vb), _mm_min_epu16(va, vb));
+            maxDiff = _mm_max_epu16(maxDiff, d);
+            
+            __m128i lo = _mm_unpacklo_epi16(d, zero);
+            __m128i hi = _mm_unpackhi_epi16(d, zero);
+            partial = _mm_add_epi32(partial, _mm_add_epi32(lo, hi));
+            
+            // Squares need 32 bits each: multiply even and odd lanes apart
+            sse = _mm_add_epi64(sse, _mm_mul_epu32(lo, lo));
+            sse = _mm_add_epi64(sse, _mm_mul_epu32(hi, hi));
+            lo = _mm_srli_epi64(lo, 32);
+            hi = _mm_srli_epi64(hi, 32);
+            sse = _mm_add_epi64(sse, _mm_mul_epu32(lo, lo));
+            sse = _mm_add_epi64(sse, _mm_mul_epu32(hi, hi));
+        }
+        sad = addEpu32ToEpi64(sad, partial);
+    }
+    
+    sums.sad += sumEpi64(sad);
+    sums.sse += sumEpi64(sse);
+    sums.maxDiff = std::max(sums.maxDiff, maxEpu16(maxDiff));
+    diffRow16Scalar(a + i, b + i, count - i, sums);
+}
+
+// ============================================================================
+// AVX2 diff
+// ============================================================================
+
+__attribute__((target("avx2")))
+inline __m128i foldEpi64(__m256i v) {
+    return _mm_add_epi64(_mm256_castsi256_si128(v), _mm256_extracti128_si256(v, 1));
+}
+
+__attribute__((target("avx2")))
+inline __m256i addEpu32ToEpi64x4(__m256i acc, __m256i v) {
+    const __m256i zero = _mm256_setzero_si256();
+    acc = _mm256_add_epi64(acc, _mm256_unpacklo_epi32(v, zero));
+    return _mm256_add_epi64(acc, _mm256_unpackhi_epi32(v, zero));
+}
+
+__attribute__((target("avx2")))
+void diffRow8Avx2(const uint8_t* a, const uint8_t* b, size_t bytes, DiffSums& sums) {
+    const __m256i zero = _mm256_setzero_si256();
+    __m256i sad = zero;
+    __m256i sse = zero;
+    __m256i maxDiff = zero;
+    
+    size_t i = 0;
+    while (i + 32 <= bytes) {
+        __m256i squares = zero;
+        size_t end = std::min(bytes - 31, i + kFlushInterval * 32);
+        for (; i < end; i += 32) {
+            __m256i va = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i));
+            __m256i vb = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + i));
+            
+            sad = _mm256_add_epi64(sad, _mm256_sad_epu8(va, vb));
+            __m256i d = _mm256_or_si256(_mm256_subs_epu8(va, vb), _mm256_subs_epu8(vb, va));
+            maxDiff = _mm256_max_epu8(maxDiff, d);
+            
+            __m256i lo = _mm256_unpacklo_epi8(d, zero);
+            __m256i hi = _mm256_unpackhi_epi8(d, zero);
+            squares = _mm256_add_epi32(squares, _mm256_add_epi32(_mm256_madd_epi16(lo, lo),
+                                                                 _mm256_madd_epi16(hi, hi)));
+        }
+        sse = addEpu32ToEpi64x4(sse, squares);
+    }
+    
+    sums.sad += sumEpi64(foldEpi64(sad));
+    sums.sse += sumEpi64(foldEpi64(sse));
+    sums.maxDiff = std::max(sums.maxDiff, maxEpu8(_mm_max_epu8(
+        _mm256_castsi256_si128(maxDiff), _mm256_extracti128_si256(maxDiff, 1))));
+    diffRow8Scalar(a + i, b + i, bytes - i, sums);
+}
+
+__attribute__((target("avx2")))
+void diffRow16Avx2(const uint16_t* a, const uint16_t* b, size_t count, DiffSums& sums) {
+    const __m256i zero = _mm256_setzero_si256();
+    __m256i sad = zero;
+    __m256i sse = zero;
+    __m256i maxDiff = zero;
+    
+    size_t i = 0;
+    while (i + 16 <= count) {
+        __m256i partial = zero;
+        size_t end = std::min(count - 15, i + kFlushInterval * 16);
+        for (; i < end; i += 16) {
+            __m256i va = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i));
+            __m256i vb = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + i));
+            
+            __m256i d = _mm256_sub_epi16(_mm256_max_epu16(va, vb), _mm256_min_epu16(va, vb));
+            maxDiff = _mm256_max_epu16(maxDiff, d);
+            
+            __m256i lo = _mm256_unpacklo_epi16(d, zero);
+            __m256i hi = _mm256_unpackhi_epi16(d, zero);
+            partial = _mm256_add_epi32(partial, _mm256_add_epi32(lo, hi));
+            
+            sse = _mm256_add_epi64(sse, _mm256_mul_epu32(lo, lo));
+            sse = _mm256_add_epi64(sse, _mm256_mul_epu32(hi, hi));
+            lo = _mm256_srli_epi64(lo, 32);
+            hi = _mm256_srli_epi64(hi, 32);
+            sse = _mm256_add_epi64(sse, _mm256_mul_epu32(lo, lo));
+            sse = _mm256_add_epi64(sse, _mm256_mul_epu32(hi, hi));
+        }
+        sad = addEpu32ToEpi64x4(sad, partial);
+    }
+    
+    sums.sad += sumEpi64(foldEpi64(sad));
+    sums.sse += sumEpi64(foldEpi64(sse));
+    sums.maxDiff = std::max(sums.maxDiff, maxEpu16(_mm_max_epu16(
+        _mm256_castsi256_si128(maxDiff), _mm256_extracti128_si256(maxDiff, 1))));
+    diffRow16Scalar(a + i, b + i, count - i, sums);
+}
+
+} // namespace
+
+__attribute__((target("sse4.2")))
+uint32_t crc32cSse42(uint32_t crc, const uint8_t* data, size_t size) {
+    if (size >= 3 * kCrcBlock) {
+        const CrcShiftTables& tables = getShiftTables();
+        do {
+            CrcWord c0 = crc;
+            CrcWord c1 = 0;
+            CrcWord c2 = 0;
+            for (size_t i = 0; i < kCrcBlock; i += sizeof(CrcWord)) {
+                c0 = crcWord(c0, data + i);
+                c1 = crcWord(c1, data + kCrcBlock + i);
+                c2 = crcWord(c2, data + 2 * kCrcBlock + i);
+            }
+            
+            // crc(A || B) = shift(crc(A), |B|) ^ crc(0, B)
+            crc = tables.shift(static_cast<uint32_t>(c0)) ^ static_cast<uint32_t>(c1);
+            crc = tables.shift(crc) ^ static_cast<uint32_t>(c2);
+            data += 3 * kCrcBlock;
+            size -= 3 * kCrcBlock;
+        } while (size >= 3 * kCrcBlock);
+    }
+    
+    CrcWord word = crc;
+    for (; size >= sizeof(CrcWord); size -= sizeof(CrcWord), data += sizeof(CrcWord)) {
+        word = crcWord(word, data);
+    }
+    crc = static_cast<uint32_t>(word);
+    for (; size > 0; --size) {
+        crc = _mm_crc32_u8(crc, *data++);
+    }
+    return crc;
+}
+
+const DiffKernels& getSse41DiffKernels() {
+    static const DiffKernels sse41 = {
+        diffRow8Sse41,
+        diffRow16Sse41
+    };
+    return sse41;
+}
+
+const DiffKernels& getAvx2DiffKernels() {
+    static const DiffKernels avx2 = {
+        diffRow8Avx2,
+        diffRow16Avx2
+    };
+    return avx2;
+}
+
+} // namespace kernels
+} // namespace graphics
+} // namespace android
+
+#endif // __x86_64__ || __i386__
@@ -0,0 +1,162 @@
+/**
+ * @file WorkStealingPool.cpp
+ * @brief Implementation of WorkStealingPool class
+ */
+
+#include "WorkStealingPool.h"
+#include <algorithm>
+
+namespace android {
+namespace graphics {
+
+WorkStealingPool::WorkStealingPool(uint32_t threadCount) {
+    if (threadCount == 0) {
+        uint32_t cores = std::thread::hardware_concurrency();
+        threadCount = cores > 1 ? cores - 1 : 0;
+    }
+    
+    // One queue per worker plus one shared by calling threads
+    for (uint32_t i = 0; i <= threadCount; ++i) {
+        queues_.push_back(std::make_unique<Queue>());
+    }
+    
+    workers_.reserve(threadCount);
+    for (uint32_t i = 0; i < threadCount; ++i) {
+        workers_.emplace_back(&WorkStealingPool::workerLoop, this, i);
+    }
+}
+
+WorkStealingPool::~WorkStealingPool() {
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex_);
+        stopping_ = true;
+    }
+    wake_.notify_all();
+    
+    for (auto& worker : workers_) {
+        worker.join();
+    }
+}
+
+WorkStealingPool& WorkStealingPool::getShared() {
+    static WorkStealingPool shared;
+    return shared;
+}
+
+void WorkStealingPool::parallelFor(
+    uint32_t count,
+    const std::function<void(uint32_t index)>& fn
+) {
+    if (count == 0 || !fn) {
+        return;
+    }
+    
+    // Nothing to share: skip the queues entirely
+    if (count == 1 || workers_.empty()) {
+        for (uint32_t i = 0; i < count; ++i) {
+            fn(i);
+        }
+        return;
+    }
+    
+    Batch batch;
+    batch.fn = &fn;
+    batch.remaining.store(count);
+    
+    // Seed every queue with a contiguous run of indices
+    size_t queueCount = queues_.size();
+    for (size_t q = 0; q < queueCount; ++q) {
+        uint32_t begin = static_cast<uint32_t>(count * q / queueCount);
+        uint32_t end = static_cast<uint32_t>(count * (q + 1) / queueCount);
+        if (begin == end) {
+            continue;
+        }
+        
+        std::lock_guard<std::mutex> lock(queues_[q]->mutex);
+        for (uint32_t i = begin; i < end; ++i) {
+            queues_[q]->tasks.push_back(Task{&batch, i});
+        }
+    }
+    
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex_);
+        pending_.fetch_add(count);
+    }
+    wake_.notify_all();
+    
+    // Help out until this batch is done; callers own the last queue
+    size_t self = queueCount - 1;
+    Task task;
+    while (batch.remaining.load(std::memory_order_acquire) > 0) {
+        if (popLocal(self, task) || steal(self, task)) {
+            runTask(task);
+        } else {
+            std::unique_lock<std::mutex> lock(batch.mutex);
+            batch.done.wait(lock, [&batch] { return batch.remaining.load() == 0; });
+        }
+    }
+    
+    // Synchronize with the thread that finished the last task
+    std::lock_guard<std::mutex> lock(batch.mutex);
+}
+
+void WorkStealingPool::workerLoop(size_t self) {
+    Task task;
+    while (true) {
+        if (popLocal(self, task) || steal(self, task)) {
+            runTask(task);
+            continue;
+        }
+        
+        std::unique_lock<std::mutex> lock(sleepMutex_);
+        wake_.wait(lock, [this] { return stopping_ || pending_.load() > 0; });
+        if (stopping_ && pending_.load() == 0) {
+            return;
+        }
+    }
+}
+
+bool WorkStealingPool::popLocal(size_t self, Task& outTask) {
+    Queue& queue = *queues_[self];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    
+    if (queue.tasks.empty()) {
+        return false;
+    }
+    
+    // Owner works front to back through its run
+    outTask = queue.tasks.front();
+    queue.tasks.pop_front();
+    pending_.fetch_sub(1);
+    return true;
+}
+
+bool WorkStealingPool::steal(size_t self, Task& outTask) {
+    size_t queueCount = queues_.size();
+    for (size_t offset = 1; offset < queueCount; ++offset) {
+        Queue& victim = *queues_[(self + offset) % queueCount];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        
+        if (!victim.tasks.empty()) {
+            // Thieves take from the back, away from the owner
+            outTask = victim.tasks.back();
+            victim.tasks.pop_back();
+            pending_.fetch_sub(1);
+            return true;
+        }
+    }
+    return false;
+}
+
+void WorkStealingPool::runTask(const Task& task) {
+    Batch* batch = task.batch;
+    (*batch->fn)(task.index);
+    
+    std::lock_guard<std::mutex> lock(batch->mutex);
+    if (batch->remaining.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        batch->done.notify_all();
+    }
+}
+
+} // namespace graphics
+} // namespace android